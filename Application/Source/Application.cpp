@@ -10,6 +10,15 @@
 //Include the standard C++ headers
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
+
+#include "AssetRegistry.h"
+#include "AssetStreamer.h"
+#include "DynamicGeometry.h"
+#include "GeometryArena.h"
+#include "LoadTGA.h"
+#include "Mesh.h"
+#include "shader.hpp"
 
 GLFWwindow* m_window;
 const unsigned char FPS = 60; // FPS of this game
@@ -28,7 +37,6 @@ int Application::arcadeGameScore = 0;
 
 //sound variables
 Sound Application::soundManager;
-FMOD::Sound *Application::soundList[SOUND_NUM];
 
 bool Application::guardEvidences[4] = {false,false,false,false};
 bool Application::janitorEvidences[4] = { false,false,false,false };
@@ -61,6 +69,15 @@ static void resize_callback(GLFWwindow* window, int width, int height)
 	glViewport(0, 0, width, height);
 }
 
+//Exit and delete a scene, then free the shared assets no other scene still uses
+static void CloseScene(Scene*& scene)
+{
+	scene->Exit();
+	delete scene;
+	scene = nullptr;
+	AssetRegistry::ReleaseUnused();
+}
+
 void Application::HideCursor()
 {
 	glfwSetInputMode(m_window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -256,6 +273,8 @@ void Application::Init()
 		fprintf(stderr, "Error: %s\n", glewGetErrorString(err));
 		//return -1;
 	}
+	//ordinary draws read the identity as their instance matrix
+	Mesh::SetDefaultInstance();
 
 	//initialize callback with GLFW
 	glfwSetWindowSizeCallback(m_window, resize_callback);
@@ -266,6 +285,12 @@ void Application::Init()
 	roomState = 0;
 	skipIntro = false;
 	CanPause = true;
+
+	//load every sound once, nothing is read from disk when they play
+	soundManager.LoadSample(SOUND_MAINMENU, "Sound/MainMenu.wav", true);
+	soundManager.LoadSample(SOUND_FOOTSTEP, "Sound/Footstep.wav");
+	soundManager.LoadSample(SOUND_MINIGAME, "Sound/MiniGame.wav", true);
+	soundManager.LoadSample(SOUND_MAINGAME, "Sound/MainGame.wav", true);
 }
 
 void Application::Run()
@@ -279,11 +304,25 @@ void Application::Run()
 	sceneList[SCENE_ROOM] = nullptr;
 	sceneList[SCENE_GAMEOVER] = nullptr;
 	Scene* scene = nullptr;
+	Scene* loadingScene = nullptr;
 
 	m_timer.startTimer();    // Start timer to calculate how long it takes to render this frame
 	while (!glfwWindowShouldClose(m_window))
 	{
-		if (sceneState != STATE_RUN_SCENE)
+		if (sceneState == STATE_LOADING)
+		{
+			//Upload a slice of the streamed assets each frame, then Init from the warm registry
+			AssetStreamer::Update();
+			RenderLoadingScreen(AssetStreamer::GetProgress());
+			if (AssetStreamer::IsIdle())
+			{
+				loadingScene->Init();
+				scene = loadingScene;
+				loadingScene = nullptr;
+				sceneState = STATE_RUN_SCENE;
+			}
+		}
+		else if (sceneState != STATE_RUN_SCENE)
 		{
 			if((sceneState != STATE_MAINMENU_EXIT) && (sceneState != STATE_MAINMENU_INIT))
 			{
@@ -300,8 +339,7 @@ void Application::Run()
 						//Close Previous Scene
 						if (sceneList[SCENE_GAMEOVER] != nullptr)
 						{
-							delete sceneList[SCENE_GAMEOVER];
-							sceneList[SCENE_GAMEOVER] = nullptr;
+							CloseScene(sceneList[SCENE_GAMEOVER]);
 						}
 
 						sceneList[SCENE_MAINMENU] = new MainMenuScene();
@@ -318,9 +356,7 @@ void Application::Run()
 				{
 					if (sceneList[SCENE_MAINMENU] != nullptr)
 					{
-						sceneList[SCENE_MAINMENU]->Exit();
-						delete sceneList[SCENE_MAINMENU];
-						sceneList[SCENE_MAINMENU] = nullptr;
+						CloseScene(sceneList[SCENE_MAINMENU]);
 					}
 					sceneState = prevState;
 				}
@@ -331,14 +367,13 @@ void Application::Run()
 						//Close Previous Scene
 						if (sceneList[SCENE_CORRIDOR] != nullptr)
 						{
-							delete sceneList[SCENE_CORRIDOR];
-							sceneList[SCENE_CORRIDOR] = nullptr;
+							CloseScene(sceneList[SCENE_CORRIDOR]);
 						}
 
 						sceneList[SCENE_LOBBY] = new LobbyScene();
-						sceneList[SCENE_LOBBY]->Init();
-						scene = sceneList[SCENE_LOBBY];
-						sceneState = STATE_RUN_SCENE;
+						sceneList[SCENE_LOBBY]->Preload();
+						loadingScene = sceneList[SCENE_LOBBY];
+						sceneState = STATE_LOADING;
 					}
 					else 
 					{
@@ -367,9 +402,7 @@ void Application::Run()
 					{
 						SetResolution(prevWindowWidth, prevWindowHeight);
 
-						sceneList[SCENE_MINIGAME]->Exit();
-						delete sceneList[SCENE_MINIGAME];
-						sceneList[SCENE_MINIGAME] = nullptr;
+						CloseScene(sceneList[SCENE_MINIGAME]);
 
 						sceneState = STATE_LOBBY;
 
@@ -381,13 +414,12 @@ void Application::Run()
 						//Close Previous Scene
 						if (sceneList[SCENE_LOBBY] != nullptr)
 						{
-							delete sceneList[SCENE_LOBBY];
-							sceneList[SCENE_LOBBY] = nullptr;
+							CloseScene(sceneList[SCENE_LOBBY]);
 						}
 						sceneList[SCENE_CORRIDOR] = new CorridorScene();
-						sceneList[SCENE_CORRIDOR]->Init();
-						scene = sceneList[SCENE_CORRIDOR];
-						sceneState = STATE_RUN_SCENE;
+						sceneList[SCENE_CORRIDOR]->Preload();
+						loadingScene = sceneList[SCENE_CORRIDOR];
+						sceneState = STATE_LOADING;
 					}
 					else 
 					{
@@ -401,9 +433,9 @@ void Application::Run()
 					if (sceneList[SCENE_ROOM] == nullptr)
 					{
 						sceneList[SCENE_ROOM] = new RoomScene();
-						sceneList[SCENE_ROOM]->Init();
-						scene = sceneList[SCENE_ROOM];
-						sceneState = STATE_RUN_SCENE;
+						sceneList[SCENE_ROOM]->Preload();
+						loadingScene = sceneList[SCENE_ROOM];
+						sceneState = STATE_LOADING;
 					}
 					else
 					{
@@ -416,9 +448,7 @@ void Application::Run()
 				{
 					if (sceneList[SCENE_ROOM] != nullptr)
 					{
-						sceneList[SCENE_ROOM]->Exit();
-						delete sceneList[SCENE_ROOM];
-						sceneList[SCENE_ROOM] = nullptr;
+						CloseScene(sceneList[SCENE_ROOM]);
 
 						roomState = 0;
 						sceneState = STATE_CORRIDOR_INIT;
@@ -431,8 +461,7 @@ void Application::Run()
 					if (sceneList[SCENE_GAMEOVER] == nullptr)
 					{
 						if (sceneList[SCENE_LOBBY] != nullptr) {
-							delete sceneList[SCENE_LOBBY];
-							sceneList[SCENE_LOBBY] = nullptr;
+							CloseScene(sceneList[SCENE_LOBBY]);
 						}
 
 						sceneList[SCENE_GAMEOVER] = new GameEndScene();
@@ -452,8 +481,7 @@ void Application::Run()
 					if (sceneList[SCENE_GAMEOVER] == nullptr)
 					{
 						if (sceneList[SCENE_LOBBY] != nullptr) {
-							delete sceneList[SCENE_LOBBY];
-							sceneList[SCENE_LOBBY] = nullptr;
+							CloseScene(sceneList[SCENE_LOBBY]);
 						}
 
 						sceneList[SCENE_GAMEOVER] = new GameEndScene();
@@ -477,8 +505,7 @@ void Application::Run()
 					if (sceneList[SCENE_GAMEOVER] == nullptr)
 					{
 						if (sceneList[SCENE_LOBBY] != nullptr) {
-							delete sceneList[SCENE_LOBBY];
-							sceneList[SCENE_LOBBY] = nullptr;
+							CloseScene(sceneList[SCENE_LOBBY]);
 						}
 
 						sceneList[SCENE_GAMEOVER] = new GameEndScene();
@@ -519,14 +546,12 @@ void Application::Run()
 		glfwSwapBuffers(m_window);
 		//Get and organize events, like keyboard and mouse input, window resizing, etc...
 		glfwPollEvents();
+		soundManager.Update();
 		m_timer.waitUntil(frameTime);       // Frame rate limiter. Limits each frame to a specified time in ms.   
 
 	}
 
-	for (int i = 0; i < SOUND_NUM; ++i)
-	{
-		soundManager.ReleaseSound(soundList[i]);
-	}
+	soundManager.ReleaseSamples();
 
 	for (int i = 0; i < SCENE_NUM; ++i)
 	{
@@ -538,8 +563,46 @@ void Application::Run()
 	}
 }
 
+/******************************************************************************/
+/*!
+\brief
+Draw the loading screen: a slowly pulsing background and a progress bar, both
+drawn with scissored clears so no shader or mesh has to be loaded first
+
+\param progress - 0 to 1
+*/
+/******************************************************************************/
+void Application::RenderLoadingScreen(float progress)
+{
+	float pulse = 0.5f + 0.5f * sinf((float)glfwGetTime() * 3.f);
+	glClearColor(0.05f + 0.05f * pulse, 0.05f + 0.05f * pulse, 0.1f + 0.1f * pulse, 1.f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	int barWidth = (int)(m_width * 0.6f);
+	int barHeight = (int)(m_height * 0.03f) + 1;
+	int barX = ((int)m_width - barWidth) / 2;
+	int barY = (int)(m_height * 0.2f);
+
+	glEnable(GL_SCISSOR_TEST);
+	glScissor(barX, barY, barWidth, barHeight);
+	glClearColor(0.2f, 0.2f, 0.2f, 1.f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glScissor(barX, barY, (int)(barWidth * progress), barHeight);
+	glClearColor(0.85f, 0.85f, 0.85f, 1.f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glDisable(GL_SCISSOR_TEST);
+}
+
 void Application::Exit()
 {
+	//Free shared textures/meshes while the context still exists
+	AssetRegistry::Clear();
+	GeometryArena::Clear();
+	Mesh::ReleaseInstanceBuffer();
+	Mesh::ReleaseDefaultMaterials();
+	DynamicGeometry::Release();
+	ReleaseTGAUploadBuffer();
+	ClearShaderCache();
 	//Close OpenGL window and terminate GLFW
 	glfwDestroyWindow(m_window);
 	//Finalize and clean up GLFW
@@ -39,6 +39,7 @@ public:
 		STATE_ROOM_EXIT,
 		STATE_GAMEWIN,
 		STATE_GAMELOSE,
+		STATE_LOADING,
 	};
 
 	enum ROOM_STATE
@@ -118,9 +119,8 @@ public:
 	static bool EnoughEvidence(bool b[4]);
 	static void SetCanPause(bool isAble);
 
-	//sound manager
-	static Sound soundManager;	
-	static FMOD::Sound *soundList[SOUND_NUM];
+	//sound manager, samples are played by their SOUNDS id
+	static Sound soundManager;
 
 private:
 
@@ -135,6 +135,9 @@ private:
 	//some resolution variables for minigame
 	unsigned prevWindowWidth;
 	unsigned prevWindowHeight;
+
+	//loading screen shown while the AssetStreamer works
+	void RenderLoadingScreen(float progress);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,211 @@
+#include <GL\glew.h>
+
+#include "AssetRegistry.h"
+#include "LoadTGA.h"
+#include "Mesh.h"
+
+AssetRegistry::TextureMap AssetRegistry::textures;
+AssetRegistry::MeshMap AssetRegistry::meshes;
+std::unordered_map<unsigned, AssetRegistry::TextureMap::iterator> AssetRegistry::texturesByID;
+std::unordered_map<const Mesh*, AssetRegistry::MeshMap::iterator> AssetRegistry::meshesByPointer;
+
+/******************************************************************************/
+/*!
+\brief
+Normalize a path so different spellings of the same file share an entry:
+lower case, '\' becomes '/', and repeated separators are collapsed
+("Image//Front.tga" and "image\front.tga" both become "image/front.tga")
+*/
+/******************************************************************************/
+std::string AssetRegistry::MakeKey(const std::string& file_path)
+{
+	std::string key;
+	key.reserve(file_path.size());
+	for (unsigned i = 0; i < file_path.size(); ++i)
+	{
+		char c = file_path[i];
+		if (c == '\\')
+			c = '/';
+		else if (c >= 'A' && c <= 'Z')
+			c = c - 'A' + 'a';
+		if (c == '/' && !key.empty() && key[key.size() - 1] == '/')
+			continue;
+		key.push_back(c);
+	}
+	return key;
+}
+
+//Key of an OBJ + MTL pair, matching MeshBuilder::GenerateOBJMTL
+std::string AssetRegistry::MakeMeshKey(const std::string& file_path, const std::string& mtl_path)
+{
+	return MakeKey(file_path) + "|" + MakeKey(mtl_path);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Return the texture for a TGA file, decoding and uploading it on first use.
+Failed loads are not cached.
+
+\param file_path - path of the .tga file
+
+\return texture ID, 0 if the file could not be loaded
+*/
+/******************************************************************************/
+unsigned AssetRegistry::AcquireTexture(const std::string& file_path)
+{
+	std::string key = MakeKey(file_path);
+	TextureMap::iterator it = textures.find(key);
+	if (it != textures.end())
+	{
+		++it->second.refCount;
+		return it->second.textureID;
+	}
+
+	bool translucent = false;
+	GLuint textureID = LoadTGAFile(file_path.c_str(), translucent);
+	if (textureID == 0)
+		return 0;
+	TextureEntry entry = { textureID, 1, translucent };
+	texturesByID[textureID] = textures.insert(std::pair<std::string, TextureEntry>(key, entry)).first;
+	return textureID;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Drop one reference to a texture. IDs that did not come from the registry
+are ignored, since their owner is responsible for them.
+*/
+/******************************************************************************/
+void AssetRegistry::ReleaseTexture(unsigned textureID)
+{
+	std::unordered_map<unsigned, TextureMap::iterator>::iterator it = texturesByID.find(textureID);
+	if (it != texturesByID.end() && it->second->second.refCount > 0)
+		--it->second->second.refCount;
+}
+
+unsigned AssetRegistry::FindTexture(const std::string& key)
+{
+	TextureMap::iterator it = textures.find(key);
+	return it != textures.end() ? it->second.textureID : 0;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Register a texture uploaded elsewhere (e.g. by the AssetStreamer) under a key
+built with MakeKey. It starts with no references.
+
+\param translucent - whether any texel has alpha below 255
+*/
+/******************************************************************************/
+void AssetRegistry::AddTexture(const std::string& key, unsigned textureID, bool translucent)
+{
+	TextureEntry entry = { textureID, 0, translucent };
+	std::pair<TextureMap::iterator, bool> added = textures.insert(std::pair<std::string, TextureEntry>(key, entry));
+	if (added.second)
+		texturesByID[textureID] = added.first;
+}
+
+//Whether a registry texture needs blending; false for IDs from elsewhere
+bool AssetRegistry::IsTranslucent(unsigned textureID)
+{
+	std::unordered_map<unsigned, TextureMap::iterator>::iterator it = texturesByID.find(textureID);
+	return it != texturesByID.end() && it->second->second.translucent;
+}
+
+Mesh* AssetRegistry::FindMesh(const std::string& key)
+{
+	MeshMap::iterator it = meshes.find(key);
+	return it != meshes.end() ? it->second.mesh : nullptr;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Register a loaded mesh under a key built with MakeKey. The registry takes
+ownership; callers draw it through views created with Mesh(name, mesh).
+*/
+/******************************************************************************/
+void AssetRegistry::AddMesh(const std::string& key, Mesh* mesh)
+{
+	MeshEntry entry = { mesh, 0 };
+	std::pair<MeshMap::iterator, bool> added = meshes.insert(std::pair<std::string, MeshEntry>(key, entry));
+	if (added.second)
+		meshesByPointer[mesh] = added.first;
+}
+
+void AssetRegistry::AcquireMesh(const Mesh* mesh)
+{
+	std::unordered_map<const Mesh*, MeshMap::iterator>::iterator it = meshesByPointer.find(mesh);
+	if (it != meshesByPointer.end())
+		++it->second->second.refCount;
+}
+
+void AssetRegistry::ReleaseMesh(const Mesh* mesh)
+{
+	std::unordered_map<const Mesh*, MeshMap::iterator>::iterator it = meshesByPointer.find(mesh);
+	if (it != meshesByPointer.end() && it->second->second.refCount > 0)
+		--it->second->second.refCount;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Free every texture and mesh that no longer has any references. Called when a
+scene is closed, after its meshes have released theirs.
+*/
+/******************************************************************************/
+void AssetRegistry::ReleaseUnused()
+{
+	for (TextureMap::iterator it = textures.begin(); it != textures.end(); )
+	{
+		if (it->second.refCount == 0)
+		{
+			glDeleteTextures(1, &it->second.textureID);
+			texturesByID.erase(it->second.textureID);
+			it = textures.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+	for (MeshMap::iterator it = meshes.begin(); it != meshes.end(); )
+	{
+		if (it->second.refCount == 0)
+		{
+			meshesByPointer.erase(it->second.mesh);
+			delete it->second.mesh;
+			it = meshes.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+/******************************************************************************/
+/*!
+\brief
+Free everything regardless of references. Call before the GL context is
+destroyed; any mesh views still alive must not be rendered afterwards.
+*/
+/******************************************************************************/
+void AssetRegistry::Clear()
+{
+	for (TextureMap::iterator it = textures.begin(); it != textures.end(); ++it)
+	{
+		glDeleteTextures(1, &it->second.textureID);
+	}
+	textures.clear();
+	texturesByID.clear();
+	for (MeshMap::iterator it = meshes.begin(); it != meshes.end(); ++it)
+	{
+		delete it->second.mesh;
+	}
+	meshes.clear();
+	meshesByPointer.clear();
+}
@@ -0,0 +1,63 @@
+#ifndef ASSET_REGISTRY_H
+#define ASSET_REGISTRY_H
+
+#include <string>
+#include <map>
+#include <unordered_map>
+
+class Mesh;
+
+/******************************************************************************/
+/*!
+		Class AssetRegistry:
+\brief	Process-wide cache of textures and meshes keyed by normalized file
+		path, so an asset is decoded and uploaded once no matter how many
+		scenes ask for it. Entries are reference counted; an entry that drops
+		to zero references stays resident until ReleaseUnused() or Clear().
+		Entries are also indexed by texture ID and mesh, since meshes acquire
+		and release by those on every construction and destruction.
+*/
+/******************************************************************************/
+class AssetRegistry
+{
+public:
+	static std::string MakeKey(const std::string& file_path);
+	static std::string MakeMeshKey(const std::string& file_path, const std::string& mtl_path);
+
+	static unsigned AcquireTexture(const std::string& file_path);
+	static void ReleaseTexture(unsigned textureID);
+	static unsigned FindTexture(const std::string& key);
+	static void AddTexture(const std::string& key, unsigned textureID, bool translucent);
+	static bool IsTranslucent(unsigned textureID);
+
+	static Mesh* FindMesh(const std::string& key);
+	static void AddMesh(const std::string& key, Mesh* mesh);
+	static void AcquireMesh(const Mesh* mesh);
+	static void ReleaseMesh(const Mesh* mesh);
+
+	static void ReleaseUnused();
+	static void Clear();
+
+private:
+	struct TextureEntry
+	{
+		unsigned textureID;
+		unsigned refCount;
+		bool translucent;
+	};
+	struct MeshEntry
+	{
+		Mesh* mesh;
+		unsigned refCount;
+	};
+
+	typedef std::map<std::string, TextureEntry> TextureMap;
+	typedef std::map<std::string, MeshEntry> MeshMap;
+
+	static TextureMap textures;
+	static MeshMap meshes;
+	static std::unordered_map<unsigned, TextureMap::iterator> texturesByID;
+	static std::unordered_map<const Mesh*, MeshMap::iterator> meshesByPointer;
+};
+
+#endif
@@ -0,0 +1,153 @@
+#include <GL\glew.h>
+
+#include "AssetStreamer.h"
+#include "AssetRegistry.h"
+#include "ThreadPool.h"
+#include "MeshBuilder.h"
+#include "LoadTGA.h"
+#include "LoadDDS.h"
+
+struct AssetStreamer::Request
+{
+	enum TYPE
+	{
+		TYPE_TEXTURE,
+		TYPE_MESH,
+	};
+
+	TYPE type;
+	std::string key;
+	std::string path;
+	std::string mtlPath;
+	bool decoded;
+	bool compressed; //cooked DDS found, image is unused
+	DDSImage cookedImage;
+	TGAImage image;
+	MeshData mesh;
+};
+
+std::mutex AssetStreamer::readyMutex;
+std::deque<std::shared_ptr<AssetStreamer::Request>> AssetStreamer::ready;
+std::set<std::string> AssetStreamer::pending;
+unsigned AssetStreamer::requestedCount = 0;
+unsigned AssetStreamer::completedCount = 0;
+
+void AssetStreamer::RequestTexture(const std::string& file_path)
+{
+	std::string key = AssetRegistry::MakeKey(file_path);
+	if (AssetRegistry::FindTexture(key) != 0 || pending.count(key) > 0)
+		return;
+
+	std::shared_ptr<Request> request = std::make_shared<Request>();
+	request->type = Request::TYPE_TEXTURE;
+	request->key = key;
+	request->path = file_path;
+	Submit(request);
+}
+
+void AssetStreamer::RequestMesh(const std::string& file_path, const std::string& mtl_path)
+{
+	std::string key = AssetRegistry::MakeMeshKey(file_path, mtl_path);
+	if (AssetRegistry::FindMesh(key) != nullptr || pending.count(key) > 0)
+		return;
+
+	std::shared_ptr<Request> request = std::make_shared<Request>();
+	request->type = Request::TYPE_MESH;
+	request->key = key;
+	request->path = file_path;
+	request->mtlPath = mtl_path;
+	Submit(request);
+}
+
+void AssetStreamer::Submit(const std::shared_ptr<Request>& request)
+{
+	//start counting progress afresh for each new batch
+	if (pending.empty())
+		requestedCount = completedCount = 0;
+	pending.insert(request->key);
+	++requestedCount;
+
+	ThreadPool::GetInstance().Enqueue([request]()
+	{
+		if (request->type == Request::TYPE_TEXTURE)
+		{
+			request->compressed = DecodeDDS(GetDDSPath(request->path).c_str(), request->cookedImage);
+			request->decoded = request->compressed || DecodeTGA(request->path.c_str(), request->image);
+		}
+		else
+			request->decoded = MeshBuilder::LoadOBJMTLData(request->path, request->mtlPath, request->mesh);
+
+		std::lock_guard<std::mutex> lock(readyMutex);
+		ready.push_back(request);
+	});
+}
+
+//Upload one decoded request and return the number of bytes sent to the GPU
+size_t AssetStreamer::Upload(Request& request)
+{
+	if (!request.decoded)
+		return 0;
+
+	if (request.type == Request::TYPE_TEXTURE && request.compressed)
+	{
+		AssetRegistry::AddTexture(request.key, UploadDDS(request.cookedImage), IsTranslucentDDS(request.cookedImage));
+		return request.cookedImage.blocks.size();
+	}
+	if (request.type == Request::TYPE_TEXTURE)
+	{
+		AssetRegistry::AddTexture(request.key, UploadTGA(request.image), request.image.translucent);
+		return request.image.pixels.size();
+	}
+	AssetRegistry::AddMesh(request.key, MeshBuilder::GenerateMesh(request.path, request.mesh));
+	return request.mesh.vertices.size() + request.mesh.indices.size() * sizeof(unsigned);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Upload decoded assets until uploadBudget bytes have been sent this call. At
+least one asset is uploaded per call, so assets larger than the budget still
+get through. Main thread only.
+
+\param uploadBudget - bytes to upload before returning
+*/
+/******************************************************************************/
+void AssetStreamer::Update(size_t uploadBudget)
+{
+	size_t uploaded = 0;
+	while (uploaded < uploadBudget)
+	{
+		std::shared_ptr<Request> request;
+		{
+			std::lock_guard<std::mutex> lock(readyMutex);
+			if (ready.empty())
+				break;
+			request = ready.front();
+			ready.pop_front();
+		}
+
+		uploaded += Upload(*request);
+		pending.erase(request->key);
+		++completedCount;
+	}
+}
+
+bool AssetStreamer::IsIdle()
+{
+	return pending.empty();
+}
+
+/******************************************************************************/
+/*!
+\brief
+Fraction of the current batch of requests that has been uploaded
+
+\return 0 to 1, 1 when idle
+*/
+/******************************************************************************/
+float AssetStreamer::GetProgress()
+{
+	if (requestedCount == 0)
+		return 1.f;
+	return (float)completedCount / requestedCount;
+}
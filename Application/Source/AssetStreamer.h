@@ -0,0 +1,45 @@
+#ifndef ASSET_STREAMER_H
+#define ASSET_STREAMER_H
+
+#include <string>
+#include <deque>
+#include <set>
+#include <mutex>
+#include <memory>
+
+/******************************************************************************/
+/*!
+		Class AssetStreamer:
+\brief	Loads textures and OBJ + MTL meshes in the background. File I/O and
+		decoding run on the ThreadPool; the finished buffers wait in a queue
+		that Update() drains on the main thread, uploading a bounded number of
+		bytes per call and registering the results in the AssetRegistry.
+		Assets that are already registered or pending are not requested again.
+*/
+/******************************************************************************/
+class AssetStreamer
+{
+public:
+	static const size_t DEFAULT_UPLOAD_BUDGET = 4 * 1024 * 1024;
+
+	static void RequestTexture(const std::string& file_path);
+	static void RequestMesh(const std::string& file_path, const std::string& mtl_path);
+
+	static void Update(size_t uploadBudget = DEFAULT_UPLOAD_BUDGET);
+	static bool IsIdle();
+	static float GetProgress();
+
+private:
+	struct Request;
+
+	static void Submit(const std::shared_ptr<Request>& request);
+	static size_t Upload(Request& request);
+
+	static std::mutex readyMutex;
+	static std::deque<std::shared_ptr<Request>> ready; //decoded, waiting for upload
+	static std::set<std::string> pending; //main thread only
+	static unsigned requestedCount;
+	static unsigned completedCount;
+};
+
+#endif
@@ -0,0 +1,318 @@
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <cstring>
+
+#include <GL\glew.h>
+#include <GLFW/glfw3.h>
+
+#include "Benchmark.h"
+#include "LoadOBJ.h"
+#include "MeshBuilder.h"
+#include "MeshOptimizer.h"
+#include "GeometryArena.h"
+#include "shader.hpp"
+#include "timer.h"
+
+//Every OBJ/MTL pair loaded by the scenes
+static const char* benchmarkMeshes[][2] =
+{
+	{ "OBJ//dininghall_tables.obj", "OBJ//dininghall_tables.mtl" },
+	{ "OBJ//hotel_lobby.obj", "OBJ//hotel_lobby.mtl" },
+	{ "OBJ//ship_dininghall.obj", "OBJ//ship_dininghall.mtl" },
+	{ "OBJ//ship_corridor.obj", "OBJ//ship_corridor.mtl" },
+	{ "OBJ//ship_roomL.obj", "OBJ//ship_roomL.mtl" },
+	{ "OBJ//ship_roomR.obj", "OBJ//ship_roomR.mtl" },
+	{ "OBJ//ship_room1_furniture.obj", "OBJ//ship_room1_furniture.mtl" },
+	{ "OBJ//ship_room2_furniture.obj", "OBJ//ship_room2_furniture.mtl" },
+	{ "OBJ//arcade_machine.obj", "OBJ//arcade_machine.mtl" },
+	{ "OBJ//Gamer.obj", "OBJ//Gamer.mtl" },
+	{ "OBJ//Guard.obj", "OBJ//Guard.mtl" },
+	{ "OBJ//Janitor.obj", "OBJ//Janitor.mtl" },
+	{ "OBJ//Kid.obj", "OBJ//Kid.mtl" },
+	{ "OBJ//OldMan.obj", "OBJ//OldMan.mtl" },
+	{ "OBJ//officer_male.obj", "OBJ//officer_male.mtl" },
+	{ "OBJ//officer_female.obj", "OBJ//officer_female.mtl" },
+};
+
+static const int BENCHMARK_RUNS = 5;
+
+struct ReferenceVertex {
+	Position position;
+	TexCoord uv;
+	Vector3 normal;
+	bool operator<(const ReferenceVertex& that) const {
+		return memcmp((void*)this, (void*)&that, sizeof(ReferenceVertex)) > 0;
+	};
+};
+
+//The previous std::map based welder, kept only as a baseline to measure against
+static void IndexVBO_Reference(
+	std::vector<Position>& in_vertices,
+	std::vector<TexCoord>& in_uvs,
+	std::vector<Vector3>& in_normals,
+	std::vector<unsigned>& out_indices,
+	std::vector<Vertex>& out_vertices
+)
+{
+	std::map<ReferenceVertex, unsigned> vertexToOutIndex;
+	for (unsigned i = 0; i < in_vertices.size(); ++i)
+	{
+		ReferenceVertex packed = { in_vertices[i], in_uvs[i], in_normals[i] };
+		std::map<ReferenceVertex, unsigned>::iterator it = vertexToOutIndex.find(packed);
+		if (it != vertexToOutIndex.end())
+		{
+			out_indices.push_back(it->second);
+		}
+		else
+		{
+			Vertex v;
+			v.pos = in_vertices[i];
+			v.texCoord = in_uvs[i];
+			v.normal = in_normals[i];
+			out_vertices.push_back(v);
+			unsigned newIndex = (unsigned)out_vertices.size() - 1;
+			out_indices.push_back(newIndex);
+			vertexToOutIndex[packed] = newIndex;
+		}
+	}
+}
+
+/******************************************************************************/
+/*!
+\brief
+Time LoadOBJMTL, LoadOBJMTLParallel and both welders over every shipped
+level/character mesh. Each stage reports the best of BENCHMARK_RUNS runs in
+milliseconds. The welded mesh's ACMR is reported before and after the
+MeshBuilder::OptimizeMesh pass imports run on it.
+*/
+/******************************************************************************/
+void RunMeshLoadBenchmark()
+{
+	StopWatch timer;
+	double totalParse = 0, totalParallel = 0, totalReference = 0, totalHash = 0;
+
+	std::cout << std::left << std::setw(34) << "mesh"
+		<< std::right << std::setw(10) << "parse ms"
+		<< std::setw(10) << "mt ms"
+		<< std::setw(10) << "map ms"
+		<< std::setw(10) << "hash ms"
+		<< std::setw(9) << "speedup"
+		<< std::setw(10) << "vertices"
+		<< std::setw(14) << "acmr" << "\n";
+
+	for (unsigned m = 0; m < sizeof(benchmarkMeshes) / sizeof(benchmarkMeshes[0]); ++m)
+	{
+		double bestParse = 1e9, bestParallel = 1e9, bestReference = 1e9, bestHash = 1e9;
+		std::vector<Vertex> referenceVertices, hashVertices;
+		std::vector<unsigned> referenceIndices, hashIndices;
+		std::vector<Material> hashMaterials;
+		bool loaded = true, identical = true;
+
+		for (int run = 0; run < BENCHMARK_RUNS && loaded; ++run)
+		{
+			std::vector<Position> vertices;
+			std::vector<TexCoord> uvs;
+			std::vector<Vector3> normals;
+			std::vector<Material> materials;
+
+			timer.startTimer();
+			loaded = LoadOBJMTL(benchmarkMeshes[m][0], benchmarkMeshes[m][1], vertices, uvs, normals, materials);
+			bestParse = Math::Min(bestParse, timer.getElapsedTime());
+			if (!loaded)
+				break;
+
+			std::vector<Position> parallelVertices;
+			std::vector<TexCoord> parallelUVs;
+			std::vector<Vector3> parallelNormals;
+			std::vector<Material> parallelMaterials;
+			timer.startTimer();
+			LoadOBJMTLParallel(benchmarkMeshes[m][0], benchmarkMeshes[m][1], parallelVertices, parallelUVs, parallelNormals, parallelMaterials);
+			bestParallel = Math::Min(bestParallel, timer.getElapsedTime());
+			identical = identical && parallelVertices.size() == vertices.size() && parallelMaterials.size() == materials.size() &&
+				(vertices.empty() ||
+				(memcmp(&parallelVertices[0], &vertices[0], vertices.size() * sizeof(Position)) == 0 &&
+				memcmp(&parallelUVs[0], &uvs[0], uvs.size() * sizeof(TexCoord)) == 0 &&
+				memcmp(&parallelNormals[0], &normals[0], normals.size() * sizeof(Vector3)) == 0));
+			for (unsigned i = 0; identical && i < materials.size(); ++i)
+			{
+				identical = parallelMaterials[i].size == materials[i].size;
+			}
+
+			referenceVertices.clear();
+			referenceIndices.clear();
+			timer.startTimer();
+			IndexVBO_Reference(vertices, uvs, normals, referenceIndices, referenceVertices);
+			bestReference = Math::Min(bestReference, timer.getElapsedTime());
+
+			hashVertices.clear();
+			hashIndices.clear();
+			timer.startTimer();
+			IndexVBO(vertices, uvs, normals, hashIndices, hashVertices);
+			bestHash = Math::Min(bestHash, timer.getElapsedTime());
+			hashMaterials.swap(materials);
+		}
+
+		if (!loaded)
+		{
+			std::cout << std::left << std::setw(34) << benchmarkMeshes[m][0] << "skipped\n";
+			continue;
+		}
+		if (!identical)
+		{
+			std::cout << benchmarkMeshes[m][0] << ": parallel parse output differs from serial!\n";
+		}
+		if (referenceIndices != hashIndices || referenceVertices.size() != hashVertices.size())
+		{
+			std::cout << benchmarkMeshes[m][0] << ": hash welder output differs from reference!\n";
+		}
+
+		//post-transform cache misses per triangle of the full mesh as imports ship it; LODs are appended after it
+		size_t weldedVertexCount = hashVertices.size();
+		float acmrBefore = 0.f, acmrAfter = 0.f;
+		if (!hashIndices.empty())
+		{
+			unsigned indexCount = (unsigned)hashIndices.size();
+			acmrBefore = ComputeACMR(&hashIndices[0], indexCount, (unsigned)hashVertices.size());
+			std::vector<MeshLod> lods;
+			MeshBuilder::OptimizeMesh(hashVertices, hashIndices, hashMaterials, lods);
+			acmrAfter = ComputeACMR(&hashIndices[0], indexCount, (unsigned)hashVertices.size());
+		}
+
+		totalParse += bestParse;
+		totalParallel += bestParallel;
+		totalReference += bestReference;
+		totalHash += bestHash;
+		std::cout << std::left << std::setw(34) << benchmarkMeshes[m][0] << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(10) << bestParse * 1000.0
+			<< std::setw(10) << bestParallel * 1000.0
+			<< std::setw(10) << bestReference * 1000.0
+			<< std::setw(10) << bestHash * 1000.0
+			<< std::setw(8) << bestReference / Math::Max(bestHash, 1e-9) << "x"
+			<< std::setw(10) << weldedVertexCount
+			<< std::setw(8) << acmrBefore << "->" << std::setw(4) << acmrAfter << "\n";
+	}
+
+	std::cout << std::left << std::setw(34) << "total" << std::right << std::fixed << std::setprecision(2)
+		<< std::setw(10) << totalParse * 1000.0
+		<< std::setw(10) << totalParallel * 1000.0
+		<< std::setw(10) << totalReference * 1000.0
+		<< std::setw(10) << totalHash * 1000.0
+		<< std::setw(8) << totalReference / Math::Max(totalHash, 1e-9) << "x\n";
+}
+
+//Characters drawn per run, one draw each like RenderTextOnScreen
+static const int BENCHMARK_DRAWS = 20000;
+
+//The previous Mesh::Render(offset, count), which set the vertex layout up on every draw
+static void RenderText_Reference(const Mesh& mesh, unsigned offset, unsigned count)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer);
+
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)sizeof(Position));
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(Position) + sizeof(Color)));
+	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(Position) + sizeof(Color) + sizeof(Vector3)));
+
+	size_t indexBytes = mesh.GetIndexBytes();
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+	glDrawElementsBaseVertex(GL_TRIANGLES, count, mesh.indexType,
+		(void*)((mesh.geometry.firstIndex + offset) * indexBytes), mesh.geometry.baseVertex);
+
+	glDisableVertexAttribArray(0);
+	glDisableVertexAttribArray(1);
+	glDisableVertexAttribArray(2);
+	glDisableVertexAttribArray(3);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Time BENCHMARK_DRAWS single character draws of the text mesh, once through
+the per-draw attribute setup the meshes used to do and once through
+Mesh::Render and its VAO. Draws go to a hidden 1x1 viewport so the numbers
+are dominated by CPU/driver cost. Reports the best of BENCHMARK_RUNS runs:
+the time to issue the draws, and the time until the GPU has finished them.
+*/
+/******************************************************************************/
+void RunDrawCallBenchmark()
+{
+	if (!glfwInit())
+		return;
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(64, 64, "Benchmark", NULL, NULL);
+	if (!window)
+	{
+		std::cout << "draw call benchmark skipped, no OpenGL 3.3 context\n";
+		glfwTerminate();
+		return;
+	}
+	glfwMakeContextCurrent(window);
+	glewExperimental = true;
+	glewInit();
+	glViewport(0, 0, 1, 1);
+	Mesh::SetDefaultInstance();
+
+	unsigned programID = LoadShaders("Shader//Texture.vertexshader", "Shader//Text.fragmentshader");
+	glUseProgram(programID);
+	Mesh* text = MeshBuilder::GenerateText("text", 16, 16);
+
+	//the core profile needs some VAO bound for the reference path
+	GLuint referenceArray;
+	glGenVertexArrays(1, &referenceArray);
+
+	StopWatch timer;
+	double bestReferenceIssue = 1e9, bestReferenceTotal = 1e9, bestIssue = 1e9, bestTotal = 1e9;
+	for (int run = 0; run < BENCHMARK_RUNS; ++run)
+	{
+		glBindVertexArray(referenceArray);
+		glFinish();
+		timer.startTimer();
+		for (int i = 0; i < BENCHMARK_DRAWS; ++i)
+		{
+			RenderText_Reference(*text, (i % 256) * 6, 6);
+		}
+		bestReferenceIssue = Math::Min(bestReferenceIssue, timer.getElapsedTime());
+		glFinish();
+		bestReferenceTotal = Math::Min(bestReferenceTotal, timer.getElapsedTime());
+
+		glFinish();
+		timer.startTimer();
+		for (int i = 0; i < BENCHMARK_DRAWS; ++i)
+		{
+			text->Render((i % 256) * 6, 6);
+		}
+		bestIssue = Math::Min(bestIssue, timer.getElapsedTime());
+		glFinish();
+		bestTotal = Math::Min(bestTotal, timer.getElapsedTime());
+	}
+
+	std::cout << "\n" << BENCHMARK_DRAWS << " text draws\n";
+	std::cout << std::left << std::setw(16) << "path" << std::right << std::fixed << std::setprecision(2)
+		<< std::setw(12) << "issue ms" << std::setw(12) << "finish ms" << std::setw(14) << "ns per draw" << "\n";
+	std::cout << std::left << std::setw(16) << "attribute setup" << std::right
+		<< std::setw(12) << bestReferenceIssue * 1000.0
+		<< std::setw(12) << bestReferenceTotal * 1000.0
+		<< std::setw(14) << bestReferenceIssue * 1e9 / BENCHMARK_DRAWS << "\n";
+	std::cout << std::left << std::setw(16) << "vao" << std::right
+		<< std::setw(12) << bestIssue * 1000.0
+		<< std::setw(12) << bestTotal * 1000.0
+		<< std::setw(14) << bestIssue * 1e9 / BENCHMARK_DRAWS << "\n";
+	std::cout << std::left << std::setw(16) << "speedup" << std::right
+		<< std::setw(11) << bestReferenceIssue / Math::Max(bestIssue, 1e-9) << "x"
+		<< std::setw(11) << bestReferenceTotal / Math::Max(bestTotal, 1e-9) << "x\n";
+
+	glDeleteVertexArrays(1, &referenceArray);
+	delete text;
+	GeometryArena::Clear();
+	ClearShaderCache();
+	glfwDestroyWindow(window);
+	glfwTerminate();
+}
@@ -0,0 +1,15 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+/******************************************************************************/
+/*!
+\brief
+Developer benchmarks. Build with SP2_BENCHMARK defined (C/C++ > Preprocessor)
+and main() runs them and prints the results instead of starting the game.
+*/
+/******************************************************************************/
+
+void RunMeshLoadBenchmark();
+void RunDrawCallBenchmark();
+
+#endif
@@ -57,8 +57,9 @@ void Camera3::Update(double dt)
 		}
 
 
-		//footstep 
+		//footstep, paused rather than stopped so the loop resumes where it left off
 		static bool IsMove = false;
+		static Sound::Handle footstep = 0;
 		if (((Application::IsKeyPressed('A')) ||
 			(Application::IsKeyPressed('D')) ||
 			(Application::IsKeyPressed('S')) ||
@@ -66,8 +67,10 @@ void Camera3::Update(double dt)
 			!IsMove)
 		{
 			IsMove = true;
-			Application::soundManager.CreateSound(&Application::soundList[Application::SOUND_FOOTSTEP], "Sound/Footstep.wav");
-			Application::soundManager.RunSound(Application::soundList[Application::SOUND_FOOTSTEP], true);
+			if (Application::soundManager.IsPlaying(footstep))
+				Application::soundManager.Pause(footstep, false);
+			else
+				footstep = Application::soundManager.Play(Application::SOUND_FOOTSTEP, true);
 		}
 		else if (!((Application::IsKeyPressed('A')) ||
 			(Application::IsKeyPressed('D')) ||
@@ -76,7 +79,7 @@ void Camera3::Update(double dt)
 			IsMove)
 		{
 			IsMove = false;
-			Application::soundManager.ReleaseSound(Application::soundList[Application::SOUND_FOOTSTEP]);
+			Application::soundManager.Pause(footstep, true);
 		}
 
 
@@ -0,0 +1,255 @@
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <ctime>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "CookedMesh.h"
+
+static bool GetModifiedTime(const std::string& file_path, time_t& out_time)
+{
+	struct stat fileStat;
+	if (file_path.empty() || stat(file_path.c_str(), &fileStat) != 0)
+		return false;
+	out_time = fileStat.st_mtime;
+	return true;
+}
+
+CookedMesh::CookedMesh()
+	: header(nullptr)
+	, materials(nullptr)
+	, lods(nullptr)
+	, lodMaterialSizes(nullptr)
+	, vertices(nullptr)
+	, indices(nullptr)
+{
+}
+
+/******************************************************************************/
+/*!
+\brief
+Map a cooked mesh and validate its header against the current build
+
+\param cooked_path - path of the cooked mesh file
+
+\return true if the file is usable, false if it is missing, truncated or was
+		written by a different version of the importer
+*/
+/******************************************************************************/
+bool CookedMesh::Load(const std::string& cooked_path)
+{
+	header = nullptr;
+	if (!file.Open(cooked_path.c_str()))
+		return false;
+
+	size_t fileSize = file.GetSize();
+	if (fileSize < sizeof(CookedMeshHeader))
+	{
+		file.Close();
+		return false;
+	}
+
+	const CookedMeshHeader* h = (const CookedMeshHeader*)file.GetData();
+	if (h->magic != COOKED_MESH_MAGIC ||
+		h->version != COOKED_MESH_VERSION ||
+		h->vertexFormat >= VertexFormat::FORMAT_TOTAL ||
+		h->vertexSize != VertexFormat::Get((VertexFormat::TYPE)h->vertexFormat).stride)
+	{
+		file.Close();
+		return false;
+	}
+
+	size_t expectedSize = sizeof(CookedMeshHeader)
+		+ (size_t)h->materialCount * sizeof(CookedMaterial)
+		+ (size_t)h->lodCount * (sizeof(CookedLod) + h->materialCount * sizeof(unsigned))
+		+ (size_t)h->vertexCount * h->vertexSize
+		+ (size_t)h->indexCount * sizeof(unsigned);
+	if (fileSize != expectedSize)
+	{
+		std::cout << "Cooked mesh " << cooked_path << " is truncated, regenerating\n";
+		file.Close();
+		return false;
+	}
+
+	const char* cursor = file.GetData() + sizeof(CookedMeshHeader);
+	materials = (const CookedMaterial*)cursor;
+	cursor += h->materialCount * sizeof(CookedMaterial);
+	lods = (const CookedLod*)cursor;
+	cursor += h->lodCount * sizeof(CookedLod);
+	lodMaterialSizes = (const unsigned*)cursor;
+	cursor += (size_t)h->lodCount * h->materialCount * sizeof(unsigned);
+	vertices = cursor;
+	cursor += (size_t)h->vertexCount * h->vertexSize;
+	indices = (const unsigned*)cursor;
+	header = h;
+	return true;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Write welded mesh data to disk. The file is written under a temporary name
+and renamed once complete so a crash never leaves a half-written cooked file.
+
+\param vertices - vertexCount vertices already encoded in format
+*/
+/******************************************************************************/
+bool CookedMesh::Save(const std::string& cooked_path,
+	VertexFormat::TYPE format,
+	const std::vector<unsigned char>& vertices,
+	unsigned vertexCount,
+	const std::vector<unsigned>& indices,
+	const std::vector<Material>& materials,
+	const std::vector<MeshLod>& lods)
+{
+	std::string temp_path = cooked_path + ".tmp";
+	std::ofstream fileStream(temp_path.c_str(), std::ios::binary | std::ios::trunc);
+	if (!fileStream.is_open())
+	{
+		std::cout << "Impossible to write " << cooked_path << "\n";
+		return false;
+	}
+
+	CookedMeshHeader h;
+	h.magic = COOKED_MESH_MAGIC;
+	h.version = COOKED_MESH_VERSION;
+	h.vertexFormat = format;
+	h.vertexSize = VertexFormat::Get(format).stride;
+	h.vertexCount = vertexCount;
+	h.indexCount = (unsigned)indices.size();
+	h.materialCount = (unsigned)materials.size();
+	h.lodCount = (unsigned)lods.size();
+	fileStream.write((const char*)&h, sizeof(h));
+
+	for (unsigned i = 0; i < materials.size(); ++i)
+	{
+		const Material& material = materials[i];
+		CookedMaterial cm;
+		cm.kAmbient[0] = material.kAmbient.r; cm.kAmbient[1] = material.kAmbient.g; cm.kAmbient[2] = material.kAmbient.b;
+		cm.kDiffuse[0] = material.kDiffuse.r; cm.kDiffuse[1] = material.kDiffuse.g; cm.kDiffuse[2] = material.kDiffuse.b;
+		cm.kSpecular[0] = material.kSpecular.r; cm.kSpecular[1] = material.kSpecular.g; cm.kSpecular[2] = material.kSpecular.b;
+		cm.kShininess = material.kShininess;
+		cm.size = material.size;
+		fileStream.write((const char*)&cm, sizeof(cm));
+	}
+	for (unsigned i = 0; i < lods.size(); ++i)
+	{
+		CookedLod cl = { lods[i].offset, lods[i].count };
+		fileStream.write((const char*)&cl, sizeof(cl));
+	}
+	for (unsigned i = 0; i < lods.size(); ++i)
+	{
+		//meshes without materials store no sizes
+		std::vector<unsigned> sizes(lods[i].materialSizes);
+		sizes.resize(materials.size(), 0);
+		if (!sizes.empty())
+			fileStream.write((const char*)&sizes[0], sizes.size() * sizeof(unsigned));
+	}
+	if (!vertices.empty())
+		fileStream.write((const char*)&vertices[0], vertices.size());
+	if (!indices.empty())
+		fileStream.write((const char*)&indices[0], indices.size() * sizeof(unsigned));
+
+	bool success = fileStream.good();
+	fileStream.close();
+	if (!success)
+	{
+		std::remove(temp_path.c_str());
+		return false;
+	}
+
+	std::remove(cooked_path.c_str()); //rename does not overwrite on Windows
+	return std::rename(temp_path.c_str(), cooked_path.c_str()) == 0;
+}
+
+/******************************************************************************/
+/*!
+\brief
+"OBJ//Gamer.obj" is cooked to "OBJ//Gamer.mesh"
+*/
+/******************************************************************************/
+std::string CookedMesh::GetCookedPath(const std::string& obj_path)
+{
+	std::string::size_type dot = obj_path.find_last_of('.');
+	std::string::size_type slash = obj_path.find_last_of("/\\");
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+		return obj_path + ".mesh";
+	return obj_path.substr(0, dot) + ".mesh";
+}
+
+/******************************************************************************/
+/*!
+\brief
+A cooked file is stale if it does not exist or if the source .obj or .mtl was
+modified after it. Missing sources are ignored so cooked-only builds still load.
+*/
+/******************************************************************************/
+bool CookedMesh::IsStale(const std::string& cooked_path, const std::string& obj_path, const std::string& mtl_path)
+{
+	time_t cookedTime, sourceTime;
+	if (!GetModifiedTime(cooked_path, cookedTime))
+		return true;
+	if (GetModifiedTime(obj_path, sourceTime) && sourceTime > cookedTime)
+		return true;
+	if (GetModifiedTime(mtl_path, sourceTime) && sourceTime > cookedTime)
+		return true;
+	return false;
+}
+
+VertexFormat::TYPE CookedMesh::GetVertexFormat() const
+{
+	return header ? (VertexFormat::TYPE)header->vertexFormat : VertexFormat::FORMAT_FLOAT;
+}
+
+const void* CookedMesh::GetVertexData() const
+{
+	return vertices;
+}
+
+unsigned CookedMesh::GetVertexCount() const
+{
+	return header ? header->vertexCount : 0;
+}
+
+const unsigned* CookedMesh::GetIndexData() const
+{
+	return indices;
+}
+
+unsigned CookedMesh::GetIndexCount() const
+{
+	return header ? header->indexCount : 0;
+}
+
+void CookedMesh::GetMaterials(std::vector<Material>& out_materials) const
+{
+	if (header == nullptr)
+		return;
+	for (unsigned i = 0; i < header->materialCount; ++i)
+	{
+		const CookedMaterial& cm = materials[i];
+		Material material;
+		material.kAmbient.Set(cm.kAmbient[0], cm.kAmbient[1], cm.kAmbient[2]);
+		material.kDiffuse.Set(cm.kDiffuse[0], cm.kDiffuse[1], cm.kDiffuse[2]);
+		material.kSpecular.Set(cm.kSpecular[0], cm.kSpecular[1], cm.kSpecular[2]);
+		material.kShininess = cm.kShininess;
+		material.size = cm.size;
+		out_materials.push_back(material);
+	}
+}
+
+void CookedMesh::GetLods(std::vector<MeshLod>& out_lods) const
+{
+	if (header == nullptr)
+		return;
+	for (unsigned i = 0; i < header->lodCount; ++i)
+	{
+		MeshLod lod;
+		lod.offset = lods[i].offset;
+		lod.count = lods[i].count;
+		const unsigned* sizes = lodMaterialSizes + i * header->materialCount;
+		lod.materialSizes.assign(sizes, sizes + header->materialCount);
+		out_lods.push_back(lod);
+	}
+}
@@ -0,0 +1,99 @@
+#ifndef COOKED_MESH_H
+#define COOKED_MESH_H
+
+#include <string>
+#include <vector>
+#include "VertexFormat.h"
+#include "Material.h"
+#include "Mesh.h"
+#include "MappedFile.h"
+
+/******************************************************************************/
+/*!
+		Cooked mesh file layout (tightly packed, native endianness):
+
+		CookedMeshHeader
+		CookedMaterial	[materialCount]
+		CookedLod		[lodCount]
+		unsigned		[lodCount * materialCount]	- index count of each material in each LOD
+		vertexSize		[vertexCount]	- welded and encoded in vertexFormat, ready for the VBO
+		unsigned		[indexCount]	- ready for the IBO, the full mesh followed by its LODs
+
+\brief	Bump COOKED_MESH_VERSION whenever the layout or the import pipeline
+		changes so that stale cooked files are regenerated.
+*/
+/******************************************************************************/
+const unsigned COOKED_MESH_MAGIC = 0x4D325053; // "SP2M"
+const unsigned COOKED_MESH_VERSION = 5;
+
+struct CookedMeshHeader
+{
+	unsigned magic;
+	unsigned version;
+	unsigned vertexFormat;	//VertexFormat::TYPE
+	unsigned vertexSize;
+	unsigned vertexCount;
+	unsigned indexCount;
+	unsigned materialCount;
+	unsigned lodCount;
+};
+
+struct CookedMaterial
+{
+	float kAmbient[3];
+	float kDiffuse[3];
+	float kSpecular[3];
+	float kShininess;
+	unsigned size;
+};
+
+struct CookedLod
+{
+	unsigned offset;
+	unsigned count;
+};
+
+/******************************************************************************/
+/*!
+		Class CookedMesh:
+\brief	Memory-mapped view of a cooked mesh file. Vertex and index data point
+		straight into the mapping, so they can be handed to glBufferData
+		without an intermediate copy.
+*/
+/******************************************************************************/
+class CookedMesh
+{
+public:
+	CookedMesh();
+
+	bool Load(const std::string& cooked_path);
+	static bool Save(const std::string& cooked_path,
+		VertexFormat::TYPE format,
+		const std::vector<unsigned char>& vertices,
+		unsigned vertexCount,
+		const std::vector<unsigned>& indices,
+		const std::vector<Material>& materials,
+		const std::vector<MeshLod>& lods);
+
+	static std::string GetCookedPath(const std::string& obj_path);
+	static bool IsStale(const std::string& cooked_path, const std::string& obj_path, const std::string& mtl_path);
+
+	VertexFormat::TYPE GetVertexFormat() const;
+	const void* GetVertexData() const;
+	unsigned GetVertexCount() const;
+	const unsigned* GetIndexData() const;
+	unsigned GetIndexCount() const;
+	void GetMaterials(std::vector<Material>& out_materials) const;
+	void GetLods(std::vector<MeshLod>& out_lods) const;
+
+private:
+	MappedFile file;
+	const CookedMeshHeader* header;
+	const CookedMaterial* materials;
+	const CookedLod* lods;
+	const unsigned* lodMaterialSizes;
+	const char* vertices;
+	const unsigned* indices;
+};
+
+#endif
@@ -3,145 +3,49 @@
 
 #include "shader.hpp"
 #include "MeshBuilder.h"
+#include "TextureAtlas.h"
+#include "AssetStreamer.h"
 
 #define LSPEED 20
 
 void CorridorScene::RenderMesh(Mesh* mesh, bool enableLight)
 {
-	Mtx44 MVP, modelView, modelView_inverse_transpose;
-
-	MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, &MVP.a[0]);
-	modelView = viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MODELVIEW], 1, GL_FALSE, &modelView.a[0]);
-	if (enableLight)
-	{
-		glUniform1i(m_parameters[U_LIGHTENABLED], 1);
-		modelView_inverse_transpose = modelView.GetInverse().GetTranspose();
-		glUniformMatrix4fv(m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE], 1, GL_FALSE, &modelView_inverse_transpose.a[0]);
-
-		//load material
-		glUniform3fv(m_parameters[U_MATERIAL_AMBIENT], 1, &mesh->material.kAmbient.r);
-		glUniform3fv(m_parameters[U_MATERIAL_DIFFUSE], 1, &mesh->material.kDiffuse.r);
-		glUniform3fv(m_parameters[U_MATERIAL_SPECULAR], 1, &mesh->material.kSpecular.r);
-		glUniform1f(m_parameters[U_MATERIAL_SHININESS], mesh->material.kShininess);
-	}
-	else
-	{
-		glUniform1i(m_parameters[U_LIGHTENABLED], 0);
-	}
+	Mtx44 modelView = viewStack.Top() * modelStack.Top();
+	//imported meshes with LODs, such as the dining hall tables, draw a coarser one from afar
+	renderer.DrawMesh(mesh, projectionStack.Top(), modelView, enableLight,
+		mesh != nullptr ? mesh->SelectLod(modelView, projectionStack.Top()) : 0);
+}
 
-	if (mesh->textureID > 0)
-	{
-		glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 1);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, mesh->textureID);
-		glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
-	}
-	else
-	{
-		glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 0);
-	}
-	mesh->Render(); //this line should only be called once
-	if (mesh->textureID > 0)
-	{
-		glBindTexture(GL_TEXTURE_2D, 0);
-	}
+//Draw a mesh once per model matrix in one draw call. The matrices are built
+//on modelStack as for RenderMesh; only the camera is shared through uniforms.
+void CorridorScene::RenderMeshInstanced(Mesh* mesh, const std::vector<Mtx44>& models, bool enableLight)
+{
+	renderer.DrawMeshInstanced(mesh, projectionStack.Top(), viewStack.Top(), models, enableLight);
 }
 
 void CorridorScene::RenderEntity(Entity* entity, bool enableLight)
 {
-	modelStack.PushMatrix();
-	modelStack.Translate(entity->getTransform().x, entity->getTransform().y, entity->getTransform().z);
-	modelStack.Scale(entity->getScale().x, entity->getScale().x, entity->getScale().x);
-
-	Mtx44 MVP, modelView, modelView_inverse_transpose;
-
-	MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, &MVP.a[0]);
-	modelView = viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MODELVIEW], 1, GL_FALSE, &modelView.a[0]);
-	if (enableLight)
-	{
-		glUniform1i(m_parameters[U_LIGHTENABLED], 1);
-		modelView_inverse_transpose = modelView.GetInverse().GetTranspose();
-		glUniformMatrix4fv(m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE], 1, GL_FALSE, &modelView_inverse_transpose.a[0]);
-
-		//load material
-		glUniform3fv(m_parameters[U_MATERIAL_AMBIENT], 1, &entity->getMesh()->material.kAmbient.r);
-		glUniform3fv(m_parameters[U_MATERIAL_DIFFUSE], 1, &entity->getMesh()->material.kDiffuse.r);
-		glUniform3fv(m_parameters[U_MATERIAL_SPECULAR], 1, &entity->getMesh()->material.kSpecular.r);
-		glUniform1f(m_parameters[U_MATERIAL_SHININESS], entity->getMesh()->material.kShininess);
-	}
-	else
-	{
-		glUniform1i(m_parameters[U_LIGHTENABLED], 0);
-	}
-
-	if (entity->getMesh()->textureID > 0)
-	{
-		glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 1);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, entity->getMesh()->textureID);
-		glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
-	}
-	else
-	{
-		glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 0);
-	}
-	entity->getMesh()->Render(); //this line should only be called once
-	if (entity->getMesh()->textureID > 0)
-	{
-		glBindTexture(GL_TEXTURE_2D, 0);
-	}
-
-	modelStack.PopMatrix();
+	Mtx44 modelView = viewStack.Top() * modelStack.Top() * entity->getModelMatrix();
+	//distant characters and props draw a coarser LOD
+	Mesh* mesh = entity->getMesh();
+	renderer.DrawMesh(mesh, projectionStack.Top(), modelView, enableLight, mesh->SelectLod(modelView, projectionStack.Top()));
 }
 
 void CorridorScene::RenderText(Mesh* mesh, std::string text, Color color)
 {
-	if (!mesh || mesh->textureID <= 0) //Proper error check
-	{
-		return;
-	}
-	glUniform1i(m_parameters[U_TEXT_ENABLED], 1);
-	glUniform3fv(m_parameters[U_TEXT_COLOR], 1, &color.r);
-	glUniform1i(m_parameters[U_LIGHTENABLED], 0);
-	glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 1);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, mesh->textureID);
-	glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
-	for (unsigned i = 0; i < text.length(); ++i)
-	{
-		Mtx44 characterSpacing;
-		characterSpacing.SetToTranslation(i * 1.0f, 0, 0); //1.0f is the spacing of each character, you may change this value
-		Mtx44 MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top() * characterSpacing;
-		glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, &MVP.a[0]);
-		mesh->Render((unsigned)text[i] * 6, 6);
-	}
-
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glUniform1i(m_parameters[U_TEXT_ENABLED], 0);
+	renderer.DrawText(mesh, text, color, projectionStack.Top() * viewStack.Top() * modelStack.Top(), 1.0f);
 }
 
 void CorridorScene::RenderMeshOnScreen(Mesh* mesh, float x, float y, float sizex, float sizey)
 {
-	glDisable(GL_DEPTH_TEST);
 	Mtx44 ortho;
 	ortho.SetToOrtho(0, Application::screenUISizeX, 0, Application::screenUISizeY, -10, 10); //size of screen UI
-	projectionStack.PushMatrix();
-	projectionStack.LoadMatrix(ortho);
-	viewStack.PushMatrix();
-	viewStack.LoadIdentity(); //No need camera for ortho mode
 	modelStack.PushMatrix();
 	modelStack.LoadIdentity(); //Reset modelStack
 	modelStack.Translate(x, y, 0);
 	modelStack.Scale(sizex, sizey, 1);
-	RenderMesh(mesh, false);
-	projectionStack.PopMatrix();
-	viewStack.PopMatrix();
+	renderer.DrawMesh(mesh, ortho, modelStack.Top(), false, 0, Renderer::PASS_SCREEN);
 	modelStack.PopMatrix();
-	glEnable(GL_DEPTH_TEST);
 }
 
 void CorridorScene::RenderTextOnScreen(Mesh* mesh, std::string text, Color color, float size, float x, float y)
@@ -152,59 +56,27 @@ void CorridorScene::RenderTextOnScreen(Mesh* mesh, std::string text, Color color
 	{
 		return;
 	}
-	glDisable(GL_DEPTH_TEST);
 	Mtx44 ortho;
 	ortho.SetToOrtho(0, Application::screenUISizeX, 0, Application::screenUISizeY, -10, 10); //size of screen UI
-	projectionStack.PushMatrix();
-	projectionStack.LoadMatrix(ortho);
-	viewStack.PushMatrix();
-	viewStack.LoadIdentity(); //No need camera for ortho mode
 	modelStack.PushMatrix();
 	modelStack.LoadIdentity(); //Reset modelStack
 	modelStack.Translate(x - text.size() * (0.6f * spacing), y, 0);
 	modelStack.Scale(size, size, size);
-	glUniform1i(m_parameters[U_TEXT_ENABLED], 1);
-	glUniform3fv(m_parameters[U_TEXT_COLOR], 1, &color.r);
-	glUniform1i(m_parameters[U_LIGHTENABLED], 0);
-	glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 1);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, mesh->textureID);
-	glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
-	for (unsigned i = 0; i < text.length(); ++i)
-	{
-		Mtx44 characterSpacing;
-		std::stringstream ss;
-		characterSpacing.SetToTranslation(0.5f + i * spacing, 0.5f, 0); //1.0f is the spacing of each character, you may change this value
-		Mtx44 MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top() * characterSpacing;
-		glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, &MVP.a[0]);
-		mesh->Render((unsigned)text[i] * 6, 6);
-	}
-
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glUniform1i(m_parameters[U_TEXT_ENABLED], 0);
-	projectionStack.PopMatrix();
-	viewStack.PopMatrix();
+	renderer.DrawText(mesh, text, color, ortho * modelStack.Top(), spacing, 0.5f, 0.5f, Renderer::PASS_SCREEN);
 	modelStack.PopMatrix();
-	glEnable(GL_DEPTH_TEST);
 }
 
 void CorridorScene::InspectEvidenceOnScreen(Mesh* mesh, float x, float y, float sizex, float sizey, float rotatez, float rotatex)
 {
 	Mtx44 ortho;
 	ortho.SetToOrtho(0, 80, 0, 60, -10, 10); //size of screen UI
-	projectionStack.PushMatrix();
-	projectionStack.LoadMatrix(ortho);
-	viewStack.PushMatrix();
-	viewStack.LoadIdentity(); //No need camera for ortho mode
 	modelStack.PushMatrix();
 	modelStack.LoadIdentity(); //Reset modelStack
 	modelStack.Translate(x, y, 0);
 	modelStack.Scale(sizex, sizey, 1);
 	modelStack.Rotate(rotatex, 1, 0, 0);
 	modelStack.Rotate(rotatez, 0, 1, 0);
-	RenderMesh(mesh, false);
-	projectionStack.PopMatrix();
-	viewStack.PopMatrix();
+	renderer.DrawMesh(mesh, ortho, modelStack.Top(), false, 0, Renderer::PASS_SCREEN_DEPTH);
 	modelStack.PopMatrix();
 }
 
@@ -604,14 +476,15 @@ void CorridorScene::BoundsCheck()
 
 void CorridorScene::RenderOfficers()
 {
+	std::vector<Mtx44> femaleOfficers, maleOfficers;
+
 	//cart officer
 
 	modelStack.PushMatrix();
 	modelStack.Translate(1.5, 0, -20);
 	modelStack.Scale(1, 1, 1);
-	RenderMesh(meshList[GEO_OFFICER_F], true);
+	femaleOfficers.push_back(modelStack.Top());
 	modelStack.PopMatrix();
-	RenderHUD();
 
 
 	//victim officer
@@ -620,9 +493,8 @@ void CorridorScene::RenderOfficers()
 	modelStack.Translate(-2, 0, -16.4);
 	modelStack.Scale(1, 1, 1);
 	modelStack.Rotate(90, 0, 1, 0);
-	RenderMesh(meshList[GEO_OFFICER_M], true);
+	maleOfficers.push_back(modelStack.Top());
 	modelStack.PopMatrix();
-	RenderHUD();
 
 
 	//Kid officer
@@ -631,9 +503,8 @@ void CorridorScene::RenderOfficers()
 	modelStack.Translate(-2, 0, -8.2);
 	modelStack.Scale(1, 1, 1);
 	modelStack.Rotate(90, 0, 1, 0);
-	RenderMesh(meshList[GEO_OFFICER_F], true);
+	femaleOfficers.push_back(modelStack.Top());
 	modelStack.PopMatrix();
-	RenderHUD();
 
 
 	//Oldman officer
@@ -642,9 +513,8 @@ void CorridorScene::RenderOfficers()
 	modelStack.Translate(-2, 0, 9.5);
 	modelStack.Scale(1, 1, 1);
 	modelStack.Rotate(90, 0, 1, 0);
-	RenderMesh(meshList[GEO_OFFICER_M], true);
+	maleOfficers.push_back(modelStack.Top());
 	modelStack.PopMatrix();
-	RenderHUD();
 
 
 	//Arcade officer
@@ -653,8 +523,12 @@ void CorridorScene::RenderOfficers()
 	modelStack.Translate(-2, 0, 17.5);
 	modelStack.Scale(1, 1, 1);
 	modelStack.Rotate(90, 0, 1, 0);
-	RenderMesh(meshList[GEO_OFFICER_M], true);
+	maleOfficers.push_back(modelStack.Top());
 	modelStack.PopMatrix();
+
+	//every officer of a model is drawn in one call
+	RenderMeshInstanced(meshList[GEO_OFFICER_F], femaleOfficers, true);
+	RenderMeshInstanced(meshList[GEO_OFFICER_M], maleOfficers, true);
 	RenderHUD();
 
 	if (!isJournalOpen && !Inspect)
@@ -752,8 +626,37 @@ CorridorScene::CorridorScene()
 	camera.Init(Vector3(-4, 1.5f, 3), Vector3(2, 1.5f, 3), Vector3(0, 1, 0));
 }
 
+void CorridorScene::Preload()
+{
+	AssetStreamer::RequestMesh("OBJ//officer_male.obj", "OBJ//officer_male.mtl");
+	AssetStreamer::RequestMesh("OBJ//officer_female.obj", "OBJ//officer_female.mtl");
+	AssetStreamer::RequestMesh("OBJ//evidence//cleaning_cart.obj", "OBJ//evidence//cleaning_cart.mtl");
+	AssetStreamer::RequestMesh("OBJ//ship_corridor.obj", "OBJ//ship_corridor.mtl");
+
+	AssetStreamer::RequestTexture("Image//typewriter.tga");
+	AssetStreamer::RequestTexture("Image//PolygonOffice_Texture_01_A.tga");
+	AssetStreamer::RequestTexture("Image//front.tga");
+	AssetStreamer::RequestTexture("Image//back.tga");
+	AssetStreamer::RequestTexture("Image//left.tga");
+	AssetStreamer::RequestTexture("Image//right.tga");
+	AssetStreamer::RequestTexture("Image//top.tga");
+	AssetStreamer::RequestTexture("Image//bottom.tga");
+	TextureAtlas::GetUI().Request("Image//journal_1.tga");
+	TextureAtlas::GetUI().Request("Image//journal_2.tga");
+	TextureAtlas::GetUI().Request("Image//profile//gamer_profile.tga");
+	TextureAtlas::GetUI().Request("Image//profile//guard_profile.tga");
+	TextureAtlas::GetUI().Request("Image//profile//janitor_profile.tga");
+	TextureAtlas::GetUI().Request("Image//profile//kid_profile.tga");
+	TextureAtlas::GetUI().Request("Image//profile//oldman_profile.tga");
+	AssetStreamer::RequestTexture("Image//PolygonOffice_Texture_03_B.tga");
+	AssetStreamer::RequestTexture("Image//PolygonOffice_Texture_01_AMachine.tga");
+}
+
 void CorridorScene::Init()
 {
+	//meshes of an earlier Init, when the scene is entered again
+	ReleaseMeshes();
+
 	// Init VBO here
 	Mtx44 projection;
 
@@ -780,67 +683,41 @@ void CorridorScene::Init()
 	//set background color
 	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 
-	//generate default VAO for now
-	glGenVertexArrays(1, &m_vertexArrayID);
-	glBindVertexArray(m_vertexArrayID);
-
 	//load vertex and fragment shaders
 	m_programID = LoadShaders("Shader//Texture.vertexshader", "Shader//Text.fragmentshader");
-
-	m_parameters[U_LIGHT0_TYPE] = glGetUniformLocation(m_programID, "lights[0].type");
-	m_parameters[U_LIGHT0_SPOTDIRECTION] = glGetUniformLocation(m_programID, "lights[0].spotDirection");
-	m_parameters[U_LIGHT0_COSCUTOFF] = glGetUniformLocation(m_programID, "lights[0].cosCutoff");
-	m_parameters[U_LIGHT0_COSINNER] = glGetUniformLocation(m_programID, "lights[0].cosInner");
-	m_parameters[U_LIGHT0_EXPONENT] = glGetUniformLocation(m_programID, "lights[0].exponent");
-	m_parameters[U_NUMLIGHTS] = glGetUniformLocation(m_programID, "numLights");
-	m_parameters[U_MVP] = glGetUniformLocation(m_programID, "MVP");
-	m_parameters[U_MODELVIEW] = glGetUniformLocation(m_programID, "MV");
-	m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE] = glGetUniformLocation(m_programID, "MV_inverse_transpose");
-	m_parameters[U_MATERIAL_AMBIENT] = glGetUniformLocation(m_programID, "material.kAmbient");
-	m_parameters[U_MATERIAL_DIFFUSE] = glGetUniformLocation(m_programID, "material.kDiffuse");
-	m_parameters[U_MATERIAL_SPECULAR] = glGetUniformLocation(m_programID, "material.kSpecular");
-	m_parameters[U_MATERIAL_SHININESS] = glGetUniformLocation(m_programID, "material.kShininess");
-	m_parameters[U_LIGHT0_POSITION] = glGetUniformLocation(m_programID, "lights[0].position_cameraspace");
-	m_parameters[U_LIGHT0_COLOR] = glGetUniformLocation(m_programID, "lights[0].color");
-	m_parameters[U_LIGHT0_POWER] = glGetUniformLocation(m_programID, "lights[0].power");
-	m_parameters[U_LIGHT0_KC] = glGetUniformLocation(m_programID, "lights[0].kC");
-	m_parameters[U_LIGHT0_KL] = glGetUniformLocation(m_programID, "lights[0].kL");
-	m_parameters[U_LIGHT0_KQ] = glGetUniformLocation(m_programID, "lights[0].kQ");
-	m_parameters[U_LIGHTENABLED] = glGetUniformLocation(m_programID, "lightEnabled");
+	renderer.Init(m_programID);
+	m_uniforms = &UniformTable::Get(m_programID);
+
+	m_parameters[U_NUMLIGHTS] = m_uniforms->GetLocation("numLights");
+	m_parameters[U_MVP] = m_uniforms->GetLocation("MVP");
+	m_parameters[U_MODELVIEW] = m_uniforms->GetLocation("MV");
+	m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE] = m_uniforms->GetLocation("MV_inverse_transpose");
+	m_parameters[U_MATERIAL_AMBIENT] = m_uniforms->GetLocation("material.kAmbient");
+	m_parameters[U_MATERIAL_DIFFUSE] = m_uniforms->GetLocation("material.kDiffuse");
+	m_parameters[U_MATERIAL_SPECULAR] = m_uniforms->GetLocation("material.kSpecular");
+	m_parameters[U_MATERIAL_SHININESS] = m_uniforms->GetLocation("material.kShininess");
+	m_parameters[U_LIGHTENABLED] = m_uniforms->GetLocation("lightEnabled");
 
 	// Get a handle for our "colorTexture" uniform
-	m_parameters[U_COLOR_TEXTURE_ENABLED] = glGetUniformLocation(m_programID, "colorTextureEnabled");
-	m_parameters[U_COLOR_TEXTURE] = glGetUniformLocation(m_programID, "colorTexture");
+	m_parameters[U_COLOR_TEXTURE_ENABLED] = m_uniforms->GetLocation("colorTextureEnabled");
+	m_parameters[U_COLOR_TEXTURE] = m_uniforms->GetLocation("colorTexture");
 
 	// Get a handle for our "textColor" uniform
-	m_parameters[U_TEXT_ENABLED] = glGetUniformLocation(m_programID, "textEnabled");
-	m_parameters[U_TEXT_COLOR] = glGetUniformLocation(m_programID, "textColor");
+	m_parameters[U_TEXT_ENABLED] = m_uniforms->GetLocation("textEnabled");
+	m_parameters[U_TEXT_COLOR] = m_uniforms->GetLocation("textColor");
 
 	//use our shader
 	glUseProgram(m_programID);
 
 	// Make sure you pass uniform parameters after glUseProgram()
 	glUniform1i(m_parameters[U_NUMLIGHTS], 1);
-	//light[0].type = Light::LIGHT_DIRECTIONAL;
-	glUniform1i(m_parameters[U_LIGHT0_TYPE], light[0].type);
-	glUniform3fv(m_parameters[U_LIGHT0_COLOR], 1, &light[0].color.r);
-	glUniform1f(m_parameters[U_LIGHT0_POWER], light[0].power);
-
-	//light[0].type = Light::LIGHT_POINT;
-	glUniform1f(m_parameters[U_LIGHT0_KC], light[0].kC);
-	glUniform1f(m_parameters[U_LIGHT0_KL], light[0].kL);
-	glUniform1f(m_parameters[U_LIGHT0_KQ], light[0].kQ);
-
-	//light[0].type = Light::LIGHT_SPOT;
-	glUniform1f(m_parameters[U_LIGHT0_COSCUTOFF], light[0].cosCutoff);
-	glUniform1f(m_parameters[U_LIGHT0_COSINNER], light[0].cosInner);
-	glUniform1f(m_parameters[U_LIGHT0_EXPONENT], light[0].exponent);
+	m_uniforms->SetLight(0, light[0]);
 
 	//Enable depth test
 	glEnable(GL_DEPTH_TEST);
 
 	//Get a handle for our "MVP" uniform
-	m_parameters[U_MVP] = glGetUniformLocation(m_programID, "MVP");
+	m_parameters[U_MVP] = m_uniforms->GetLocation("MVP");
 
 	Mesh::SetMaterialLoc(m_parameters[U_MATERIAL_AMBIENT],
 		m_parameters[U_MATERIAL_DIFFUSE],
@@ -885,27 +762,20 @@ void CorridorScene::Init()
 
 	//Journal
 	{
-		meshList[GEO_JOURNAL_PAGE1] = MeshBuilder::GenerateQuad("Journal Page 1", Color(1, 1, 1), 1.f);
-		meshList[GEO_JOURNAL_PAGE1]->textureID = LoadTGA("Image//journal_1.tga");
+		meshList[GEO_JOURNAL_PAGE1] = MeshBuilder::GenerateQuad("Journal Page 1", Color(1, 1, 1), 1.f, TextureAtlas::GetUI().AcquireRegion("Image//journal_1.tga"));
 
-		meshList[GEO_JOURNAL_PAGE2] = MeshBuilder::GenerateQuad("Journal Page 2", Color(1, 1, 1), 1.f);
-		meshList[GEO_JOURNAL_PAGE2]->textureID = LoadTGA("Image//journal_2.tga");
+		meshList[GEO_JOURNAL_PAGE2] = MeshBuilder::GenerateQuad("Journal Page 2", Color(1, 1, 1), 1.f, TextureAtlas::GetUI().AcquireRegion("Image//journal_2.tga"));
 
 
-		meshList[GEO_CHARACTER_PROFILE1] = MeshBuilder::GenerateQuad("Gamer Profile", Color(1, 1, 1), 1.f);
-		meshList[GEO_CHARACTER_PROFILE1]->textureID = LoadTGA("Image//profile//gamer_profile.tga");
+		meshList[GEO_CHARACTER_PROFILE1] = MeshBuilder::GenerateQuad("Gamer Profile", Color(1, 1, 1), 1.f, TextureAtlas::GetUI().AcquireRegion("Image//profile//gamer_profile.tga"));
 
-		meshList[GEO_CHARACTER_PROFILE2] = MeshBuilder::GenerateQuad("Guard Profile", Color(1, 1, 1), 1.f);
-		meshList[GEO_CHARACTER_PROFILE2]->textureID = LoadTGA("Image//profile//guard_profile.tga");
+		meshList[GEO_CHARACTER_PROFILE2] = MeshBuilder::GenerateQuad("Guard Profile", Color(1, 1, 1), 1.f, TextureAtlas::GetUI().AcquireRegion("Image//profile//guard_profile.tga"));
 
-		meshList[GEO_CHARACTER_PROFILE3] = MeshBuilder::GenerateQuad("Janitor Profile", Color(1, 1, 1), 1.f);
-		meshList[GEO_CHARACTER_PROFILE3]->textureID = LoadTGA("Image//profile//janitor_profile.tga");
+		meshList[GEO_CHARACTER_PROFILE3] = MeshBuilder::GenerateQuad("Janitor Profile", Color(1, 1, 1), 1.f, TextureAtlas::GetUI().AcquireRegion("Image//profile//janitor_profile.tga"));
 
-		meshList[GEO_CHARACTER_PROFILE4] = MeshBuilder::GenerateQuad("Kid Profile", Color(1, 1, 1), 1.f);
-		meshList[GEO_CHARACTER_PROFILE4]->textureID = LoadTGA("Image//profile//kid_profile.tga");
+		meshList[GEO_CHARACTER_PROFILE4] = MeshBuilder::GenerateQuad("Kid Profile", Color(1, 1, 1), 1.f, TextureAtlas::GetUI().AcquireRegion("Image//profile//kid_profile.tga"));
 
-		meshList[GEO_CHARACTER_PROFILE5] = MeshBuilder::GenerateQuad("Old Man Profile", Color(1, 1, 1), 1.f);
-		meshList[GEO_CHARACTER_PROFILE5]->textureID = LoadTGA("Image//profile//oldman_profile.tga");
+		meshList[GEO_CHARACTER_PROFILE5] = MeshBuilder::GenerateQuad("Old Man Profile", Color(1, 1, 1), 1.f, TextureAtlas::GetUI().AcquireRegion("Image//profile//oldman_profile.tga"));
 	}
 
 	//evidence
@@ -1056,9 +926,9 @@ void CorridorScene::Render()
 	modelStack.LoadIdentity();
 
 	Position lightPosition_cameraspace = viewStack.Top() * light[0].position;
-	glUniform3fv(m_parameters[U_LIGHT0_POSITION], 1, &lightPosition_cameraspace.x);
+	glUniform3fv(m_uniforms->GetLight(0, UniformTable::LIGHT_POSITION), 1, &lightPosition_cameraspace.x);
 	Vector3 spotDirection_cameraspace = viewStack.Top() * light[0].spotDirection;
-	glUniform3fv(m_parameters[U_LIGHT0_SPOTDIRECTION], 1, &spotDirection_cameraspace.x);
+	glUniform3fv(m_uniforms->GetLight(0, UniformTable::LIGHT_SPOTDIRECTION), 1, &spotDirection_cameraspace.x);
 
 	modelStack.PushMatrix();
 	modelStack.Rotate(rotateSkybox, 0, 1, 0);
@@ -1095,11 +965,27 @@ void CorridorScene::Render()
 	}
 
 	RenderHUD();
+
+	renderer.Flush();
+}
+
+//Delete the scene's meshes, releasing the assets they share through the AssetRegistry
+void CorridorScene::ReleaseMeshes()
+{
+	for (int i = 0; i < NUM_GEOMETRY; ++i)
+	{
+		delete meshList[i];
+		meshList[i] = nullptr;
+	}
+	for (int i = 0; i < NUM_ENTITY; ++i)
+	{
+		delete entityList[i].getMesh();
+		entityList[i].setMesh(nullptr);
+	}
 }
 
 void CorridorScene::Exit()
 {
-	// Cleanup VBO here
-	glDeleteVertexArrays(1, &m_vertexArrayID);
-	glDeleteProgram(m_programID);
+	ReleaseMeshes();
+	//the program is shared, ClearShaderCache frees it
 }
\ No newline at end of file
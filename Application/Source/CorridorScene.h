@@ -6,6 +6,7 @@
 #include "Mesh.h"
 #include "MatrixStack.h"
 #include "Light.h"
+#include "UniformTable.h"
 #include "Utility.h"
 #include "LoadTGA.h"
 #include "Entity.h"
@@ -60,18 +61,7 @@ private:
 		U_MATERIAL_DIFFUSE,
 		U_MATERIAL_SPECULAR,
 		U_MATERIAL_SHININESS,
-		U_LIGHT0_POSITION,
-		U_LIGHT0_COLOR,
-		U_LIGHT0_POWER,
-		U_LIGHT0_KC,
-		U_LIGHT0_KL,
-		U_LIGHT0_KQ,
 		U_LIGHTENABLED,
-		U_LIGHT0_TYPE,
-		U_LIGHT0_SPOTDIRECTION,
-		U_LIGHT0_COSCUTOFF,
-		U_LIGHT0_COSINNER,
-		U_LIGHT0_EXPONENT,
 		U_NUMLIGHTS,
 		U_COLOR_TEXTURE_ENABLED,
 		U_COLOR_TEXTURE,
@@ -88,8 +78,8 @@ private:
 	float rotateSkybox;
 
 	unsigned m_parameters[U_TOTAL];
-	unsigned m_vertexArrayID;
-	Mesh* meshList[NUM_GEOMETRY];
+	const UniformTable* m_uniforms;
+	Mesh* meshList[NUM_GEOMETRY] = {};
 	Entity entityList[NUM_ENTITY];
 
 	unsigned m_programID;
@@ -109,10 +99,12 @@ private:
 
 	void RenderSkybox();
 	void RenderMesh(Mesh* mesh, bool enableLight);
+	void RenderMeshInstanced(Mesh* mesh, const std::vector<Mtx44>& models, bool enableLight);
 	void RenderEntity(Entity* entity, bool enableLight);
 	void RenderMeshOnScreen(Mesh* mesh, float x, float y, float sizex, float sizey);
 	void RenderText(Mesh* mesh, std::string text, Color color);
 	void RenderTextOnScreen(Mesh* mesh, std::string text, Color color, float size, float x, float y);
+	void ReleaseMeshes();
 	void RenderEvidenceObject(Entity* entity, float rangeX, float rangeY);
 	void InspectEvidenceOnScreen(Mesh* mesh, float x, float y, float sizex, float sizey, float rotatez, float rotatex);
 	void RenderPressEToInteract();
@@ -131,6 +123,7 @@ private:
 	bool IsInDoor4Interaction();
 public:
 	CorridorScene();
+	virtual void Preload();
 	virtual void Init();
 	virtual void Update(double dt);
 	virtual void Render();
@@ -0,0 +1,62 @@
+#ifndef DDS_FORMAT_H
+#define DDS_FORMAT_H
+
+/******************************************************************************/
+/*!
+		DDS file layout shared by the AssetCooker and LoadDDS:
+
+		"DDS "		magic
+		DDSHeader
+		level 0 blocks, level 1 blocks, ... down to 1x1
+
+\brief	Only DXT1 (BC1) and DXT5 (BC3) with a full mip chain are written and
+		read. Rows are stored bottom-up in the same order LoadTGA hands them
+		to OpenGL, so cooked textures map exactly like the TGA they came from.
+*/
+/******************************************************************************/
+const unsigned DDS_MAGIC = 0x20534444; // "DDS "
+const unsigned DDS_FOURCC_DXT1 = 0x31545844; // "DXT1"
+const unsigned DDS_FOURCC_DXT5 = 0x35545844; // "DXT5"
+
+const unsigned DDSD_CAPS = 0x1;
+const unsigned DDSD_HEIGHT = 0x2;
+const unsigned DDSD_WIDTH = 0x4;
+const unsigned DDSD_PIXELFORMAT = 0x1000;
+const unsigned DDSD_MIPMAPCOUNT = 0x20000;
+const unsigned DDSD_LINEARSIZE = 0x80000;
+const unsigned DDPF_FOURCC = 0x4;
+const unsigned DDSCAPS_COMPLEX = 0x8;
+const unsigned DDSCAPS_TEXTURE = 0x1000;
+const unsigned DDSCAPS_MIPMAP = 0x400000;
+
+struct DDSPixelFormat
+{
+	unsigned size;
+	unsigned flags;
+	unsigned fourCC;
+	unsigned rgbBitCount;
+	unsigned rBitMask, gBitMask, bBitMask, aBitMask;
+};
+
+struct DDSHeader
+{
+	unsigned size;
+	unsigned flags;
+	unsigned height;
+	unsigned width;
+	unsigned pitchOrLinearSize;
+	unsigned depth;
+	unsigned mipMapCount;
+	unsigned reserved1[11];
+	DDSPixelFormat pixelFormat;
+	unsigned caps, caps2, caps3, caps4;
+	unsigned reserved2;
+};
+
+//Bytes in one mip level of a block-compressed texture
+inline unsigned DDSLevelSize(unsigned width, unsigned height, unsigned blockBytes)
+{
+	return ((width + 3) / 4) * ((height + 3) / 4) * blockBytes;
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef DIALOGUE_FORMAT_H
+#define DIALOGUE_FORMAT_H
+
+/******************************************************************************/
+/*!
+		Dialogue table layout shared by the AssetCooker and DialogueTable:
+
+		DialogueHeader
+		DialogueConversation[conversationCount]
+		DialogueLine[lineCount]
+		text		conversation names and line text, not terminated
+
+\brief	One conversation per Text/<name>.txt, named after the file. Each
+		"S:text" line of the file becomes a DialogueLine with speaker tag 'S'.
+		Offsets are relative to the start of the text block.
+*/
+/******************************************************************************/
+const unsigned DIALOGUE_MAGIC = 0x44325053; // "SP2D"
+const unsigned DIALOGUE_VERSION = 1;
+
+struct DialogueHeader
+{
+	unsigned magic;
+	unsigned version;
+	unsigned conversationCount;
+	unsigned lineCount;
+	unsigned textSize;
+};
+
+struct DialogueConversation
+{
+	unsigned nameOffset;
+	unsigned nameLength;
+	unsigned firstLine;
+	unsigned lineCount;
+};
+
+struct DialogueLine
+{
+	unsigned offset;
+	unsigned short length;
+	char speaker;
+	char padding;
+};
+
+#endif
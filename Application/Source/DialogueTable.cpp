@@ -0,0 +1,93 @@
+#include <iostream>
+
+#include "DialogueTable.h"
+
+DialogueTable::DialogueTable()
+	: header(nullptr), conversations(nullptr), lines(nullptr), text(nullptr)
+{
+}
+
+/******************************************************************************/
+/*!
+\brief
+The table cooked from Text/. Mapped on first use and kept for the whole run,
+so conversations looked up from it never dangle.
+*/
+/******************************************************************************/
+const DialogueTable& DialogueTable::Get()
+{
+	static DialogueTable table;
+	static bool loaded = table.Load("Text//Dialogue.dlg");
+	(void)loaded;
+	return table;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Map a table and check its index against the file size
+
+\return false if the file is missing, from another version or truncated
+*/
+/******************************************************************************/
+bool DialogueTable::Load(const char* file_path)
+{
+	header = nullptr;
+	if (!file.Open(file_path))
+	{
+		std::cout << "Impossible to open " << file_path << ". Did the AssetCooker run?\n";
+		return false;
+	}
+
+	const char* data = file.GetData();
+	size_t size = file.GetSize();
+	const DialogueHeader* candidate = (const DialogueHeader*)data;
+	if (size < sizeof(DialogueHeader) || candidate->magic != DIALOGUE_MAGIC || candidate->version != DIALOGUE_VERSION)
+	{
+		std::cout << file_path << " is not a version " << DIALOGUE_VERSION << " dialogue table\n";
+		file.Close();
+		return false;
+	}
+
+	size_t indexSize = sizeof(DialogueHeader) + candidate->conversationCount * sizeof(DialogueConversation)
+		+ candidate->lineCount * sizeof(DialogueLine);
+	if (size < indexSize || size - indexSize < candidate->textSize)
+	{
+		std::cout << file_path << " is truncated\n";
+		file.Close();
+		return false;
+	}
+
+	header = candidate;
+	conversations = (const DialogueConversation*)(data + sizeof(DialogueHeader));
+	lines = (const DialogueLine*)(conversations + header->conversationCount);
+	text = (const char*)(lines + header->lineCount);
+	return true;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Look up a conversation by the name of the file it was compiled from
+
+\param name - file name without extension, e.g. "GuardChat"
+*/
+/******************************************************************************/
+DialogueTable::Conversation DialogueTable::Find(const char* name) const
+{
+	Conversation result;
+	if (header == nullptr)
+		return result;
+
+	for (unsigned i = 0; i < header->conversationCount; ++i)
+	{
+		const DialogueConversation& conversation = conversations[i];
+		if (StringView(text + conversation.nameOffset, conversation.nameLength) != name)
+			continue;
+		result.lines = lines + conversation.firstLine;
+		result.lineCount = conversation.lineCount;
+		result.text = text;
+		break;
+	}
+	return result;
+}
@@ -0,0 +1,58 @@
+#ifndef DIALOGUE_TABLE_H
+#define DIALOGUE_TABLE_H
+
+#include "MappedFile.h"
+#include "StringView.h"
+#include "DialogueFormat.h"
+
+/******************************************************************************/
+/*!
+		Class DialogueTable:
+\brief	Every conversation in Text/, compiled by "AssetCooker dialogue" into
+		one file that is mapped once. Lines are views into the mapping, so
+		looking up a conversation allocates nothing.
+*/
+/******************************************************************************/
+class DialogueTable
+{
+public:
+	/******************************************************************************/
+	/*!
+			Class Conversation:
+	\brief	The lines of one dialogue file. Empty if the file is not in the table.
+	*/
+	/******************************************************************************/
+	class Conversation
+	{
+	public:
+		Conversation() : lines(nullptr), lineCount(0), text(nullptr) {}
+
+		unsigned GetLineCount() const { return lineCount; }
+		//'D' for the detective, otherwise the tag of the person talking
+		char GetSpeaker(unsigned line) const { return lines[line].speaker; }
+		StringView GetText(unsigned line) const { return StringView(text + lines[line].offset, lines[line].length); }
+
+	private:
+		friend class DialogueTable;
+
+		const DialogueLine* lines;
+		unsigned lineCount;
+		const char* text;
+	};
+
+	DialogueTable();
+
+	static const DialogueTable& Get();
+
+	bool Load(const char* file_path);
+	Conversation Find(const char* name) const;
+
+private:
+	MappedFile file;
+	const DialogueHeader* header;
+	const DialogueConversation* conversations;
+	const DialogueLine* lines;
+	const char* text;
+};
+
+#endif
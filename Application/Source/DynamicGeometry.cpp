@@ -0,0 +1,140 @@
+#include <iostream>
+#include <algorithm>
+#include <GL\glew.h>
+
+#include "DynamicGeometry.h"
+#include "VertexFormat.h"
+#include "Mesh.h"
+
+//Vertices in the ring; a frame of UI is a few hundred
+static const unsigned RING_VERTICES = 16384;
+
+unsigned DynamicGeometry::vertexArray = 0;
+unsigned DynamicGeometry::vertexBuffer = 0;
+unsigned DynamicGeometry::cursor = 0;
+
+/******************************************************************************/
+/*!
+\brief
+Draw vertices that only live for this draw
+
+\param mode - GL primitive, e.g. GL_TRIANGLES
+*/
+/******************************************************************************/
+void DynamicGeometry::Draw(unsigned mode, const Vertex* vertices, unsigned count)
+{
+	unsigned first;
+	Vertex* out = Map(count, first);
+	if (out == nullptr)
+		return;
+	std::copy(vertices, vertices + count, out);
+	Unmap(mode, first, count);
+}
+
+//The same unit quad as MeshBuilder::GenerateQuad, without a mesh
+void DynamicGeometry::DrawQuad(Color color, float size)
+{
+	AtlasRegion wholeTexture = { 0, 0.f, 0.f, 1.f, 1.f };
+	DrawQuad(color, size, wholeTexture);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Draw a quad of the given color and size centred on the origin. The region's
+texture is not bound; only its UVs are used.
+*/
+/******************************************************************************/
+void DynamicGeometry::DrawQuad(Color color, float size, const AtlasRegion& region)
+{
+	unsigned first;
+	Vertex* out = Map(6, first);
+	if (out == nullptr)
+		return;
+
+	float half = size * 0.5f;
+	const float corners[4][4] =
+	{
+		{ half, half, region.u1, region.v1 },	//top right
+		{ -half, half, region.u0, region.v1 },	//top left
+		{ -half, -half, region.u0, region.v0 },	//bottom left
+		{ half, -half, region.u1, region.v0 },	//bottom right
+	};
+	const unsigned order[6] = { 0, 1, 2, 0, 2, 3 };
+	for (unsigned i = 0; i < 6; ++i)
+	{
+		const float* corner = corners[order[i]];
+		out[i].pos.Set(corner[0], corner[1], 0.f);
+		out[i].color = color;
+		out[i].normal.Set(0.f, 0.f, 1.f);
+		out[i].texCoord.Set(corner[2], corner[3]);
+	}
+	Unmap(GL_TRIANGLES, first, 6);
+}
+
+//Delete the ring. Called at exit while the context still exists.
+void DynamicGeometry::Release()
+{
+	glDeleteVertexArrays(1, &vertexArray);
+	glDeleteBuffers(1, &vertexBuffer);
+	vertexArray = 0;
+	vertexBuffer = 0;
+	cursor = 0;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Map space for count vertices. Ranges already handed out are never written
+again until the buffer is orphaned, which is what makes the unsynchronized
+map safe.
+
+\param out_first - receives the first vertex to draw from
+
+\return where to write the vertices, nullptr if they can never fit or the
+	buffer could not be mapped
+*/
+/******************************************************************************/
+Vertex* DynamicGeometry::Map(unsigned count, unsigned& out_first)
+{
+	if (count == 0 || count > RING_VERTICES)
+		return nullptr;
+
+	if (vertexArray == 0)
+	{
+		glGenVertexArrays(1, &vertexArray);
+		glGenBuffers(1, &vertexBuffer);
+		glBindVertexArray(vertexArray);
+		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, RING_VERTICES * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+		VertexFormat::Get(VertexFormat::FORMAT_FLOAT).Apply();
+		cursor = 0;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+
+	GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+	if (cursor + count > RING_VERTICES)
+	{
+		//the GPU may still be reading the old storage; let the driver swap in fresh storage
+		glBufferData(GL_ARRAY_BUFFER, RING_VERTICES * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+		cursor = 0;
+	}
+
+	Vertex* out = (Vertex*)glMapBufferRange(GL_ARRAY_BUFFER, cursor * sizeof(Vertex), count * sizeof(Vertex), access);
+	if (out == nullptr)
+	{
+		std::cout << "DynamicGeometry: could not map " << count << " vertices.\n";
+		return nullptr;
+	}
+	out_first = cursor;
+	cursor += count;
+	return out;
+}
+
+void DynamicGeometry::Unmap(unsigned mode, unsigned first, unsigned count)
+{
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+	glBindVertexArray(vertexArray);
+	Mesh::BindDefaultMaterials();
+	glDrawArrays(mode, first, count);
+}
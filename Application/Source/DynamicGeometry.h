@@ -0,0 +1,37 @@
+#ifndef DYNAMIC_GEOMETRY_H
+#define DYNAMIC_GEOMETRY_H
+
+#include "Vertex.h"
+#include "TextureAtlas.h"
+
+/******************************************************************************/
+/*!
+		Class DynamicGeometry:
+\brief	Draws geometry that changes every frame (UI panels, minigame quads)
+		from one ring buffer instead of creating meshes for it. Each draw
+		writes its vertices to the next free range with an unsynchronized
+		map, so the GPU is never waited on; when the ring is full the buffer
+		is orphaned and writing starts again from the front.
+
+		Vertices are in FORMAT_FLOAT and drawn with the uniforms already set,
+		like Mesh::Render.
+*/
+/******************************************************************************/
+class DynamicGeometry
+{
+public:
+	static void Draw(unsigned mode, const Vertex* vertices, unsigned count);
+	static void DrawQuad(Color color, float size = 1.f);
+	static void DrawQuad(Color color, float size, const AtlasRegion& region);
+	static void Release();
+
+private:
+	static Vertex* Map(unsigned count, unsigned& out_first);
+	static void Unmap(unsigned mode, unsigned first, unsigned count);
+
+	static unsigned vertexArray;
+	static unsigned vertexBuffer;
+	static unsigned cursor; //next free vertex in the ring
+};
+
+#endif
@@ -72,3 +72,22 @@ void Entity::setPinable(bool pin)
 {
 	pinable = pin;
 }
+
+//The model matrix RenderEntity draws with, which scales uniformly by scale.x
+Mtx44 Entity::getModelMatrix()
+{
+	Mtx44 translation, rotation, scaling;
+	translation.SetToTranslation(transform.x, transform.y, transform.z);
+	rotation.SetToRotation(rotationAngle, rotationAxis.x, rotationAxis.y, rotationAxis.z);
+	scaling.SetToScale(scale.x, scale.x, scale.x);
+	return translation * rotation * scaling;
+}
+
+//Bounds of the mesh in world space; empty bounds at the entity's position without a mesh
+MeshBounds Entity::getWorldBounds()
+{
+	MeshBounds bounds;
+	if (mesh != nullptr)
+		bounds = mesh->bounds;
+	return bounds.Transform(getModelMatrix());
+}
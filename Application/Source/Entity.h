@@ -38,5 +38,8 @@ public:
 
 	bool getPinable();
 	void setPinable(bool pin);
+
+	Mtx44 getModelMatrix();
+	MeshBounds getWorldBounds();
 };
 
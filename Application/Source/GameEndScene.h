@@ -48,8 +48,7 @@ private:
 	MS modelStack, viewStack, projectionStack;
 
 	unsigned m_parameters[U_TOTAL];
-	unsigned m_vertexArrayID;
-	Mesh* meshList[NUM_GEOMETRY];
+	Mesh* meshList[NUM_GEOMETRY] = {};
 
 	unsigned m_programID;
 
@@ -63,6 +62,7 @@ private:
 	void RenderMeshOnScreen(Mesh* mesh, float x, float y, float sizex, float sizey);
 	void RenderText(Mesh* mesh, std::string text, Color color);
 	void RenderTextOnScreen(Mesh* mesh, std::string text, Color color, float size, float x, float y);
+	void ReleaseMeshes();
 	bool CreateButton(float buttonTop, float buttonBottom, float buttonRight, float buttonLeft);
 	void RenderGameOver();
 	bool winstate;
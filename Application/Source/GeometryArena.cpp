@@ -0,0 +1,188 @@
+#include <GL\glew.h>
+
+#include "GeometryArena.h"
+
+//Page sizes. Every level and character mesh fits in one page; a larger mesh
+//gets a page of its own size.
+static const unsigned PAGE_VERTEX_BYTES = 4 * 1024 * 1024;
+static const unsigned PAGE_INDEX_BYTES = 1024 * 1024;
+
+std::vector<GeometryArena::Page*> GeometryArena::pages;
+
+//First free range with room for bytes, ranges.size() if there is none
+static size_t FindRange(const std::vector<GeometryArena::Range>& ranges, unsigned bytes)
+{
+	for (size_t i = 0; i < ranges.size(); ++i)
+	{
+		if (ranges[i].bytes >= bytes)
+			return i;
+	}
+	return ranges.size();
+}
+
+static bool HasRoom(const std::vector<GeometryArena::Range>& ranges, unsigned used, unsigned capacity, unsigned bytes)
+{
+	return FindRange(ranges, bytes) < ranges.size() || capacity - used >= bytes;
+}
+
+//Take bytes from a free range, or from the end of the used space
+static unsigned TakeRange(std::vector<GeometryArena::Range>& ranges, unsigned& used, unsigned bytes)
+{
+	size_t i = FindRange(ranges, bytes);
+	if (i == ranges.size())
+	{
+		unsigned offset = used;
+		used += bytes;
+		return offset;
+	}
+	unsigned offset = ranges[i].offset;
+	ranges[i].offset += bytes;
+	ranges[i].bytes -= bytes;
+	if (ranges[i].bytes == 0)
+		ranges.erase(ranges.begin() + i);
+	return offset;
+}
+
+//Put a range back, merging it with free neighbours. A range that ends at the
+//used space shrinks it instead.
+static void GiveRange(std::vector<GeometryArena::Range>& ranges, unsigned& used, unsigned offset, unsigned bytes)
+{
+	if (bytes == 0)
+		return;
+	size_t i = 0;
+	while (i < ranges.size() && ranges[i].offset < offset)
+		++i;
+
+	GeometryArena::Range range = { offset, bytes };
+	if (i > 0 && ranges[i - 1].offset + ranges[i - 1].bytes == offset)
+	{
+		--i;
+		range.offset = ranges[i].offset;
+		range.bytes += ranges[i].bytes;
+		ranges.erase(ranges.begin() + i);
+	}
+	if (i < ranges.size() && range.offset + range.bytes == ranges[i].offset)
+	{
+		range.bytes += ranges[i].bytes;
+		ranges.erase(ranges.begin() + i);
+	}
+
+	if (range.offset + range.bytes == used)
+		used = range.offset;
+	else
+		ranges.insert(ranges.begin() + i, range);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Copy a mesh into a page with room for it, creating one if needed
+
+\param format - format the vertices are encoded in
+\param indexType - GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, indices relative to
+	the mesh's first vertex
+
+\return where the mesh was placed. Draw it from page->vertexArray with
+	firstIndex and baseVertex.
+*/
+/******************************************************************************/
+GeometryArena::Allocation GeometryArena::Allocate(VertexFormat::TYPE format, unsigned indexType,
+	const void* vertices, unsigned vertexCount, const void* indices, unsigned indexCount)
+{
+	unsigned indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+	unsigned vertexBytes = vertexCount * VertexFormat::Get(format).stride;
+	unsigned indexBytes = indexCount * indexSize;
+
+	Page* page = FindPage(format, indexType, vertexBytes, indexBytes);
+	unsigned vertexOffset = TakeRange(page->freeVertices, page->vertexUsed, vertexBytes);
+	unsigned indexOffset = TakeRange(page->freeIndices, page->indexUsed, indexBytes);
+	Allocation allocation = { page, (int)(vertexOffset / VertexFormat::Get(format).stride), indexOffset / indexSize, vertexBytes, indexBytes };
+
+	glBindBuffer(GL_ARRAY_BUFFER, page->vertexBuffer);
+	glBufferSubData(GL_ARRAY_BUFFER, vertexOffset, vertexBytes, vertices);
+	//GL_ELEMENT_ARRAY_BUFFER would change whichever VAO is bound
+	glBindBuffer(GL_COPY_WRITE_BUFFER, page->indexBuffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, indexOffset, indexBytes, indices);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	++page->liveCount;
+	return allocation;
+}
+
+//Give a mesh's space back to its page's free lists. The page is rewound once it is empty.
+void GeometryArena::Free(const Allocation& allocation)
+{
+	Page* page = allocation.page;
+	if (page == nullptr || page->liveCount == 0)
+		return;
+	if (--page->liveCount == 0)
+	{
+		page->vertexUsed = 0;
+		page->indexUsed = 0;
+		page->freeVertices.clear();
+		page->freeIndices.clear();
+		return;
+	}
+	unsigned indexSize = page->indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+	GiveRange(page->freeVertices, page->vertexUsed, allocation.baseVertex * VertexFormat::Get(page->format).stride, allocation.vertexBytes);
+	GiveRange(page->freeIndices, page->indexUsed, allocation.firstIndex * indexSize, allocation.indexBytes);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Delete every page. Called at exit once the meshes drawn from them are gone.
+*/
+/******************************************************************************/
+void GeometryArena::Clear()
+{
+	for (size_t i = 0; i < pages.size(); ++i)
+	{
+		glDeleteVertexArrays(1, &pages[i]->vertexArray);
+		glDeleteBuffers(1, &pages[i]->vertexBuffer);
+		glDeleteBuffers(1, &pages[i]->indexBuffer);
+		delete pages[i];
+	}
+	pages.clear();
+}
+
+GeometryArena::Page* GeometryArena::FindPage(VertexFormat::TYPE format, unsigned indexType, unsigned vertexBytes, unsigned indexBytes)
+{
+	for (size_t i = 0; i < pages.size(); ++i)
+	{
+		Page* page = pages[i];
+		if (page->format == format && page->indexType == indexType &&
+			HasRoom(page->freeVertices, page->vertexUsed, page->vertexCapacity, vertexBytes) &&
+			HasRoom(page->freeIndices, page->indexUsed, page->indexCapacity, indexBytes))
+			return page;
+	}
+	return CreatePage(format, indexType, vertexBytes, indexBytes);
+}
+
+//A page's VAO records the format once; every mesh in the page draws through it
+GeometryArena::Page* GeometryArena::CreatePage(VertexFormat::TYPE format, unsigned indexType, unsigned vertexBytes, unsigned indexBytes)
+{
+	Page* page = new Page;
+	page->format = format;
+	page->indexType = indexType;
+	page->vertexCapacity = vertexBytes > PAGE_VERTEX_BYTES ? vertexBytes : PAGE_VERTEX_BYTES;
+	page->indexCapacity = indexBytes > PAGE_INDEX_BYTES ? indexBytes : PAGE_INDEX_BYTES;
+	page->vertexUsed = 0;
+	page->indexUsed = 0;
+	page->liveCount = 0;
+
+	glGenVertexArrays(1, &page->vertexArray);
+	glGenBuffers(1, &page->vertexBuffer);
+	glGenBuffers(1, &page->indexBuffer);
+
+	glBindVertexArray(page->vertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, page->vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, page->vertexCapacity, nullptr, GL_STATIC_DRAW);
+	VertexFormat::Get(format).Apply();
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, page->indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, page->indexCapacity, nullptr, GL_STATIC_DRAW);
+	glBindVertexArray(0);
+
+	pages.push_back(page);
+	return page;
+}
@@ -0,0 +1,63 @@
+#ifndef GEOMETRY_ARENA_H
+#define GEOMETRY_ARENA_H
+
+#include <vector>
+#include "VertexFormat.h"
+
+/******************************************************************************/
+/*!
+		Class GeometryArena:
+\brief	Sub-allocates static meshes from a few large vertex/index buffers.
+		Each page holds meshes of one vertex format and index type behind one
+		VAO, so consecutive draws from a page need no buffer or VAO changes.
+		Meshes are drawn with glDrawElementsBaseVertex, which keeps their
+		indices relative to their own first vertex (and 16 bit).
+
+		Space is bump allocated from the end of a page. Freed ranges go on
+		the page's free lists, merged with free neighbours, and are reused
+		first fit, so scenes that come and go can share a page with registry
+		geometry that lives until exit.
+*/
+/******************************************************************************/
+class GeometryArena
+{
+public:
+	struct Range
+	{
+		unsigned offset, bytes;
+	};
+
+	struct Page
+	{
+		VertexFormat::TYPE format;
+		unsigned indexType;
+		unsigned vertexArray;
+		unsigned vertexBuffer;
+		unsigned indexBuffer;
+		unsigned vertexCapacity, indexCapacity;	//bytes
+		unsigned vertexUsed, indexUsed;			//bytes
+		unsigned liveCount;
+		std::vector<Range> freeVertices, freeIndices; //sorted by offset, never adjacent
+	};
+
+	struct Allocation
+	{
+		Page* page;			//nullptr if nothing is allocated
+		int baseVertex;
+		unsigned firstIndex;
+		unsigned vertexBytes, indexBytes;
+	};
+
+	static Allocation Allocate(VertexFormat::TYPE format, unsigned indexType,
+		const void* vertices, unsigned vertexCount, const void* indices, unsigned indexCount);
+	static void Free(const Allocation& allocation);
+	static void Clear();
+
+private:
+	static Page* FindPage(VertexFormat::TYPE format, unsigned indexType, unsigned vertexBytes, unsigned indexBytes);
+	static Page* CreatePage(VertexFormat::TYPE format, unsigned indexType, unsigned vertexBytes, unsigned indexBytes);
+
+	static std::vector<Page*> pages;
+};
+
+#endif
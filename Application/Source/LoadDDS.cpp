@@ -0,0 +1,114 @@
+#include <iostream>
+#include <cstring>
+#include <GL\glew.h>
+
+#include "LoadDDS.h"
+#include "DDSFormat.h"
+#include "MappedFile.h"
+
+//"Image//front.tga" -> "Image//front.dds"
+std::string GetDDSPath(const std::string& tga_path)
+{
+	size_t dot = tga_path.find_last_of('.');
+	size_t slash = tga_path.find_last_of("/\\");
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+		return tga_path + ".dds";
+	return tga_path.substr(0, dot) + ".dds";
+}
+
+/******************************************************************************/
+/*!
+\brief
+Read a DXT1/DXT5 DDS written by the AssetCooker. Makes no GL calls, so it can
+run on a worker thread. Missing files fail quietly, since the caller falls
+back to the TGA.
+*/
+/******************************************************************************/
+bool DecodeDDS(const char *file_path, DDSImage& image)
+{
+	MappedFile file;
+	if (!file.Open(file_path))
+		return false;
+
+	unsigned magic;
+	DDSHeader header;
+	if (file.GetSize() < sizeof(magic) + sizeof(header))
+		return false;
+	memcpy(&magic, file.GetData(), sizeof(magic));
+	memcpy(&header, file.GetData() + sizeof(magic), sizeof(header));
+	if (magic != DDS_MAGIC || header.size != sizeof(DDSHeader) ||
+		!(header.pixelFormat.flags & DDPF_FOURCC) || header.width == 0 || header.height == 0)
+	{
+		std::cout << file_path << " is not a cooked DDS texture.\n";
+		return false;
+	}
+
+	if (header.pixelFormat.fourCC == DDS_FOURCC_DXT1)
+		image.blockBytes = 8;
+	else if (header.pixelFormat.fourCC == DDS_FOURCC_DXT5)
+		image.blockBytes = 16;
+	else
+	{
+		std::cout << file_path << " uses an unsupported DDS format.\n";
+		return false;
+	}
+
+	image.width = header.width;
+	image.height = header.height;
+	image.levelCount = (header.flags & DDSD_MIPMAPCOUNT) && header.mipMapCount > 0 ? header.mipMapCount : 1;
+
+	size_t dataSize = 0;
+	for (unsigned level = 0, w = image.width, h = image.height; level < image.levelCount; ++level)
+	{
+		dataSize += DDSLevelSize(w, h, image.blockBytes);
+		w = w > 1 ? w / 2 : 1;
+		h = h > 1 ? h / 2 : 1;
+	}
+	size_t offset = sizeof(magic) + sizeof(header);
+	if (file.GetSize() < offset + dataSize)
+	{
+		std::cout << file_path << " is truncated.\n";
+		return false;
+	}
+	image.blocks.assign(file.GetData() + offset, file.GetData() + offset + dataSize);
+	return true;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Create a texture from a decoded DDS, uploading every prebuilt mip level
+as-is. Main thread only.
+*/
+/******************************************************************************/
+GLuint UploadDDS(const DDSImage& image)
+{
+	GLuint texture = 0;
+	float maxAnisotropy = 1.f;
+	GLenum format = image.blockBytes == 8 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	const unsigned char* blocks = &image.blocks[0];
+	for (unsigned level = 0, w = image.width, h = image.height; level < image.levelCount; ++level)
+	{
+		unsigned size = DDSLevelSize(w, h, image.blockBytes);
+		glCompressedTexImage2D(GL_TEXTURE_2D, level, format, w, h, 0, size, blocks);
+		blocks += size;
+		w = w > 1 ? w / 2 : 1;
+		h = h > 1 ? h / 2 : 1;
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image.levelCount - 1);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, image.levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, (GLint)maxAnisotropy);
+
+	return texture;
+}
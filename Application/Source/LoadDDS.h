@@ -0,0 +1,27 @@
+#ifndef LOAD_DDS_H
+#define LOAD_DDS_H
+
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+
+struct DDSImage
+{
+	unsigned width, height;
+	unsigned levelCount;
+	unsigned blockBytes; //8 for DXT1, 16 for DXT5
+	std::vector<unsigned char> blocks; //every level back to back
+};
+
+std::string GetDDSPath(const std::string& tga_path);
+
+bool DecodeDDS(const char *file_path, DDSImage& image);
+GLuint UploadDDS(const DDSImage& image);
+
+//The cooker only writes DXT5 for images with alpha below 255
+inline bool IsTranslucentDDS(const DDSImage& image)
+{
+	return image.blockBytes == 16;
+}
+
+#endif
@@ -1,152 +1,649 @@
 #include <iostream>
-#include <fstream>
 #include <map>
+#include <string>
+#include <cstring>
 
 #include "LoadOBJ.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
 
-bool LoadOBJ(
-	const char* file_path,
-	std::vector<Position>& out_vertices,
-	std::vector<TexCoord>& out_uvs,
-	std::vector<Vector3>& out_normals
-)
+/******************************************************************************/
+/*!
+		OBJ/MTL text scanning
+
+\brief	The loaders map the whole file and walk it line by line with the
+		helpers below, so there is no per-line copy, no line length limit and
+		no dependency on sscanf_s/strcpy_s.
+*/
+/******************************************************************************/
+static const unsigned NO_INDEX = 0xFFFFFFFFu;
+
+static inline bool IsSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+}
+
+static inline bool IsDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+static inline const char* SkipSpaces(const char* p, const char* end)
+{
+	while (p < end && IsSpace(*p))
+		++p;
+	return p;
+}
+
+static inline const char* FindLineEnd(const char* p, const char* end)
 {
-	//Fill up code from OBJ lecture notes
-	std::ifstream fileStream(file_path, std::ios::binary);
-	if (!fileStream.is_open())
+	const char* newline = (const char*)memchr(p, '\n', end - p);
+	return newline ? newline : end;
+}
+
+static const double powersOf10[] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/******************************************************************************/
+/*!
+\brief
+Parse a decimal floating point number ("-1.5", ".25", "3e-2") after optional
+spaces. Up to 19 significant digits are accumulated exactly and scaled by an
+exact power of ten, which is well within float precision.
+
+\return pointer past the number, or nullptr if there is no number
+*/
+/******************************************************************************/
+static const char* ParseFloat(const char* p, const char* end, float& out)
+{
+	p = SkipSpaces(p, end);
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
 	{
-		std::cout << "Impossible to open " << file_path << ". Are you in the right directory ?\n";
-		return false;
+		negative = (*p == '-');
+		++p;
 	}
-	std::vector<unsigned> vertexIndices, uvIndices, normalIndices;
-	std::vector<Position> temp_vertices;
-	std::vector<TexCoord> temp_uvs;
-	std::vector<Vector3> temp_normals;
-	while (!fileStream.eof()) {
-		char buf[256];
-		fileStream.getline(buf, 256);
-		if (strncmp("v ", buf, 2) == 0) { //process vertex position
-			//Exercise 2
-			Position vertex;
-			sscanf_s((buf + 2), "%f%f%f", &vertex.x, &vertex.y, &vertex.z);
-			temp_vertices.push_back(vertex);
+
+	unsigned long long mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	bool hasDigits = false;
+	for (; p < end && IsDigit(*p); ++p)
+	{
+		hasDigits = true;
+		if (digits < 19)
+		{
+			mantissa = mantissa * 10 + (*p - '0');
+			if (mantissa != 0)
+				++digits;
+		}
+		else
+		{
+			++exponent;
 		}
-		else if (strncmp("vt ", buf, 3) == 0) { //process texcoord
-			//Exercise 2
-			TexCoord tc;
-			sscanf_s((buf + 2), "%f%f", &tc.u, &tc.v);
-			temp_uvs.push_back(tc);
+	}
+	if (p < end && *p == '.')
+	{
+		for (++p; p < end && IsDigit(*p); ++p)
+		{
+			hasDigits = true;
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				if (mantissa != 0)
+					++digits;
+				--exponent;
+			}
 		}
-		else if (strncmp("vn ", buf, 3) == 0) { //process normal
-			//Exercise 2
-			Vector3 normal;
-			sscanf_s((buf + 2), "%f%f%f", &normal.x, &normal.y, &normal.z);
-			temp_normals.push_back(normal);
+	}
+	if (!hasDigits)
+		return nullptr;
+
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		const char* q = p + 1;
+		bool negativeExponent = false;
+		if (q < end && (*q == '-' || *q == '+'))
+		{
+			negativeExponent = (*q == '-');
+			++q;
+		}
+		if (q < end && IsDigit(*q))
+		{
+			int value = 0;
+			for (; q < end && IsDigit(*q); ++q)
+			{
+				if (value < 10000)
+					value = value * 10 + (*q - '0');
+			}
+			exponent += negativeExponent ? -value : value;
+			p = q;
+		}
+	}
+
+	double value = (double)mantissa;
+	if (mantissa != 0)
+	{
+		while (exponent > 22)
+		{
+			value *= 1e22;
+			exponent -= 22;
+		}
+		while (exponent < -22)
+		{
+			value /= 1e22;
+			exponent += 22;
+		}
+		if (exponent >= 0)
+			value *= powersOf10[exponent];
+		else
+			value /= powersOf10[-exponent];
+	}
+	out = (float)(negative ? -value : value);
+	return p;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Parse a signed decimal integer with no leading spaces
+
+\return pointer past the number, or nullptr if there is no number
+*/
+/******************************************************************************/
+static const char* ParseInt(const char* p, const char* end, int& out)
+{
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		negative = (*p == '-');
+		++p;
+	}
+	if (p >= end || !IsDigit(*p))
+		return nullptr;
+	long long value = 0;
+	for (; p < end && IsDigit(*p); ++p)
+	{
+		if (value < 0x7FFFFFFF)
+			value = value * 10 + (*p - '0');
+	}
+	if (value > 0x7FFFFFFF)
+		value = 0x7FFFFFFF;
+	out = (int)(negative ? -value : value);
+	return p;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Return the rest of the line as a name with surrounding whitespace (and any
+'\r' from CRLF files) removed
+*/
+/******************************************************************************/
+static std::string ParseName(const char* p, const char* lineEnd)
+{
+	p = SkipSpaces(p, lineEnd);
+	const char* nameEnd = lineEnd;
+	while (nameEnd > p && IsSpace(nameEnd[-1]))
+		--nameEnd;
+	return std::string(p, nameEnd);
+}
+
+//True if the line starts with the keyword followed by whitespace
+static inline bool IsKeyword(const char* p, const char* lineEnd, const char* keyword, size_t length)
+{
+	return (size_t)(lineEnd - p) > length && memcmp(p, keyword, length) == 0 && IsSpace(p[length]);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Convert an OBJ index (1-based, or negative meaning relative to the current end
+of the list) to a 0-based index
+
+\return false if the index is 0 or points before the start of the list
+*/
+/******************************************************************************/
+static inline bool ResolveIndex(int index, unsigned count, unsigned& out)
+{
+	if (index > 0)
+	{
+		out = (unsigned)(index - 1);
+		return true;
+	}
+	if (index < 0 && (unsigned)(-(long long)index) <= count)
+	{
+		out = count - (unsigned)(-(long long)index);
+		return true;
+	}
+	return false;
+}
+
+/******************************************************************************/
+/*!
+		Struct OBJChunk:
+\brief	Everything parsed from a range of lines of an OBJ file. Face corners
+		are already triangulated and hold 0-based indices into the whole file's
+		position/texcoord/normal lists, or NO_INDEX when the face omits that
+		attribute.
+*/
+/******************************************************************************/
+struct OBJChunk
+{
+	std::vector<Position> positions;
+	std::vector<TexCoord> uvs;
+	std::vector<Vector3> normals;
+	std::vector<unsigned> vertexIndices, uvIndices, normalIndices;
+	std::vector<Material> materials;
+	unsigned leadingIndexCount; //corners emitted before the first usemtl in this chunk
+
+	OBJChunk() : leadingIndexCount(0) {}
+};
+
+/******************************************************************************/
+/*!
+\brief
+Parse v/vt/vn/f/usemtl records between begin and end
+
+\param begin - first character of the range, must be the start of a line
+\param end - one past the last character of the range
+\param basePositions - number of positions defined before this range
+\param baseUVs - number of texcoords defined before this range
+\param baseNormals - number of normals defined before this range
+\param materials_map - materials from the MTL file, nullptr to ignore usemtl
+\param chunk - receives the parsed data
+
+\return false if a face could not be read
+*/
+/******************************************************************************/
+static bool ParseOBJChunk(const char* begin, const char* end,
+	unsigned basePositions, unsigned baseUVs, unsigned baseNormals,
+	const std::map<std::string, Material*>* materials_map,
+	OBJChunk& chunk)
+{
+	struct Corner
+	{
+		unsigned vertex, uv, normal;
+	};
+	std::vector<Corner> corners;
+
+	for (const char* line = begin; line < end; )
+	{
+		const char* lineEnd = FindLineEnd(line, end);
+		const char* p = SkipSpaces(line, lineEnd);
+		const char* next = lineEnd + 1;
+
+		if (p + 1 < lineEnd && p[0] == 'v')
+		{
+			if (IsSpace(p[1])) //process vertex position
+			{
+				Position vertex;
+				const char* q = ParseFloat(p + 2, lineEnd, vertex.x);
+				if (q) q = ParseFloat(q, lineEnd, vertex.y);
+				if (q) q = ParseFloat(q, lineEnd, vertex.z);
+				chunk.positions.push_back(vertex);
+			}
+			else if (IsKeyword(p, lineEnd, "vt", 2)) //process texcoord
+			{
+				TexCoord tc;
+				const char* q = ParseFloat(p + 3, lineEnd, tc.u);
+				if (q) q = ParseFloat(q, lineEnd, tc.v);
+				chunk.uvs.push_back(tc);
+			}
+			else if (IsKeyword(p, lineEnd, "vn", 2)) //process normal
+			{
+				Vector3 normal;
+				const char* q = ParseFloat(p + 3, lineEnd, normal.x);
+				if (q) q = ParseFloat(q, lineEnd, normal.y);
+				if (q) q = ParseFloat(q, lineEnd, normal.z);
+				chunk.normals.push_back(normal);
+			}
 		}
-		else if (strncmp("f ", buf, 2) == 0) { //process face
-			unsigned int vertexIndex[4], uvIndex[4], normalIndex[4];
-			int matches = sscanf_s((buf + 2), "%d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n",
-				&vertexIndex[0], &uvIndex[0], &normalIndex[0],
-				&vertexIndex[1], &uvIndex[1], &normalIndex[1],
-				&vertexIndex[2], &uvIndex[2], &normalIndex[2],
-				&vertexIndex[3], &uvIndex[3], &normalIndex[3]);
-
-			if (matches == 9) //triangle
+		else if (p + 1 < lineEnd && p[0] == 'f' && IsSpace(p[1])) //process face
+		{
+			unsigned positionCount = basePositions + (unsigned)chunk.positions.size();
+			unsigned uvCount = baseUVs + (unsigned)chunk.uvs.size();
+			unsigned normalCount = baseNormals + (unsigned)chunk.normals.size();
+			bool valid = true;
+			corners.clear();
+
+			const char* q = SkipSpaces(p + 2, lineEnd);
+			while (valid && q < lineEnd)
 			{
-				//Exercise 2
-				vertexIndices.push_back(vertexIndex[0]);
-				vertexIndices.push_back(vertexIndex[1]);
-				vertexIndices.push_back(vertexIndex[2]);
-				uvIndices.push_back(uvIndex[0]);
-				uvIndices.push_back(uvIndex[1]);
-				uvIndices.push_back(uvIndex[2]);
-				normalIndices.push_back(normalIndex[0]);
-				normalIndices.push_back(normalIndex[1]);
-				normalIndices.push_back(normalIndex[2]);
+				// v, v/vt, v//vn or v/vt/vn
+				Corner corner = { NO_INDEX, NO_INDEX, NO_INDEX };
+				int index;
+				q = ParseInt(q, lineEnd, index);
+				valid = q && ResolveIndex(index, positionCount, corner.vertex);
+				if (valid && q < lineEnd && *q == '/')
+				{
+					++q;
+					if (q < lineEnd && *q != '/')
+					{
+						q = ParseInt(q, lineEnd, index);
+						valid = q && ResolveIndex(index, uvCount, corner.uv);
+					}
+					if (valid && q < lineEnd && *q == '/')
+					{
+						q = ParseInt(q + 1, lineEnd, index);
+						valid = q && ResolveIndex(index, normalCount, corner.normal);
+					}
+				}
+				if (valid && q < lineEnd && !IsSpace(*q))
+					valid = false;
+				if (valid)
+				{
+					corners.push_back(corner);
+					q = SkipSpaces(q, lineEnd);
+				}
 			}
-			else if (matches == 12) //quad
+
+			if (!valid || corners.size() < 3)
+			{
+				std::cout << "Error line: " << std::string(line, lineEnd) << std::endl;
+				std::cout << "File can't be read by parser\n";
+				return false;
+			}
+
+			//triangulate n-gons as a fan around the first corner
+			for (unsigned i = 1; i + 1 < corners.size(); ++i)
 			{
-				//Exercise 2
-				vertexIndices.push_back(vertexIndex[0]);
-				vertexIndices.push_back(vertexIndex[1]);
-				vertexIndices.push_back(vertexIndex[2]);
-				uvIndices.push_back(uvIndex[0]);
-				uvIndices.push_back(uvIndex[1]);
-				uvIndices.push_back(uvIndex[2]);
-				normalIndices.push_back(normalIndex[0]);
-				normalIndices.push_back(normalIndex[1]);
-				normalIndices.push_back(normalIndex[2]);
-
-				vertexIndices.push_back(vertexIndex[0]);
-				vertexIndices.push_back(vertexIndex[2]);
-				vertexIndices.push_back(vertexIndex[3]);
-				uvIndices.push_back(uvIndex[0]);
-				uvIndices.push_back(uvIndex[2]);
-				uvIndices.push_back(uvIndex[3]);
-				normalIndices.push_back(normalIndex[0]);
-				normalIndices.push_back(normalIndex[2]);
-				normalIndices.push_back(normalIndex[3]);
+				const Corner* triangle[3] = { &corners[0], &corners[i], &corners[i + 1] };
+				for (int k = 0; k < 3; ++k)
+				{
+					chunk.vertexIndices.push_back(triangle[k]->vertex);
+					chunk.uvIndices.push_back(triangle[k]->uv);
+					chunk.normalIndices.push_back(triangle[k]->normal);
+				}
 			}
+			unsigned added = 3 * ((unsigned)corners.size() - 2);
+			if (chunk.materials.size() > 0)
+				chunk.materials.back().size += added;
 			else
+				chunk.leadingIndexCount += added;
+		}
+		else if (materials_map != nullptr && IsKeyword(p, lineEnd, "usemtl", 6)) //process usemtl
+		{
+			std::map<std::string, Material*>::const_iterator it = materials_map->find(ParseName(p + 7, lineEnd));
+			if (it != materials_map->end())
+			{
+				Material material = *it->second;
+				chunk.materials.push_back(material);
+			}
+		}
+
+		line = next;
+	}
+	return true;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Expand the parsed face corners into one position/texcoord/normal per corner.
+Corners without a normal get the flat normal of their triangle, corners
+without a texcoord get (0, 0).
+
+\return false if a face refers to an attribute that was never defined
+*/
+/******************************************************************************/
+static bool ExpandOBJ(const OBJChunk& parsed,
+	std::vector<Position>& out_vertices,
+	std::vector<TexCoord>& out_uvs,
+	std::vector<Vector3>& out_normals)
+{
+	unsigned cornerCount = (unsigned)parsed.vertexIndices.size();
+	out_vertices.reserve(out_vertices.size() + cornerCount);
+	out_uvs.reserve(out_uvs.size() + cornerCount);
+	out_normals.reserve(out_normals.size() + cornerCount);
+
+	for (unsigned first = 0; first + 2 < cornerCount; first += 3)
+	{
+		for (unsigned i = first; i < first + 3; ++i)
+		{
+			if (parsed.vertexIndices[i] >= parsed.positions.size() ||
+				(parsed.uvIndices[i] != NO_INDEX && parsed.uvIndices[i] >= parsed.uvs.size()) ||
+				(parsed.normalIndices[i] != NO_INDEX && parsed.normalIndices[i] >= parsed.normals.size()))
 			{
-				//Exercise 2
-				std::cout << "Error line: " << buf << std::endl;
+				std::cout << "Face index out of range\n";
 				std::cout << "File can't be read by parser\n";
 				return false;
 			}
 		}
+
+		for (unsigned i = first; i < first + 3; ++i)
+		{
+			// Get the indices of its attributes
+			unsigned int vertexIndex = parsed.vertexIndices[i];
+			unsigned int uvIndex = parsed.uvIndices[i];
+			unsigned int normalIndex = parsed.normalIndices[i];
+
+			// Put the attributes in buffers
+			out_vertices.push_back(parsed.positions[vertexIndex]);
+			out_uvs.push_back(uvIndex != NO_INDEX ? parsed.uvs[uvIndex] : TexCoord(0, 0));
+			if (normalIndex != NO_INDEX)
+			{
+				out_normals.push_back(parsed.normals[normalIndex]);
+			}
+			else
+			{
+				const Position& a = parsed.positions[parsed.vertexIndices[first]];
+				const Position& b = parsed.positions[parsed.vertexIndices[first + 1]];
+				const Position& c = parsed.positions[parsed.vertexIndices[first + 2]];
+				Vector3 faceNormal = Vector3(b.x - a.x, b.y - a.y, b.z - a.z).Cross(Vector3(c.x - a.x, c.y - a.y, c.z - a.z));
+				float length = faceNormal.Length();
+				out_normals.push_back(length > Math::EPSILON ? faceNormal * (1.f / length) : Vector3(0, 1, 0));
+			}
+		}
 	}
-	fileStream.close(); // close file
+	return true;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Count the v/vt/vn records between begin and end without parsing them, so each
+parallel chunk knows how many attributes come before it
+*/
+/******************************************************************************/
+static void CountOBJChunk(const char* begin, const char* end, unsigned& positions, unsigned& uvs, unsigned& normals)
+{
+	positions = uvs = normals = 0;
+	for (const char* line = begin; line < end; )
+	{
+		const char* lineEnd = FindLineEnd(line, end);
+		const char* p = SkipSpaces(line, lineEnd);
+		if (p + 1 < lineEnd && p[0] == 'v')
+		{
+			if (IsSpace(p[1]))
+				++positions;
+			else if (IsKeyword(p, lineEnd, "vt", 2))
+				++uvs;
+			else if (IsKeyword(p, lineEnd, "vn", 2))
+				++normals;
+		}
+		line = lineEnd + 1;
+	}
+}
+
+//Append a later chunk so the result matches parsing both ranges in one go
+static void AppendOBJChunk(OBJChunk& merged, const OBJChunk& chunk)
+{
+	merged.positions.insert(merged.positions.end(), chunk.positions.begin(), chunk.positions.end());
+	merged.uvs.insert(merged.uvs.end(), chunk.uvs.begin(), chunk.uvs.end());
+	merged.normals.insert(merged.normals.end(), chunk.normals.begin(), chunk.normals.end());
+	merged.vertexIndices.insert(merged.vertexIndices.end(), chunk.vertexIndices.begin(), chunk.vertexIndices.end());
+	merged.uvIndices.insert(merged.uvIndices.end(), chunk.uvIndices.begin(), chunk.uvIndices.end());
+	merged.normalIndices.insert(merged.normalIndices.end(), chunk.normalIndices.begin(), chunk.normalIndices.end());
+
+	if (merged.materials.size() > 0)
+		merged.materials.back().size += chunk.leadingIndexCount;
+	else
+		merged.leadingIndexCount += chunk.leadingIndexCount;
+	merged.materials.insert(merged.materials.end(), chunk.materials.begin(), chunk.materials.end());
+}
+
+//Files smaller than this are parsed on the calling thread only
+static const size_t PARALLEL_MIN_CHUNK_SIZE = 256 * 1024;
+
+/******************************************************************************/
+/*!
+\brief
+Parse an OBJ buffer on the shared thread pool. The buffer is split at line
+boundaries, the attribute records of every chunk are counted in parallel and
+prefix-summed into base offsets, then every chunk is parsed in parallel
+against those offsets and the results are concatenated in file order. The
+output is identical to ParseOBJChunk over the whole buffer.
+*/
+/******************************************************************************/
+static bool ParseOBJParallel(const char* begin, const char* end,
+	const std::map<std::string, Material*>* materials_map,
+	OBJChunk& parsed)
+{
+	ThreadPool& pool = ThreadPool::GetInstance();
+	size_t size = end - begin;
+	unsigned chunkCount = pool.GetThreadCount() + 1;
+	if (size / PARALLEL_MIN_CHUNK_SIZE < chunkCount)
+		chunkCount = (unsigned)(size / PARALLEL_MIN_CHUNK_SIZE);
+	if (chunkCount <= 1)
+		return ParseOBJChunk(begin, end, 0, 0, 0, materials_map, parsed);
+
+	//split at the first line start after each even cut
+	std::vector<const char*> bounds(chunkCount + 1);
+	bounds[0] = begin;
+	bounds[chunkCount] = end;
+	for (unsigned i = 1; i < chunkCount; ++i)
+	{
+		const char* cut = begin + size * i / chunkCount;
+		if (cut < bounds[i - 1])
+			cut = bounds[i - 1];
+		const char* lineEnd = FindLineEnd(cut, end);
+		bounds[i] = lineEnd < end ? lineEnd + 1 : end;
+	}
+
+	struct ChunkCounts
+	{
+		unsigned positions, uvs, normals;
+	};
+	std::vector<ChunkCounts> counts(chunkCount + 1);
+	pool.ParallelFor(chunkCount, [&](unsigned i)
+	{
+		CountOBJChunk(bounds[i], bounds[i + 1], counts[i + 1].positions, counts[i + 1].uvs, counts[i + 1].normals);
+	});
 
-	// For each vertex of each triangle, after fileStream.close()
-	for (unsigned i = 0; i < vertexIndices.size(); ++i)
+	//counts[i] becomes the number of each attribute defined before chunk i
+	counts[0].positions = counts[0].uvs = counts[0].normals = 0;
+	for (unsigned i = 1; i <= chunkCount; ++i)
 	{
-		// Get the indices of its attributes
-		unsigned int vertexIndex = vertexIndices[i];
-		unsigned int uvIndex = uvIndices[i];
-		unsigned int normalIndex = normalIndices[i];
-
-		// Get the attributes thanks to the index
-		Position vertex = temp_vertices[vertexIndex - 1];
-		TexCoord uv = temp_uvs[uvIndex - 1];
-		Vector3 normal = temp_normals[normalIndex - 1];
-
-		// Put the attributes in buffers
-		out_vertices.push_back(vertex);
-		out_uvs.push_back(uv);
-		out_normals.push_back(normal);
+		counts[i].positions += counts[i - 1].positions;
+		counts[i].uvs += counts[i - 1].uvs;
+		counts[i].normals += counts[i - 1].normals;
 	}
 
+	std::vector<OBJChunk> chunks(chunkCount);
+	std::vector<char> succeeded(chunkCount, 0);
+	pool.ParallelFor(chunkCount, [&](unsigned i)
+	{
+		chunks[i].positions.reserve(counts[i + 1].positions - counts[i].positions);
+		chunks[i].uvs.reserve(counts[i + 1].uvs - counts[i].uvs);
+		chunks[i].normals.reserve(counts[i + 1].normals - counts[i].normals);
+		succeeded[i] = ParseOBJChunk(bounds[i], bounds[i + 1],
+			counts[i].positions, counts[i].uvs, counts[i].normals, materials_map, chunks[i]);
+	});
+
+	for (unsigned i = 0; i < chunkCount; ++i)
+	{
+		if (!succeeded[i])
+			return false;
+	}
 
+	parsed.positions.reserve(counts[chunkCount].positions);
+	parsed.uvs.reserve(counts[chunkCount].uvs);
+	parsed.normals.reserve(counts[chunkCount].normals);
+	for (unsigned i = 0; i < chunkCount; ++i)
+	{
+		AppendOBJChunk(parsed, chunks[i]);
+	}
 	return true;
 }
 
+static bool LoadOBJFile(
+	const char* file_path,
+	const std::map<std::string, Material*>* materials_map,
+	std::vector<Position>& out_vertices,
+	std::vector<TexCoord>& out_uvs,
+	std::vector<Vector3>& out_normals,
+	std::vector<Material>* out_materials,
+	bool parallel
+)
+{
+	MappedFile file;
+	if (!file.Open(file_path))
+	{
+		std::cout << "Impossible to open " << file_path << ". Are you in the right directory ?\n";
+		return false;
+	}
+
+	OBJChunk parsed;
+	const char* begin = file.GetData();
+	const char* end = begin + file.GetSize();
+	bool success = parallel
+		? ParseOBJParallel(begin, end, materials_map, parsed)
+		: ParseOBJChunk(begin, end, 0, 0, 0, materials_map, parsed);
+	if (!success)
+		return false;
+	file.Close(); // close file
+
+	if (out_materials != nullptr)
+	{
+		if (out_materials->size() > 0)
+			out_materials->back().size += parsed.leadingIndexCount;
+		out_materials->insert(out_materials->end(), parsed.materials.begin(), parsed.materials.end());
+	}
+	return ExpandOBJ(parsed, out_vertices, out_uvs, out_normals);
+}
+
+bool LoadOBJ(
+	const char* file_path,
+	std::vector<Position>& out_vertices,
+	std::vector<TexCoord>& out_uvs,
+	std::vector<Vector3>& out_normals
+)
+{
+	return LoadOBJFile(file_path, nullptr, out_vertices, out_uvs, out_normals, nullptr, false);
+}
+
 struct PackedVertex {
 	Position position;
 	TexCoord uv;
 	Vector3 normal;
-	bool operator<(const PackedVertex that) const {
-		return memcmp((void*)this, (void*)&that, sizeof(PackedVertex)) > 0;
-	};
 };
 
-bool getSimilarVertexIndex_fast(
-	PackedVertex& packed,
-	std::map<PackedVertex, unsigned short>& VertexToOutIndex,
-	unsigned short& result
-) {
-	std::map<PackedVertex, unsigned short>::iterator it = VertexToOutIndex.find(packed);
-	if (it == VertexToOutIndex.end())
+static unsigned HashPackedVertex(const PackedVertex& packed)
+{
+	//FNV-1a over the raw bits, so vertices weld only when they are bit-identical
+	unsigned words[sizeof(PackedVertex) / sizeof(unsigned)];
+	memcpy(words, &packed, sizeof(words));
+	unsigned hash = 2166136261u;
+	for (unsigned i = 0; i < sizeof(words) / sizeof(unsigned); ++i)
 	{
-		return false;
-	}
-	else
-	{
-		result = it->second;
-		return true;
+		hash ^= words[i];
+		hash *= 16777619u;
 	}
+	return hash ^ (hash >> 15);
 }
 
+/******************************************************************************/
+/*!
+\brief
+Weld identical vertices using an open-addressing hash table sized from the
+input count, so each lookup is O(1) with no per-vertex allocation. Indices
+are full 32-bit values.
+*/
+/******************************************************************************/
 void IndexVBO(
 	std::vector<Position>& in_vertices,
 	std::vector<TexCoord>& in_uvs,
@@ -156,22 +653,46 @@ void IndexVBO(
 	std::vector<Vertex>& out_vertices
 )
 {
-	std::map<PackedVertex, unsigned short> VertexToOutIndex;
+	struct Slot
+	{
+		unsigned hash;
+		unsigned index; //index into uniqueVertices + 1, 0 means empty
+	};
+
+	unsigned vertexCount = (unsigned)in_vertices.size();
+	unsigned capacity = 16;
+	while (capacity < vertexCount * 2)
+		capacity <<= 1;
+	std::vector<Slot> table(capacity);
+	std::vector<PackedVertex> uniqueVertices;
+	uniqueVertices.reserve(vertexCount);
+	out_indices.reserve(out_indices.size() + vertexCount);
+
+	unsigned baseIndex = (unsigned)out_vertices.size();
+	unsigned mask = capacity - 1;
 
 	// For each input vertex
-	for (unsigned int i = 0; i < in_vertices.size(); ++i)
+	for (unsigned int i = 0; i < vertexCount; ++i)
 	{
-
 		PackedVertex packed = { in_vertices[i], in_uvs[i], in_normals[i] };
+		unsigned hash = HashPackedVertex(packed);
 
 		// Try to find a similar vertex in out_XXXX
-		unsigned short index;
-		bool found = getSimilarVertexIndex_fast(packed, VertexToOutIndex, index);
+		unsigned slot = hash & mask;
+		while (table[slot].index != 0)
+		{
+			if (table[slot].hash == hash &&
+				memcmp(&uniqueVertices[table[slot].index - 1], &packed, sizeof(PackedVertex)) == 0)
+			{
+				break;
+			}
+			slot = (slot + 1) & mask;
+		}
 
-		if (found)
+		if (table[slot].index != 0)
 		{
 			// A similar vertex is already in the VBO, use it instead !
-			out_indices.push_back(index);
+			out_indices.push_back(baseIndex + table[slot].index - 1);
 		}
 		else
 		{
@@ -182,30 +703,34 @@ void IndexVBO(
 			v.normal.Set(in_normals[i].x, in_normals[i].y, in_normals[i].z);
 			v.color.Set(1, 1, 1);
 			out_vertices.push_back(v);
-			unsigned newindex = (unsigned)out_vertices.size() - 1;
-			out_indices.push_back(newindex);
-			VertexToOutIndex[packed] = newindex;
+			uniqueVertices.push_back(packed);
+			out_indices.push_back((unsigned)out_vertices.size() - 1);
+			table[slot].hash = hash;
+			table[slot].index = (unsigned)uniqueVertices.size();
 		}
 	}
 }
 
+
 bool LoadMTL(const char* file_path, std::map<std::string, Material*>& materials_map)
 {
-	std::ifstream fileStream(file_path, std::ios::binary);
-	if (!fileStream.is_open())
+	MappedFile file;
+	if (!file.Open(file_path))
 	{
 		std::cout << "Impossible to open " << file_path << ". Are you in the right directory ?\n";
 		return false;
 	}
+
+	const char* end = file.GetData() + file.GetSize();
 	Material* mtl = nullptr;
-	while (!fileStream.eof()) {
-		char buf[256];
-		fileStream.getline(buf, 256);
-		if (strncmp("newmtl ", buf, 7) == 0) { //process newmtl
-			char mtl_name[256];
-			strcpy_s(mtl_name, buf + 7);
-			if (mtl_name[strlen(mtl_name) - 1] == '\r')
-				mtl_name[strlen(mtl_name) - 1] = '\0';
+	for (const char* line = file.GetData(); line < end; )
+	{
+		const char* lineEnd = FindLineEnd(line, end);
+		const char* p = SkipSpaces(line, lineEnd);
+		const char* q = nullptr;
+
+		if (IsKeyword(p, lineEnd, "newmtl", 6)) { //process newmtl
+			std::string mtl_name = ParseName(p + 7, lineEnd);
 			mtl = nullptr;
 			if (materials_map.find(mtl_name) == materials_map.end())
 			{
@@ -213,163 +738,42 @@ bool LoadMTL(const char* file_path, std::map<std::string, Material*>& materials_
 				materials_map.insert(std::pair<std::string, Material*>(mtl_name, mtl));
 			}
 		}
-		else if (strncmp("Ka ", buf, 3) == 0) { //process Ka
-			if (mtl != nullptr)
-			{
-				sscanf_s((buf + 2), "%f%f%f", &mtl->kAmbient.r, &mtl->kAmbient.g, &mtl->kAmbient.b);
+		else if (mtl != nullptr)
+		{
+			if (IsKeyword(p, lineEnd, "Ka", 2)) { //process Ka
+				q = ParseFloat(p + 3, lineEnd, mtl->kAmbient.r);
+				if (q) q = ParseFloat(q, lineEnd, mtl->kAmbient.g);
+				if (q) q = ParseFloat(q, lineEnd, mtl->kAmbient.b);
 			}
-		}
-		else if (strncmp("Kd ", buf, 3) == 0) { //process Kd
-			if (mtl != nullptr)
-			{
-				sscanf_s((buf + 2), "%f%f%f", &mtl->kDiffuse.r, &mtl->kDiffuse.g, &mtl->kDiffuse.b);
+			else if (IsKeyword(p, lineEnd, "Kd", 2)) { //process Kd
+				q = ParseFloat(p + 3, lineEnd, mtl->kDiffuse.r);
+				if (q) q = ParseFloat(q, lineEnd, mtl->kDiffuse.g);
+				if (q) q = ParseFloat(q, lineEnd, mtl->kDiffuse.b);
 			}
-		}
-		else if (strncmp("Ks ", buf, 3) == 0) { //process Ks
-			if (mtl != nullptr)
-			{
-				sscanf_s((buf + 2), "%f%f%f", &mtl->kSpecular.r, &mtl->kSpecular.g, &mtl->kSpecular.b);
+			else if (IsKeyword(p, lineEnd, "Ks", 2)) { //process Ks
+				q = ParseFloat(p + 3, lineEnd, mtl->kSpecular.r);
+				if (q) q = ParseFloat(q, lineEnd, mtl->kSpecular.g);
+				if (q) q = ParseFloat(q, lineEnd, mtl->kSpecular.b);
 			}
-		}
-		else if (strncmp("Ns ", buf, 3) == 0) { //process Ns
-			if (mtl != nullptr)
-			{
-				sscanf_s((buf + 2), "%f", &mtl->kShininess);
+			else if (IsKeyword(p, lineEnd, "Ns", 2)) { //process Ns
+				ParseFloat(p + 3, lineEnd, mtl->kShininess);
 			}
 		}
+
+		line = lineEnd + 1;
 	}
-	fileStream.close(); // close file
+	file.Close(); // close file
 
 	return true;
 }
 
-bool LoadOBJMTL(const char* file_path, const char* mtl_path, std::vector<Position>& out_vertices, std::vector<TexCoord>& out_uvs, std::vector<Vector3>& out_normals, std::vector<Material>& out_materials)
+static bool LoadOBJMTLFile(const char* file_path, const char* mtl_path, std::vector<Position>& out_vertices, std::vector<TexCoord>& out_uvs, std::vector<Vector3>& out_normals, std::vector<Material>& out_materials, bool parallel)
 {
-	std::ifstream fileStream(file_path, std::ios::binary);
-	if (!fileStream.is_open())
-	{
-		std::cout << "Impossible to open " << file_path << ". Are you in the right directory ?\n";
-		return false;
-	}
-	std::vector<unsigned> vertexIndices, uvIndices, normalIndices;
-	std::vector<Position> temp_vertices;
-	std::vector<TexCoord> temp_uvs;
-	std::vector<Vector3> temp_normals;
 	std::map<std::string, Material*> materials_map;
-	if(mtl_path != nullptr && !LoadMTL(mtl_path, materials_map))
+	if (mtl_path != nullptr && !LoadMTL(mtl_path, materials_map))
 		return false;
 
-	while (!fileStream.eof()) {
-		char buf[256];
-		fileStream.getline(buf, 256);
-		if (strncmp("v ", buf, 2) == 0) { //process vertex position
-			Position vertex;
-			sscanf_s((buf + 2), "%f%f%f", &vertex.x, &vertex.y, &vertex.z);
-			temp_vertices.push_back(vertex);
-		}
-		else if (strncmp("vt ", buf, 3) == 0) { //process texcoord
-			TexCoord tc;
-			sscanf_s((buf + 2), "%f%f", &tc.u, &tc.v);
-			temp_uvs.push_back(tc);
-		}
-		else if (strncmp("vn ", buf, 3) == 0) { //process normal
-			Vector3 normal;
-			sscanf_s((buf + 2), "%f%f%f", &normal.x, &normal.y, &normal.z);
-			temp_normals.push_back(normal);
-		}
-		//else if (strncmp("mtllib ", buf, 7) == 0) { //process mtllib
-		//	char mtl_path[256];
-		//	strcpy_s(mtl_path, buf + 7);
-		//	LoadMTL(mtl_path, materials_map);
-		//}
-		else if (strncmp("usemtl ", buf, 7) == 0) { //process usemtl
-			char mtl_name[256];
-			strcpy_s(mtl_name, buf + 7);
-			if (materials_map.find(mtl_name) != materials_map.end())
-			{
-				Material* mtl = materials_map.find(mtl_name)->second;
-				Material material = *mtl;
-				out_materials.push_back(material);
-			}
-		}
-		else if (strncmp("f ", buf, 2) == 0) { //process face
-			unsigned int vertexIndex[4], uvIndex[4], normalIndex[4];
-			int matches = sscanf_s((buf + 2), "%d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n",
-				&vertexIndex[0], &uvIndex[0], &normalIndex[0],
-				&vertexIndex[1], &uvIndex[1], &normalIndex[1],
-				&vertexIndex[2], &uvIndex[2], &normalIndex[2],
-				&vertexIndex[3], &uvIndex[3], &normalIndex[3]);
-
-			if (matches == 9) //triangle
-			{
-				vertexIndices.push_back(vertexIndex[0]);
-				vertexIndices.push_back(vertexIndex[1]);
-				vertexIndices.push_back(vertexIndex[2]);
-				uvIndices.push_back(uvIndex[0]);
-				uvIndices.push_back(uvIndex[1]);
-				uvIndices.push_back(uvIndex[2]);
-				normalIndices.push_back(normalIndex[0]);
-				normalIndices.push_back(normalIndex[1]);
-				normalIndices.push_back(normalIndex[2]);
-				if (out_materials.size() > 0)
-				{
-					out_materials.back().size += 3;
-				}
-			}
-			else if (matches == 12) //quad
-			{
-				vertexIndices.push_back(vertexIndex[0]);
-				vertexIndices.push_back(vertexIndex[1]);
-				vertexIndices.push_back(vertexIndex[2]);
-				uvIndices.push_back(uvIndex[0]);
-				uvIndices.push_back(uvIndex[1]);
-				uvIndices.push_back(uvIndex[2]);
-				normalIndices.push_back(normalIndex[0]);
-				normalIndices.push_back(normalIndex[1]);
-				normalIndices.push_back(normalIndex[2]);
-
-				vertexIndices.push_back(vertexIndex[0]);
-				vertexIndices.push_back(vertexIndex[2]);
-				vertexIndices.push_back(vertexIndex[3]);
-				uvIndices.push_back(uvIndex[0]);
-				uvIndices.push_back(uvIndex[2]);
-				uvIndices.push_back(uvIndex[3]);
-				normalIndices.push_back(normalIndex[0]);
-				normalIndices.push_back(normalIndex[2]);
-				normalIndices.push_back(normalIndex[3]);
-				if (out_materials.size() > 0)
-				{
-					out_materials.back().size += 6;
-				}
-			}
-			else
-			{
-				std::cout << "Error line: " << buf << std::endl;
-				std::cout << "File can't be read by parser\n";
-				return false;
-			}
-		}
-	}
-	fileStream.close(); // close file
-
-	// For each vertex of each triangle, after fileStream.close()
-	for (unsigned i = 0; i < vertexIndices.size(); ++i)
-	{
-		// Get the indices of its attributes
-		unsigned int vertexIndex = vertexIndices[i];
-		unsigned int uvIndex = uvIndices[i];
-		unsigned int normalIndex = normalIndices[i];
-
-		// Get the attributes thanks to the index
-		Position vertex = temp_vertices[vertexIndex - 1];
-		TexCoord uv = temp_uvs[uvIndex - 1];
-		Vector3 normal = temp_normals[normalIndex - 1];
-
-		// Put the attributes in buffers
-		out_vertices.push_back(vertex);
-		out_uvs.push_back(uv);
-		out_normals.push_back(normal);
-	}
+	bool success = LoadOBJFile(file_path, &materials_map, out_vertices, out_uvs, out_normals, &out_materials, parallel);
 
 	for (std::map<std::string, Material*>::iterator it = materials_map.begin(); it != materials_map.end(); ++it)
 	{
@@ -377,5 +781,22 @@ bool LoadOBJMTL(const char* file_path, const char* mtl_path, std::vector<Positio
 	}
 	materials_map.clear();
 
-	return true;
+	return success;
+}
+
+bool LoadOBJMTL(const char* file_path, const char* mtl_path, std::vector<Position>& out_vertices, std::vector<TexCoord>& out_uvs, std::vector<Vector3>& out_normals, std::vector<Material>& out_materials)
+{
+	return LoadOBJMTLFile(file_path, mtl_path, out_vertices, out_uvs, out_normals, out_materials, false);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Same as LoadOBJMTL, but large OBJ files are parsed in chunks on the shared
+ThreadPool. The output is identical to LoadOBJMTL.
+*/
+/******************************************************************************/
+bool LoadOBJMTLParallel(const char* file_path, const char* mtl_path, std::vector<Position>& out_vertices, std::vector<TexCoord>& out_uvs, std::vector<Vector3>& out_normals, std::vector<Material>& out_materials)
+{
+	return LoadOBJMTLFile(file_path, mtl_path, out_vertices, out_uvs, out_normals, out_materials, true);
 }
@@ -31,4 +31,13 @@ bool LoadOBJMTL(
 	std::vector<Material>& out_materials
 );
 
+bool LoadOBJMTLParallel(
+	const char* file_path, 
+	const char* mtl_path,
+	std::vector<Position>& out_vertices,
+	std::vector<TexCoord>& out_uvs,
+	std::vector<Vector3>& out_normals,
+	std::vector<Material>& out_materials
+);
+
 #endif
\ No newline at end of file
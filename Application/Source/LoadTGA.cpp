@@ -1,53 +1,222 @@
-
 #include <iostream>
-#include <fstream>
+#include <cstring>
 #include <GL\glew.h>
+#include <GLFW/glfw3.h>
 
 #include "LoadTGA.h"
+#include "LoadDDS.h"
+#include "MappedFile.h"
+#include "AssetRegistry.h"
+
+//GL_ARB_buffer_storage is newer than our GLEW, so it is fetched by hand
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+typedef void (GLAPIENTRY *BufferStorageProc)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+static const size_t MIN_UPLOAD_REGION_SIZE = 4 * 1024 * 1024;
 
-GLuint LoadTGA(const char *file_path)				// load TGA file to memory
+//Regions of the persistent upload buffer, used in turn so a load only waits
+//for the GPU when it comes back round to a region still being read
+static const unsigned UPLOAD_REGIONS = 3;
+
+//pixel unpack buffer shared by every synchronous TGA load
+static GLuint uploadBuffer = 0;
+static size_t uploadRegionSize = 0;
+static unsigned char* uploadMapping = nullptr; //only set when persistently mapped
+static GLsync uploadFences[UPLOAD_REGIONS] = {};
+static unsigned uploadRegion = 0; //region the current or next upload writes
+
+struct TGAFormat
 {
-	std::ifstream fileStream(file_path, std::ios::binary);
-	if(!fileStream.is_open()) {
-		std::cout << "Impossible to open " << file_path << ". Are you in the right directory ?\n";
-		return 0;
+	unsigned width, height;
+	unsigned bytesPerPixel;
+	bool rle;
+	bool topOrigin;
+	size_t dataOffset;
+};
+
+/******************************************************************************/
+/*!
+\brief
+Validate an 18 byte TGA header. Accepts uncompressed (type 2) and RLE
+(type 10) true-colour images of 24 or 32 bits.
+*/
+/******************************************************************************/
+static bool ParseTGAHeader(const unsigned char* data, size_t size, TGAFormat& format)
+{
+	if (size < 18)
+		return false;
+
+	format.width = data[12] + data[13] * 256;
+	format.height = data[14] + data[15] * 256;
+	format.bytesPerPixel = data[16] / 8;
+	format.rle = data[2] == 10;
+	format.topOrigin = (data[17] & 0x20) != 0;
+	format.dataOffset = 18 + data[0] + (data[1] ? (data[5] + data[6] * 256) * ((data[7] + 7) / 8) : 0); //skip id and colour map
+
+	return (data[2] == 2 || data[2] == 10) &&
+		format.width > 0 && format.height > 0 &&
+		(data[16] == 24 || data[16] == 32) &&
+		format.dataOffset <= size;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Decode the pixel data of a TGA straight into dst, which must hold
+width * height * bytesPerPixel bytes. Rows come out bottom-up whatever the
+file's origin, and RLE packets are expanded as they are read.
+
+\param out_translucent - set if any pixel has alpha below 255. Read from the
+	file, since dst may be a write-only mapping.
+
+\return false if the file ends early
+*/
+/******************************************************************************/
+static bool DecodeTGAPixels(const unsigned char* data, size_t size, const TGAFormat& format, unsigned char* dst,
+	bool& out_translucent)
+{
+	const unsigned bpp = format.bytesPerPixel;
+	const size_t rowSize = (size_t)format.width * bpp;
+	const unsigned char* src = data + format.dataOffset;
+	const unsigned char* end = data + size;
+	out_translucent = false;
+
+	if (!format.rle)
+	{
+		if ((size_t)(end - src) < rowSize * format.height)
+			return false;
+		for (size_t i = 3; bpp == 4 && i < rowSize * format.height && !out_translucent; i += 4)
+			out_translucent = src[i] != 0xFF;
+		if (!format.topOrigin)
+		{
+			memcpy(dst, src, rowSize * format.height);
+			return true;
+		}
+		for (unsigned row = 0; row < format.height; ++row)
+			memcpy(dst + (format.height - 1 - row) * rowSize, src + row * rowSize, rowSize);
+		return true;
 	}
 
-	GLubyte		header[ 18 ];									// first 6 useful header bytes
-	GLuint		bytesPerPixel;								    // number of bytes per pixel in TGA gile
-	GLuint		imageSize;									    // for setting memory
-	GLubyte *	data;
-	GLuint		texture = 0;
-	unsigned	width, height;
-	float maxAnisotropy = 1.f;
+	unsigned row = 0, column = 0;
+	unsigned char* out = dst + (format.topOrigin ? (format.height - 1) * rowSize : 0);
+	while (row < format.height)
+	{
+		if (src >= end)
+			return false;
+		unsigned char packet = *src++;
+		unsigned count = (packet & 0x7f) + 1;
+		bool repeat = (packet & 0x80) != 0;
+		if ((size_t)(end - src) < (repeat ? bpp : count * bpp))
+			return false;
+		for (unsigned i = 3; bpp == 4 && i < (repeat ? bpp : count * bpp) && !out_translucent; i += 4)
+			out_translucent = src[i] != 0xFF;
+
+		//packets may run across row ends
+		for (unsigned i = 0; i < count && row < format.height; ++i)
+		{
+			memcpy(out, src, bpp);
+			out += bpp;
+			if (!repeat)
+				src += bpp;
+			if (++column == format.width)
+			{
+				column = 0;
+				if (++row < format.height)
+					out = dst + (format.topOrigin ? format.height - 1 - row : row) * rowSize;
+			}
+		}
+		if (repeat)
+			src += bpp;
+	}
+	return true;
+}
 
-	fileStream.read((char*)header, 18);
-	width = header[12] + header[13] * 256;
-	height = header[14] + header[15] * 256;
+/******************************************************************************/
+/*!
+\brief
+Return the shared texture for a TGA file. The file is only decoded and
+uploaded the first time any scene asks for it.
+*/
+/******************************************************************************/
+GLuint LoadTGA(const char *file_path)
+{
+	return AssetRegistry::AcquireTexture(file_path);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Read a 24/32 bit TGA, raw or RLE, into memory. Makes no GL calls, so it can
+run on a worker thread.
+*/
+/******************************************************************************/
+bool DecodeTGA(const char *file_path, TGAImage& image)
+{
+	MappedFile file;
+	if (!file.Open(file_path)) {
+		std::cout << "Impossible to open " << file_path << ". Are you in the right directory ?\n";
+		return false;
+	}
 
- 	if(	width <= 0 ||								// is width <= 0
-		height <= 0 ||								// is height <=0
-		(header[16] != 24 && header[16] != 32))		// is TGA 24 or 32 Bit
+	const unsigned char* data = (const unsigned char*)file.GetData();
+	TGAFormat format;
+	if (!ParseTGAHeader(data, file.GetSize(), format))
 	{
-		fileStream.close();							// close file on failure
 		std::cout << "File header error.\n";
-		return 0;										
+		return false;
 	}
 
-	bytesPerPixel	= header[16] / 8;						//divide by 8 to get bytes per pixel
-	imageSize		= width * height * bytesPerPixel;	// calculate memory required for TGA data
-	
-	data = new GLubyte[ imageSize ];
-	fileStream.seekg(18, std::ios::beg);
-	fileStream.read((char *)data, imageSize);
-	fileStream.close();	
+	image.width = format.width;
+	image.height = format.height;
+	image.bytesPerPixel = format.bytesPerPixel;
+	image.pixels.resize((size_t)format.width * format.height * format.bytesPerPixel);
+	if (!DecodeTGAPixels(data, file.GetSize(), format, &image.pixels[0], image.translucent))
+	{
+		std::cout << "Truncated TGA " << file_path << "\n";
+		return false;
+	}
+	return true;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Create a texture with room for a full mipmap chain. Immutable storage is used
+when the driver has GL_ARB_texture_storage. Level 0 is left for the caller to
+fill with glTexSubImage2D.
+*/
+/******************************************************************************/
+static GLuint CreateTGATexture(unsigned width, unsigned height, unsigned bytesPerPixel)
+{
+	GLuint texture = 0;
+	GLenum internalFormat = bytesPerPixel == 3 ? GL_RGB8 : GL_RGBA8;
 
 	glGenTextures(1, &texture);
 	glBindTexture(GL_TEXTURE_2D, texture);
-	if(bytesPerPixel == 3)
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_BGR, GL_UNSIGNED_BYTE, data);
-	else //bytesPerPixel == 4
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_BGRA, GL_UNSIGNED_BYTE, data);
+	if (GLEW_ARB_texture_storage)
+	{
+		GLsizei levels = 1;
+		for (unsigned size = width > height ? width : height; size > 1; size /= 2)
+			++levels;
+		glTexStorage2D(GL_TEXTURE_2D, levels, internalFormat, width, height);
+	}
+	else
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, bytesPerPixel == 3 ? GL_BGR : GL_BGRA, GL_UNSIGNED_BYTE, 0);
+	return texture;
+}
+
+//Fill level 0 of the bound texture from pixels (a client pointer or a PBO offset) and build the mipmaps
+static void FinishTGATexture(unsigned width, unsigned height, unsigned bytesPerPixel, const void* pixels)
+{
+	//24 bit rows are not always 4 byte aligned
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, bytesPerPixel == 3 ? GL_BGR : GL_BGRA, GL_UNSIGNED_BYTE, pixels);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	float maxAnisotropy = 1.f;
 
 	//to do: modify the texture parameters code from here
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -61,8 +230,192 @@ GLuint LoadTGA(const char *file_path)				// load TGA file to memory
 	glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, (GLint)maxAnisotropy);
 	//end of modifiable code
+}
+
+/******************************************************************************/
+/*!
+\brief
+Create a mipmapped texture from a decoded TGA. Main thread only.
+*/
+/******************************************************************************/
+GLuint UploadTGA(const TGAImage& image)
+{
+	GLuint texture = CreateTGATexture(image.width, image.height, image.bytesPerPixel);
+	FinishTGATexture(image.width, image.height, image.bytesPerPixel, &image.pixels[0]);
+	return texture;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Bind the upload PBO and return a write pointer to at least size bytes of it.
+With GL_ARB_buffer_storage the buffer stays persistently mapped and is only
+reallocated when an image outgrows a region. Uploads take the regions in
+turn, and only wait on the fence of the one they take. Otherwise the buffer
+is orphaned and mapped for this upload alone.
+
+\param out_offset - where the pointer is in the buffer, to pass to GL as the
+	pixel pointer
+
+\return nullptr if the buffer could not be mapped
+*/
+/******************************************************************************/
+static unsigned char* BeginPixelUpload(size_t size, size_t& out_offset)
+{
+	static BufferStorageProc bufferStorage = glfwExtensionSupported("GL_ARB_buffer_storage") ?
+		(BufferStorageProc)glfwGetProcAddress("glBufferStorage") : nullptr;
 
-	delete []data;
+	if (bufferStorage == nullptr)
+	{
+		if (uploadBuffer == 0)
+			glGenBuffers(1, &uploadBuffer);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, uploadBuffer);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+		out_offset = 0;
+		return (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	}
+
+	if (size > uploadRegionSize)
+	{
+		//GL keeps the old buffer alive until uploads still reading it are done
+		ReleaseTGAUploadBuffer();
+		uploadRegionSize = size > MIN_UPLOAD_REGION_SIZE ? size : MIN_UPLOAD_REGION_SIZE;
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glGenBuffers(1, &uploadBuffer);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, uploadBuffer);
+		bufferStorage(GL_PIXEL_UNPACK_BUFFER, uploadRegionSize * UPLOAD_REGIONS, nullptr, flags);
+		uploadMapping = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, uploadRegionSize * UPLOAD_REGIONS, flags);
+		if (uploadMapping == nullptr)
+		{
+			ReleaseTGAUploadBuffer();
+			return nullptr;
+		}
+	}
+	else
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, uploadBuffer);
+
+	//the upload UPLOAD_REGIONS loads ago must be out of this region before it is overwritten
+	GLsync& fence = uploadFences[uploadRegion];
+	if (fence != 0)
+	{
+		glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		glDeleteSync(fence);
+		fence = 0;
+	}
+	out_offset = uploadRegion * uploadRegionSize;
+	return uploadMapping + out_offset;
+}
+
+//Hand the written pixels over to GL. Returns false if the driver lost the mapping.
+static bool EndPixelUpload()
+{
+	if (uploadMapping != nullptr)
+		return true;
+	return glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+}
+
+//Fence the region just used and move on to the next, then unbind the PBO so
+//later client-memory uploads are not read as buffer offsets
+static void FinishPixelUpload()
+{
+	if (uploadMapping != nullptr)
+	{
+		uploadFences[uploadRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		uploadRegion = (uploadRegion + 1) % UPLOAD_REGIONS;
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Free the upload PBO. Call before the GL context is destroyed.
+*/
+/******************************************************************************/
+void ReleaseTGAUploadBuffer()
+{
+	for (unsigned i = 0; i < UPLOAD_REGIONS; ++i)
+	{
+		if (uploadFences[i] != 0)
+			glDeleteSync(uploadFences[i]);
+		uploadFences[i] = 0;
+	}
+	if (uploadBuffer != 0)
+	{
+		if (uploadMapping != nullptr)
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, uploadBuffer);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+		glDeleteBuffers(1, &uploadBuffer);
+	}
+	uploadBuffer = 0;
+	uploadRegionSize = 0;
+	uploadMapping = nullptr;
+	uploadRegion = 0;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Load a texture from file. When the AssetCooker has produced a .dds next to
+the TGA, that is uploaded instead (compressed, with prebuilt mipmaps).
+
+Otherwise the TGA is memory mapped and its pixels are decoded straight into
+a pixel unpack buffer, so no system memory copy of the image is made.
+
+\param out_translucent - set if the texture has alpha below 255 anywhere
+*/
+/******************************************************************************/
+GLuint LoadTGAFile(const char *file_path, bool& out_translucent)			// load TGA file to memory
+{
+	DDSImage cooked;
+	if (DecodeDDS(GetDDSPath(file_path).c_str(), cooked))
+	{
+		out_translucent = IsTranslucentDDS(cooked);
+		return UploadDDS(cooked);
+	}
+
+	MappedFile file;
+	if (!file.Open(file_path)) {
+		std::cout << "Impossible to open " << file_path << ". Are you in the right directory ?\n";
+		return 0;
+	}
+
+	const unsigned char* data = (const unsigned char*)file.GetData();
+	TGAFormat format;
+	if (!ParseTGAHeader(data, file.GetSize(), format))
+	{
+		std::cout << "File header error.\n";
+		return 0;
+	}
+
+	size_t imageSize = (size_t)format.width * format.height * format.bytesPerPixel;
+	size_t offset = 0;
+	unsigned char* pixels = BeginPixelUpload(imageSize, offset);
+	if (pixels == nullptr)
+	{
+		//no PBO, go through system memory instead
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		TGAImage image;
+		if (!DecodeTGA(file_path, image))
+			return 0;
+		out_translucent = image.translucent;
+		return UploadTGA(image);
+	}
+
+	bool decoded = DecodeTGAPixels(data, file.GetSize(), format, pixels, out_translucent);
+	if (!EndPixelUpload() || !decoded)
+	{
+		FinishPixelUpload();
+		if (!decoded)
+			std::cout << "Truncated TGA " << file_path << "\n";
+		return 0;
+	}
 
-	return texture;						
-}
\ No newline at end of file
+	GLuint texture = CreateTGATexture(format.width, format.height, format.bytesPerPixel);
+	FinishTGATexture(format.width, format.height, format.bytesPerPixel, (const void*)offset);
+	FinishPixelUpload();
+	return texture;
+}
@@ -1,6 +1,21 @@
 #ifndef LOAD_TGA_H
 #define LOAD_TGA_H
 
+#include <vector>
+
+struct TGAImage
+{
+	unsigned width, height;
+	unsigned bytesPerPixel;
+	std::vector<unsigned char> pixels; //bottom-up rows, BGR or BGRA
+	bool translucent; //any alpha below 255
+};
+
 GLuint LoadTGA(const char *file_path);
+GLuint LoadTGAFile(const char *file_path, bool& out_translucent);
+
+bool DecodeTGA(const char *file_path, TGAImage& image);
+GLuint UploadTGA(const TGAImage& image);
+void ReleaseTGAUploadBuffer();
 
 #endif
\ No newline at end of file
@@ -3,146 +3,49 @@
 
 #include "shader.hpp"
 #include "MeshBuilder.h"
+#include "TextureAtlas.h"
+#include "AssetStreamer.h"
 
 #define LSPEED 20
 
 void LobbyScene::RenderMesh(Mesh* mesh, bool enableLight)
 {
-	Mtx44 MVP, modelView, modelView_inverse_transpose;
-
-	MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, &MVP.a[0]);
-	modelView = viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MODELVIEW], 1, GL_FALSE, &modelView.a[0]);
-	if (enableLight)
-	{
-		glUniform1i(m_parameters[U_LIGHTENABLED], 1);
-		modelView_inverse_transpose = modelView.GetInverse().GetTranspose();
-		glUniformMatrix4fv(m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE], 1, GL_FALSE, &modelView_inverse_transpose.a[0]);
-
-		//load material
-		glUniform3fv(m_parameters[U_MATERIAL_AMBIENT], 1, &mesh->material.kAmbient.r);
-		glUniform3fv(m_parameters[U_MATERIAL_DIFFUSE], 1, &mesh->material.kDiffuse.r);
-		glUniform3fv(m_parameters[U_MATERIAL_SPECULAR], 1, &mesh->material.kSpecular.r);
-		glUniform1f(m_parameters[U_MATERIAL_SHININESS], mesh->material.kShininess);
-	}
-	else
-	{
-		glUniform1i(m_parameters[U_LIGHTENABLED], 0);
-	}
+	Mtx44 modelView = viewStack.Top() * modelStack.Top();
+	//imported meshes with LODs, such as the dining hall tables, draw a coarser one from afar
+	renderer.DrawMesh(mesh, projectionStack.Top(), modelView, enableLight,
+		mesh != nullptr ? mesh->SelectLod(modelView, projectionStack.Top()) : 0);
+}
 
-	if (mesh->textureID > 0)
-	{
-		glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 1);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, mesh->textureID);
-		glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
-	}
-	else
-	{
-		glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 0);
-	}
-	mesh->Render(); //this line should only be called once
-	if (mesh->textureID > 0)
-	{
-		glBindTexture(GL_TEXTURE_2D, 0);
-	}
+//Draw a mesh once per model matrix in one draw call. The matrices are built
+//on modelStack as for RenderMesh; only the camera is shared through uniforms.
+void LobbyScene::RenderMeshInstanced(Mesh* mesh, const std::vector<Mtx44>& models, bool enableLight)
+{
+	renderer.DrawMeshInstanced(mesh, projectionStack.Top(), viewStack.Top(), models, enableLight);
 }
 
 void LobbyScene::RenderEntity(Entity* entity, bool enableLight)
 {
-	modelStack.PushMatrix();
-	modelStack.Translate(entity->getTransform().x, entity->getTransform().y, entity->getTransform().z);
-	modelStack.Rotate(entity->getRotationAngle(), entity->getRotationAxis().x, entity->getRotationAxis().y, entity->getRotationAxis().z);
-	modelStack.Scale(entity->getScale().x, entity->getScale().x, entity->getScale().x);
-
-	Mtx44 MVP, modelView, modelView_inverse_transpose;
-
-	MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, &MVP.a[0]);
-	modelView = viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MODELVIEW], 1, GL_FALSE, &modelView.a[0]);
-	if (enableLight)
-	{
-		glUniform1i(m_parameters[U_LIGHTENABLED], 1);
-		modelView_inverse_transpose = modelView.GetInverse().GetTranspose();
-		glUniformMatrix4fv(m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE], 1, GL_FALSE, &modelView_inverse_transpose.a[0]);
-
-		//load material
-		glUniform3fv(m_parameters[U_MATERIAL_AMBIENT], 1, &entity->getMesh()->material.kAmbient.r);
-		glUniform3fv(m_parameters[U_MATERIAL_DIFFUSE], 1, &entity->getMesh()->material.kDiffuse.r);
-		glUniform3fv(m_parameters[U_MATERIAL_SPECULAR], 1, &entity->getMesh()->material.kSpecular.r);
-		glUniform1f(m_parameters[U_MATERIAL_SHININESS], entity->getMesh()->material.kShininess);
-	}
-	else
-	{
-		glUniform1i(m_parameters[U_LIGHTENABLED], 0);
-	}
-
-	if (entity->getMesh()->textureID > 0)
-	{
-		glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 1);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, entity->getMesh()->textureID);
-		glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
-	}
-	else
-	{
-		glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 0);
-	}
-	entity->getMesh()->Render(); //this line should only be called once
-	if (entity->getMesh()->textureID > 0)
-	{
-		glBindTexture(GL_TEXTURE_2D, 0);
-	}
-
-	modelStack.PopMatrix();
+	Mtx44 modelView = viewStack.Top() * modelStack.Top() * entity->getModelMatrix();
+	//distant characters and props draw a coarser LOD
+	Mesh* mesh = entity->getMesh();
+	renderer.DrawMesh(mesh, projectionStack.Top(), modelView, enableLight, mesh->SelectLod(modelView, projectionStack.Top()));
 }
 
 void LobbyScene::RenderText(Mesh* mesh, std::string text, Color color)
 {
-	if (!mesh || mesh->textureID <= 0) //Proper error check
-	{
-		return;
-	}
-	glUniform1i(m_parameters[U_TEXT_ENABLED], 1);
-	glUniform3fv(m_parameters[U_TEXT_COLOR], 1, &color.r);
-	glUniform1i(m_parameters[U_LIGHTENABLED], 0);
-	glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 1);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, mesh->textureID);
-	glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
-	for (unsigned i = 0; i < text.length(); ++i)
-	{
-		Mtx44 characterSpacing;
-		characterSpacing.SetToTranslation(i * 1.0f, 0, 0); //1.0f is the spacing of each character, you may change this value
-		Mtx44 MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top() * characterSpacing;
-		glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, &MVP.a[0]);
-		mesh->Render((unsigned)text[i] * 6, 6);
-	}
-
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glUniform1i(m_parameters[U_TEXT_ENABLED], 0);
+	renderer.DrawText(mesh, text, color, projectionStack.Top() * viewStack.Top() * modelStack.Top(), 1.0f);
 }
 
 void LobbyScene::RenderMeshOnScreen(Mesh* mesh, float x, float y, float sizex, float sizey)
 {
-	glDisable(GL_DEPTH_TEST);
 	Mtx44 ortho;
 	ortho.SetToOrtho(0, Application::screenUISizeX, 0, Application::screenUISizeY, -10, 10); //size of screen UI
-	projectionStack.PushMatrix();
-	projectionStack.LoadMatrix(ortho);
-	viewStack.PushMatrix();
-	viewStack.LoadIdentity(); //No need camera for ortho mode
 	modelStack.PushMatrix();
 	modelStack.LoadIdentity(); //Reset modelStack
 	modelStack.Translate(x, y, 0);
 	modelStack.Scale(sizex, sizey, 1);
-	RenderMesh(mesh, false);
-	projectionStack.PopMatrix();
-	viewStack.PopMatrix();
+	renderer.DrawMesh(mesh, ortho, modelStack.Top(), false, 0, Renderer::PASS_SCREEN);
 	modelStack.PopMatrix();
-	glEnable(GL_DEPTH_TEST);
 }
 
 void LobbyScene::RenderTextOnScreen(Mesh* mesh, std::string text, Color color, float size, float x, float y)
@@ -153,13 +56,8 @@ void LobbyScene::RenderTextOnScreen(Mesh* mesh, std::string text, Color color, f
 	{
 		return;
 	}
-	glDisable(GL_DEPTH_TEST);
 	Mtx44 ortho;
 	ortho.SetToOrtho(0, Application::screenUISizeX, 0, Application::screenUISizeY, -10, 10); //size of screen UI
-	projectionStack.PushMatrix();
-	projectionStack.LoadMatrix(ortho);
-	viewStack.PushMatrix();
-	viewStack.LoadIdentity(); //No need camera for ortho mode
 	modelStack.PushMatrix();
 	modelStack.LoadIdentity(); //Reset modelStack
 	if (!isTalking)
@@ -171,29 +69,8 @@ void LobbyScene::RenderTextOnScreen(Mesh* mesh, std::string text, Color color, f
 		modelStack.Translate(x, y, 0);
 	}
 	modelStack.Scale(size, size, size);
-	glUniform1i(m_parameters[U_TEXT_ENABLED], 1);
-	glUniform3fv(m_parameters[U_TEXT_COLOR], 1, &color.r);
-	glUniform1i(m_parameters[U_LIGHTENABLED], 0);
-	glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 1);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, mesh->textureID);
-	glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
-	for (unsigned i = 0; i < text.length(); ++i)
-	{
-		Mtx44 characterSpacing;
-		std::stringstream ss;
-		characterSpacing.SetToTranslation(0.5f + i * spacing, 0.5f, 0); //1.0f is the spacing of each character, you may change this value
-		Mtx44 MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top() * characterSpacing;
-		glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, &MVP.a[0]);
-		mesh->Render((unsigned)text[i] * 6, 6);
-	}
-
-		glBindTexture(GL_TEXTURE_2D, 0);
-		glUniform1i(m_parameters[U_TEXT_ENABLED], 0);
-		projectionStack.PopMatrix();
-		viewStack.PopMatrix();
-		modelStack.PopMatrix();
-		glEnable(GL_DEPTH_TEST);
+	renderer.DrawText(mesh, text, color, ortho * modelStack.Top(), spacing, 0.5f, 0.5f, Renderer::PASS_SCREEN);
+	modelStack.PopMatrix();
 }
 
 void LobbyScene::RenderOfficers()
@@ -211,13 +88,15 @@ void LobbyScene::RenderOfficers()
 		RenderTextOnScreen(meshList[GEO_TEXT], ("Welcome to the crime scene Detective."), Color(1, 1, 1), 2, 31, 9.5);
 	}
 	{
+		std::vector<Mtx44> femaleOfficers, maleOfficers;
+
 		//janitor
 
 		modelStack.PushMatrix();
 		modelStack.Translate(-7, 0, 8.2);
 		modelStack.Scale(1, 1, 1);
 		modelStack.Rotate(90, 0, 1, 0);
-		RenderMesh(meshList[GEO_OFFICER_F], true);
+		femaleOfficers.push_back(modelStack.Top());
 		modelStack.PopMatrix();
 
 		//guard
@@ -225,7 +104,7 @@ void LobbyScene::RenderOfficers()
 		modelStack.Translate(-5.5, 0, 3.2);
 		modelStack.Scale(1, 1, 1);
 		modelStack.Rotate(90, 0, 1, 0);
-		RenderMesh(meshList[GEO_OFFICER_M], true);
+		maleOfficers.push_back(modelStack.Top());
 		modelStack.PopMatrix();
 
 
@@ -234,7 +113,7 @@ void LobbyScene::RenderOfficers()
 		modelStack.Translate(5.5, 0, 3.2);
 		modelStack.Scale(1, 1, 1);
 		modelStack.Rotate(-180, 0, 1, 0);
-		RenderMesh(meshList[GEO_OFFICER_M], true);
+		maleOfficers.push_back(modelStack.Top());
 		modelStack.PopMatrix();
 
 		//kid
@@ -242,7 +121,7 @@ void LobbyScene::RenderOfficers()
 		modelStack.PushMatrix();
 		modelStack.Translate(4.5, 0, -5);
 		modelStack.Scale(1, 1, 1);
-		RenderMesh(meshList[GEO_OFFICER_F], true);
+		femaleOfficers.push_back(modelStack.Top());
 		modelStack.PopMatrix();
 
 		//arcade
@@ -250,23 +129,27 @@ void LobbyScene::RenderOfficers()
 		modelStack.PushMatrix();
 		modelStack.Translate(2, 0, -14);
 		modelStack.Scale(1, 1, 1);
-		RenderMesh(meshList[GEO_OFFICER_M], true);
+		maleOfficers.push_back(modelStack.Top());
 		modelStack.PopMatrix();
 
 		//lift
 		modelStack.PushMatrix();
 		modelStack.Translate(1.1, 0, 30.5);
 		modelStack.Scale(1, 1, 1);
-		RenderMesh(meshList[GEO_OFFICER_F], true);
+		femaleOfficers.push_back(modelStack.Top());
 		modelStack.PopMatrix();
 
 		modelStack.PushMatrix();
 		modelStack.Translate(1.1, 0, 32);
 		modelStack.Scale(1, 1, 1);
 		modelStack.Rotate(-180, 0, 1, 0);
-		RenderMesh(meshList[GEO_OFFICER_M], true);
+		maleOfficers.push_back(modelStack.Top());
 		modelStack.PopMatrix();
 
+		//every officer of a model is drawn in one call
+		RenderMeshInstanced(meshList[GEO_OFFICER_F], femaleOfficers, true);
+		RenderMeshInstanced(meshList[GEO_OFFICER_M], maleOfficers, true);
+
 		if (!isTalking && !isJournalOpen && !Inspect)
 		{
 			//janitor
@@ -314,19 +197,13 @@ void LobbyScene::InspectEvidenceOnScreen(Mesh* mesh, float x, float y, float siz
 {
 	Mtx44 ortho;
 	ortho.SetToOrtho(0, 80, 0, 60, -10, 10); //size of screen UI
-	projectionStack.PushMatrix();
-	projectionStack.LoadMatrix(ortho);
-	viewStack.PushMatrix();
-	viewStack.LoadIdentity(); //No need camera for ortho mode
 	modelStack.PushMatrix();
 	modelStack.LoadIdentity(); //Reset modelStack
 	modelStack.Translate(x, y, 0);
 	modelStack.Scale(sizex, sizey, 1);
 	modelStack.Rotate(rotatex, 1, 0, 0);
 	modelStack.Rotate(rotatez, 0, 1, 0);
-	RenderMesh(mesh, false);
-	projectionStack.PopMatrix();
-	viewStack.PopMatrix();
+	renderer.DrawMesh(mesh, ortho, modelStack.Top(), false, 0, Renderer::PASS_SCREEN_DEPTH);
 	modelStack.PopMatrix();
 }
 
@@ -482,22 +359,6 @@ void LobbyScene::ResetJournal()
 	evidencePage = 1;
 }
 
-void LobbyScene::ChatDialogueInit(std::string fileName, std::vector<std::string>& vec)
-{
-	std::string temp;
-	std::ifstream inputFile(fileName); // "Text//OldManChat.txt"
-	if (inputFile.is_open())
-	{
-		while (!inputFile.eof())
-		{
-			std::getline(inputFile, temp, ':');
-			vec.push_back(temp);
-			std::getline(inputFile, temp, '\n');
-			vec.push_back(temp);
-		}
-	}
-}
-
 void LobbyScene::RenderInteraction()
 {
 	if (isTalking)
@@ -1316,33 +1177,26 @@ void LobbyScene::RenderInteraction()
 			switch (charId)
 			{
 			case 0:
-				if (chatCounter < guardChat.size() - 1)
+				if (chatCounter < guardChat.GetLineCount())
 				{
-					if (guardChat[chatCounter] == "D")
+					if (guardChat.GetSpeaker(chatCounter) == 'D')
 					{
 						ss.str("");
 						ss << "Detective";
 						RenderTextOnScreen(meshList[GEO_TEXT], ss.str(), Color(0, 0, 1), 2, 13, 15.5); //charId of the person we talking to
 						ss.str("");
-						tempCounter = chatCounter + 1;
-						ss << guardChat[tempCounter];
+						ss << guardChat.GetText(chatCounter);
 						RenderTextOnScreen(meshList[GEO_TEXT], ss.str(), Color(0, 0, 0), 2, 11, 10);
 					}
-					else if (guardChat[chatCounter] == "G")
+					else if (guardChat.GetSpeaker(chatCounter) == 'G')
 					{
 						ss.str("");
 						ss << "Akkop P.";
 						RenderTextOnScreen(meshList[GEO_TEXT], ss.str(), Color(0, .5, 0), 2, 13, 15.5);//charId of the person we talking to
 						ss.str("");
-						tempCounter = chatCounter + 1;
-						ss << guardChat[tempCounter];
+						ss << guardChat.GetText(chatCounter);
 						RenderTextOnScreen(meshList[GEO_TEXT], ss.str(), Color(0, 0, 0), 2, 11, 10);
 					}
-
-					if (chatCounter == tempCounter)
-					{
-						chatCounter++;
-					}
 				}
 				else
 				{
@@ -1355,33 +1209,26 @@ void LobbyScene::RenderInteraction()
 				}
 				break;
 			case 1:
-				if (chatCounter < janitorChat.size() - 1)
+				if (chatCounter < janitorChat.GetLineCount())
 				{
-					if (janitorChat[chatCounter] == "D")
+					if (janitorChat.GetSpeaker(chatCounter) == 'D')
 					{
 						ss.str("");
 						ss << "Detective";
 						RenderTextOnScreen(meshList[GEO_TEXT], ss.str(), Color(0, 0, 1), 2, 13, 15.5);//charId of the person we talking to
 						ss.str("");
-						tempCounter = chatCounter + 1;
-						ss << janitorChat[tempCounter];
+						ss << janitorChat.GetText(chatCounter);
 						RenderTextOnScreen(meshList[GEO_TEXT], ss.str(), Color(0, 0, 0), 2, 11, 10);
 					}
-					else if (janitorChat[chatCounter] == "J")
+					else if (janitorChat.GetSpeaker(chatCounter) == 'J')
 					{
 						ss.str("");
 						ss << "Gertrude H.";
 						RenderTextOnScreen(meshList[GEO_TEXT], ss.str(), Color(0, .5, 0), 2, 13, 15.5); //charId of the person we talking to
 						ss.str("");
-						tempCounter = chatCounter + 1;
-						ss << janitorChat[tempCounter];
+						ss << janitorChat.GetText(chatCounter);
 						RenderTextOnScreen(meshList[GEO_TEXT], ss.str(), Color(0, 0, 0), 2, 11, 10);
 					}
-
-					if (chatCounter == tempCounter)
-					{
-						chatCounter++;
-					}
 				}
 				else
 				{
@@ -1394,33 +1241,26 @@ void LobbyScene::RenderInteraction()
 				}
 				break;
 			case 2:
-				if (chatCounter < gamerChat.size() - 1)
+				if (chatCounter < gamerChat.GetLineCount())
 				{
-					if (gamerChat[chatCounter] == "D")
+					if (gamerChat.GetSpeaker(chatCounter) == 'D')
 					{
 						ss.str("");
 						ss << "Detective";
 						RenderTextOnScreen(meshList[GEO_TEXT], ss.str(), Color(0, 0, 1), 2, 13, 15.5); //charId of the person we talking to
 						ss.str("");
-						tempCounter = chatCounter + 1;
-						ss << gamerChat[tempCounter];
+						ss << gamerChat.GetText(chatCounter);
 						RenderTextOnScreen(meshList[GEO_TEXT], ss.str(), Color(0, 0, 0), 2, 11, 10);
 					}
-					else if (gamerChat[chatCounter] == "A")
+					else if (gamerChat.GetSpeaker(chatCounter) == 'A')
 					{
 						ss.str("");
 						ss << "Ivan S.";
 						RenderTextOnScreen(meshList[GEO_TEXT], ss.str(), Color(0, .5, 0), 2, 13, 15.5);//charId of the person we talking to
 						ss.str("");
-						tempCounter = chatCounter + 1;
-						ss << gamerChat[tempCounter];
+						ss << gamerChat.GetText(chatCounter);
 						RenderTextOnScreen(meshList[GEO_TEXT], ss.str(), Color(0, 0, 0), 2, 11, 10);
 					}
-
-					if (chatCounter == tempCounter)
-					{
-						chatCounter++;
-					}
 				}
 				else
 				{
@@ -1432,33 +1272,26 @@ void LobbyScene::RenderInteraction()
 				}
 				break;
 			case 3:
-				if (chatCounter < kidChat.size() - 1)
+				if (chatCounter < kidChat.GetLineCount())
 				{
-					if (kidChat[chatCounter] == "D")
+					if (kidChat.GetSpeaker(chatCounter) == 'D')
 					{
 						ss.str("");
 						ss << "Detective";
 						RenderTextOnScreen(meshList[GEO_TEXT], ss.str(), Color(0, 0, 1), 2, 13, 15.5); //charId of the person we talking to
 						ss.str("");
-						tempCounter = chatCounter + 1;
-						ss << kidChat[tempCounter];
+						ss << kidChat.GetText(chatCounter);
 						RenderTextOnScreen(meshList[GEO_TEXT], ss.str(), Color(0, 0, 0), 2, 11, 10);
 					}
-					else if (kidChat[chatCounter] == "K")
+					else if (kidChat.GetSpeaker(chatCounter) == 'K')
 					{
 						ss.str("");
 						ss << "Kevin M.";
 						RenderTextOnScreen(meshList[GEO_TEXT], ss.str(), Color(0, .5, 0), 2, 13, 15.5); //charId of the person we talking to
 						ss.str("");
-						tempCounter = chatCounter + 1;
-						ss << kidChat[tempCounter];
+						ss << kidChat.GetText(chatCounter);
 						RenderTextOnScreen(meshList[GEO_TEXT], ss.str(), Color(0, 0, 0), 2, 11, 10);
 					}
-
-					if (chatCounter == tempCounter)
-					{
-						chatCounter++;
-					}
 				}
 				else
 				{
@@ -1471,33 +1304,26 @@ void LobbyScene::RenderInteraction()
 				}
 				break;
 			case 4:
-				if (chatCounter < oldManChat.size() - 1)
+				if (chatCounter < oldManChat.GetLineCount())
 				{
-					if (oldManChat[chatCounter] == "D")
+					if (oldManChat.GetSpeaker(chatCounter) == 'D')
 					{
 						ss.str("");
 						ss << "Detective";
 						RenderTextOnScreen(meshList[GEO_TEXT], ss.str(), Color(0, 0, 1), 2, 13, 15.5);//charId of the person we talking to
 						ss.str("");
-						tempCounter = chatCounter + 1;
-						ss << oldManChat[tempCounter];
+						ss << oldManChat.GetText(chatCounter);
 						RenderTextOnScreen(meshList[GEO_TEXT], ss.str(), Color(0, 0, 0), 2, 11, 10);
 					}
-					else if (oldManChat[chatCounter] == "O")
+					else if (oldManChat.GetSpeaker(chatCounter) == 'O')
 					{
 						ss.str("");
 						ss << "Izan E.";
 						RenderTextOnScreen(meshList[GEO_TEXT], ss.str(), Color(0, .5, 0), 2, 13, 15.5);//charId of the person we talking to
 						ss.str("");
-						tempCounter = chatCounter + 1;
-						ss << oldManChat[tempCounter];
+						ss << oldManChat.GetText(chatCounter);
 						RenderTextOnScreen(meshList[GEO_TEXT], ss.str(), Color(0, 0, 0), 2, 11, 10);
 					}
-
-					if (chatCounter == tempCounter)
-					{
-						chatCounter++;
-					}
 				}
 				else
 				{
@@ -2335,8 +2161,56 @@ void LobbyScene::RenderEvidenceObject(Entity* entity, float rangeX, float rangeZ
 	}
 }
 
+void LobbyScene::Preload()
+{
+	AssetStreamer::RequestMesh("OBJ//officer_male.obj", "OBJ//officer_male.mtl");
+	AssetStreamer::RequestMesh("OBJ//officer_female.obj", "OBJ//officer_female.mtl");
+	AssetStreamer::RequestMesh("OBJ//Gamer.obj", "OBJ//Gamer.mtl");
+	AssetStreamer::RequestMesh("OBJ//Janitor.obj", "OBJ//Janitor.mtl");
+	AssetStreamer::RequestMesh("OBJ//OldMan.obj", "OBJ//OldMan.mtl");
+	AssetStreamer::RequestMesh("OBJ//Kid.obj", "OBJ//Kid.mtl");
+	AssetStreamer::RequestMesh("OBJ//Guard.obj", "OBJ//Guard.mtl");
+	AssetStreamer::RequestMesh("OBJ//ship_dininghall.obj", "OBJ//ship_dininghall.mtl");
+	AssetStreamer::RequestMesh("OBJ//dininghall_tables.obj", "OBJ//dininghall_tables.mtl");
+	AssetStreamer::RequestMesh("OBJ//arcade_machine.obj", "OBJ//arcade_machine.mtl");
+	AssetStreamer::RequestMesh("OBJ//evidence//psycho_pills.obj", "OBJ//evidence//psycho_pills.mtl");
+	AssetStreamer::RequestMesh("OBJ//evidence//writing_notes.obj", "OBJ//evidence//writing_notes.mtl");
+	AssetStreamer::RequestMesh("OBJ//evidence//drinking_bottle.obj", "OBJ//evidence//drinking_bottle.mtl");
+	AssetStreamer::RequestMesh("OBJ//evidence//water_bottle.obj", "OBJ//evidence//water_bottle.mtl");
+	AssetStreamer::RequestMesh("OBJ//evidence//cutlery_knife.obj", "OBJ//evidence//cutlery_knife.mtl");
+
+	AssetStreamer::RequestTexture("Image//Typewriter.tga");
+	AssetStreamer::RequestTexture("Image//PolygonOffice_Texture_01_A.tga");
+	TextureAtlas::GetUI().Request("Image//journal_1.tga");
+	TextureAtlas::GetUI().Request("Image//journal_2.tga");
+	TextureAtlas::GetUI().Request("Image//profile//gamer_profile.tga");
+	TextureAtlas::GetUI().Request("Image//profile//guard_profile.tga");
+	TextureAtlas::GetUI().Request("Image//profile//janitor_profile.tga");
+	TextureAtlas::GetUI().Request("Image//profile//kid_profile.tga");
+	TextureAtlas::GetUI().Request("Image//profile//oldman_profile.tga");
+	TextureAtlas::GetUI().Request("Image//dialogue_bg2.tga");
+	AssetStreamer::RequestTexture("Image//front.tga");
+	AssetStreamer::RequestTexture("Image//back.tga");
+	AssetStreamer::RequestTexture("Image//left.tga");
+	AssetStreamer::RequestTexture("Image//right.tga");
+	AssetStreamer::RequestTexture("Image//top.tga");
+	AssetStreamer::RequestTexture("Image//bottom.tga");
+	AssetStreamer::RequestTexture("Image//PolygonCity_Texture_03_B.tga");
+	AssetStreamer::RequestTexture("Image//PolygonOffice_Texture_02_C.tga");
+	AssetStreamer::RequestTexture("Image//PolygonCity_Texture_01_C.tga");
+	AssetStreamer::RequestTexture("Image//PolygonKids_Texture_01_A.tga");
+	AssetStreamer::RequestTexture("Image//PolygonOffice_Texture_02_A.tga");
+	AssetStreamer::RequestTexture("Image//PolygonOffice_Texture_01_AMachine.tga");
+	AssetStreamer::RequestTexture("Image//PolygonOffice_Texture_04_C.tga");
+	AssetStreamer::RequestTexture("Image//PolygonOffice_Texture_03_B.tga");
+	AssetStreamer::RequestTexture("Image//PolygonTown_Texture_01_A.tga");
+}
+
 void LobbyScene::Init()
 {
+	//meshes of an earlier Init, when the scene is entered again
+	ReleaseMeshes();
+
 	// Init VBO here
 	Mtx44 projection;
 
@@ -2407,86 +2281,32 @@ void LobbyScene::Init()
 	//set background color
 	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 
-	//generate default VAO for now
-	glGenVertexArrays(1, &m_vertexArrayID);
-	glBindVertexArray(m_vertexArrayID);
-
 	//load vertex and fragment shaders
 	m_programID = LoadShaders("Shader//Texture.vertexshader", "Shader//Text.fragmentshader");
+	renderer.Init(m_programID);
+	m_uniforms = &UniformTable::Get(m_programID);
 
 	//Lights m_params
 	{
-		m_parameters[U_MVP] = glGetUniformLocation(m_programID, "MVP");
-		m_parameters[U_MODELVIEW] = glGetUniformLocation(m_programID, "MV");
-		m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE] = glGetUniformLocation(m_programID, "MV_inverse_transpose");
-		m_parameters[U_MATERIAL_AMBIENT] = glGetUniformLocation(m_programID, "material.kAmbient");
-		m_parameters[U_MATERIAL_DIFFUSE] = glGetUniformLocation(m_programID, "material.kDiffuse");
-		m_parameters[U_MATERIAL_SPECULAR] = glGetUniformLocation(m_programID, "material.kSpecular");
-		m_parameters[U_MATERIAL_SHININESS] = glGetUniformLocation(m_programID, "material.kShininess");
-
-		//1st Light (Window)
-		m_parameters[U_LIGHT0_TYPE] = glGetUniformLocation(m_programID, "lights[0].type");
-		m_parameters[U_LIGHT0_SPOTDIRECTION] = glGetUniformLocation(m_programID, "lights[0].spotDirection");
-		m_parameters[U_LIGHT0_COSCUTOFF] = glGetUniformLocation(m_programID, "lights[0].cosCutoff");
-		m_parameters[U_LIGHT0_COSINNER] = glGetUniformLocation(m_programID, "lights[0].cosInner");
-		m_parameters[U_LIGHT0_EXPONENT] = glGetUniformLocation(m_programID, "lights[0].exponent");
-		m_parameters[U_LIGHT0_POSITION] = glGetUniformLocation(m_programID, "lights[0].position_cameraspace");
-		m_parameters[U_LIGHT0_COLOR] = glGetUniformLocation(m_programID, "lights[0].color");
-		m_parameters[U_LIGHT0_POWER] = glGetUniformLocation(m_programID, "lights[0].power");
-		m_parameters[U_LIGHT0_KC] = glGetUniformLocation(m_programID, "lights[0].kC");
-		m_parameters[U_LIGHT0_KL] = glGetUniformLocation(m_programID, "lights[0].kL");
-		m_parameters[U_LIGHT0_KQ] = glGetUniformLocation(m_programID, "lights[0].kQ");
-		
-		//2nd Light (Bar)
-		m_parameters[U_LIGHT1_TYPE] = glGetUniformLocation(m_programID, "lights[1].type");
-		m_parameters[U_LIGHT1_SPOTDIRECTION] = glGetUniformLocation(m_programID, "lights[1].spotDirection");
-		m_parameters[U_LIGHT1_COSCUTOFF] = glGetUniformLocation(m_programID, "lights[1].cosCutoff");
-		m_parameters[U_LIGHT1_COSINNER] = glGetUniformLocation(m_programID, "lights[1].cosInner");
-		m_parameters[U_LIGHT1_EXPONENT] = glGetUniformLocation(m_programID, "lights[1].exponent");
-		m_parameters[U_LIGHT1_POSITION] = glGetUniformLocation(m_programID, "lights[1].position_cameraspace");
-		m_parameters[U_LIGHT1_COLOR] = glGetUniformLocation(m_programID, "lights[1].color");
-		m_parameters[U_LIGHT1_POWER] = glGetUniformLocation(m_programID, "lights[1].power");
-		m_parameters[U_LIGHT1_KC] = glGetUniformLocation(m_programID, "lights[1].kC");
-		m_parameters[U_LIGHT1_KL] = glGetUniformLocation(m_programID, "lights[1].kL");
-		m_parameters[U_LIGHT1_KQ] = glGetUniformLocation(m_programID, "lights[1].kQ");
-
-		//3rd Light (Arcade)
-		m_parameters[U_LIGHT2_TYPE] = glGetUniformLocation(m_programID, "lights[2].type");
-		m_parameters[U_LIGHT2_SPOTDIRECTION] = glGetUniformLocation(m_programID, "lights[2].spotDirection");
-		m_parameters[U_LIGHT2_COSCUTOFF] = glGetUniformLocation(m_programID, "lights[2].cosCutoff");
-		m_parameters[U_LIGHT2_COSINNER] = glGetUniformLocation(m_programID, "lights[2].cosInner");
-		m_parameters[U_LIGHT2_EXPONENT] = glGetUniformLocation(m_programID, "lights[2].exponent");
-		m_parameters[U_LIGHT2_POSITION] = glGetUniformLocation(m_programID, "lights[2].position_cameraspace");
-		m_parameters[U_LIGHT2_COLOR] = glGetUniformLocation(m_programID, "lights[2].color");
-		m_parameters[U_LIGHT2_POWER] = glGetUniformLocation(m_programID, "lights[2].power");
-		m_parameters[U_LIGHT2_KC] = glGetUniformLocation(m_programID, "lights[2].kC");
-		m_parameters[U_LIGHT2_KL] = glGetUniformLocation(m_programID, "lights[2].kL");
-		m_parameters[U_LIGHT2_KQ] = glGetUniformLocation(m_programID, "lights[2].kQ");
+		m_parameters[U_MVP] = m_uniforms->GetLocation("MVP");
+		m_parameters[U_MODELVIEW] = m_uniforms->GetLocation("MV");
+		m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE] = m_uniforms->GetLocation("MV_inverse_transpose");
+		m_parameters[U_MATERIAL_AMBIENT] = m_uniforms->GetLocation("material.kAmbient");
+		m_parameters[U_MATERIAL_DIFFUSE] = m_uniforms->GetLocation("material.kDiffuse");
+		m_parameters[U_MATERIAL_SPECULAR] = m_uniforms->GetLocation("material.kSpecular");
+		m_parameters[U_MATERIAL_SHININESS] = m_uniforms->GetLocation("material.kShininess");
+	}
 
-		//4th Light (Lift)
-		m_parameters[U_LIGHT3_TYPE] = glGetUniformLocation(m_programID, "lights[3].type");
-		m_parameters[U_LIGHT3_SPOTDIRECTION] = glGetUniformLocation(m_programID, "lights[3].spotDirection");
-		m_parameters[U_LIGHT3_COSCUTOFF] = glGetUniformLocation(m_programID, "lights[3].cosCutoff");
-		m_parameters[U_LIGHT3_COSINNER] = glGetUniformLocation(m_programID, "lights[3].cosInner");
-		m_parameters[U_LIGHT3_EXPONENT] = glGetUniformLocation(m_programID, "lights[3].exponent");
-		m_parameters[U_LIGHT3_POSITION] = glGetUniformLocation(m_programID, "lights[3].position_cameraspace");
-		m_parameters[U_LIGHT3_COLOR] = glGetUniformLocation(m_programID, "lights[3].color");
-		m_parameters[U_LIGHT3_POWER] = glGetUniformLocation(m_programID, "lights[3].power");
-		m_parameters[U_LIGHT3_KC] = glGetUniformLocation(m_programID, "lights[3].kC");
-		m_parameters[U_LIGHT3_KL] = glGetUniformLocation(m_programID, "lights[3].kL");
-		m_parameters[U_LIGHT3_KQ] = glGetUniformLocation(m_programID, "lights[3].kQ");
-	}
-
-	m_parameters[U_NUMLIGHTS] = glGetUniformLocation(m_programID, "numLights");
-	m_parameters[U_LIGHTENABLED] = glGetUniformLocation(m_programID, "lightEnabled");
+	m_parameters[U_NUMLIGHTS] = m_uniforms->GetLocation("numLights");
+	m_parameters[U_LIGHTENABLED] = m_uniforms->GetLocation("lightEnabled");
 
 	// Get a handle for our "colorTexture" uniform
-	m_parameters[U_COLOR_TEXTURE_ENABLED] = glGetUniformLocation(m_programID, "colorTextureEnabled");
-	m_parameters[U_COLOR_TEXTURE] = glGetUniformLocation(m_programID, "colorTexture");
+	m_parameters[U_COLOR_TEXTURE_ENABLED] = m_uniforms->GetLocation("colorTextureEnabled");
+	m_parameters[U_COLOR_TEXTURE] = m_uniforms->GetLocation("colorTexture");
 
 	// Get a handle for our "textColor" uniform
-	m_parameters[U_TEXT_ENABLED] = glGetUniformLocation(m_programID, "textEnabled");
-	m_parameters[U_TEXT_COLOR] = glGetUniformLocation(m_programID, "textColor");
+	m_parameters[U_TEXT_ENABLED] = m_uniforms->GetLocation("textEnabled");
+	m_parameters[U_TEXT_COLOR] = m_uniforms->GetLocation("textColor");
 
 	//use our shader
 	glUseProgram(m_programID);
@@ -2494,86 +2314,17 @@ void LobbyScene::Init()
 	// Make sure you pass uniform parameters after glUseProgram()
 	glUniform1i(m_parameters[U_NUMLIGHTS], 4);
 
-	//Lights glParams
+	//Lights glParams: Window, Bar, Arcade, Lift
+	for (unsigned i = 0; i < 4; ++i)
 	{
-		//Light 0 (Window)
-		{
-			//light[0].type = Light::LIGHT_DIRECTIONAL;
-			glUniform1i(m_parameters[U_LIGHT0_TYPE], light[0].type);
-			glUniform3fv(m_parameters[U_LIGHT0_COLOR], 1, &light[0].color.r);
-			glUniform1f(m_parameters[U_LIGHT0_POWER], light[0].power);
-
-			//light[0].type = Light::LIGHT_POINT;
-			glUniform1f(m_parameters[U_LIGHT0_KC], light[0].kC);
-			glUniform1f(m_parameters[U_LIGHT0_KL], light[0].kL);
-			glUniform1f(m_parameters[U_LIGHT0_KQ], light[0].kQ);
-
-			//light[0].type = Light::LIGHT_SPOT;
-			glUniform1f(m_parameters[U_LIGHT0_COSCUTOFF], light[0].cosCutoff);
-			glUniform1f(m_parameters[U_LIGHT0_COSINNER], light[0].cosInner);
-			glUniform1f(m_parameters[U_LIGHT0_EXPONENT], light[0].exponent);
-		}
-
-		//Light 1 (Bar)
-		{
-			//light[1].type = Light::LIGHT_DIRECTIONAL;
-			glUniform1i(m_parameters[U_LIGHT1_TYPE], light[1].type);
-			glUniform3fv(m_parameters[U_LIGHT1_COLOR], 1, &light[1].color.r);
-			glUniform1f(m_parameters[U_LIGHT1_POWER], light[1].power);
-
-			//light[1].type = Light::LIGHT_POINT;
-			glUniform1f(m_parameters[U_LIGHT1_KC], light[1].kC);
-			glUniform1f(m_parameters[U_LIGHT1_KL], light[1].kL);
-			glUniform1f(m_parameters[U_LIGHT1_KQ], light[1].kQ);
-
-			//light[1].type = Light::LIGHT_SPOT;
-			glUniform1f(m_parameters[U_LIGHT1_COSCUTOFF], light[1].cosCutoff);
-			glUniform1f(m_parameters[U_LIGHT1_COSINNER], light[1].cosInner);
-			glUniform1f(m_parameters[U_LIGHT1_EXPONENT], light[1].exponent);
-		}
-
-		//Light 2 (Arcade)
-		{
-			//light[2].type = Light::LIGHT_DIRECTIONAL;
-			glUniform1i(m_parameters[U_LIGHT2_TYPE], light[2].type);
-			glUniform3fv(m_parameters[U_LIGHT2_COLOR], 1, &light[2].color.r);
-			glUniform1f(m_parameters[U_LIGHT2_POWER], light[2].power);
-
-			//light[2].type = Light::LIGHT_POINT;
-			glUniform1f(m_parameters[U_LIGHT2_KC], light[2].kC);
-			glUniform1f(m_parameters[U_LIGHT2_KL], light[2].kL);
-			glUniform1f(m_parameters[U_LIGHT2_KQ], light[2].kQ);
-
-			//light[2].type = Light::LIGHT_SPOT;
-			glUniform1f(m_parameters[U_LIGHT2_COSCUTOFF], light[2].cosCutoff);
-			glUniform1f(m_parameters[U_LIGHT2_COSINNER], light[2].cosInner);
-			glUniform1f(m_parameters[U_LIGHT2_EXPONENT], light[2].exponent);
-		}
-
-		//Light 3 (Lift)
-		{
-			//light[3].type = Light::LIGHT_DIRECTIONAL;
-			glUniform1i(m_parameters[U_LIGHT3_TYPE], light[3].type);
-			glUniform3fv(m_parameters[U_LIGHT3_COLOR], 1, &light[3].color.r);
-			glUniform1f(m_parameters[U_LIGHT3_POWER], light[3].power);
-
-			//light[3].type = Light::LIGHT_POINT;
-			glUniform1f(m_parameters[U_LIGHT3_KC], light[3].kC);
-			glUniform1f(m_parameters[U_LIGHT3_KL], light[3].kL);
-			glUniform1f(m_parameters[U_LIGHT3_KQ], light[3].kQ);
-
-			//light[3].type = Light::LIGHT_SPOT;
-			glUniform1f(m_parameters[U_LIGHT3_COSCUTOFF], light[3].cosCutoff);
-			glUniform1f(m_parameters[U_LIGHT3_COSINNER], light[3].cosInner);
-			glUniform1f(m_parameters[U_LIGHT3_EXPONENT], light[3].exponent);
-		}
+		m_uniforms->SetLight(i, light[i]);
 	}
 
 	//Enable depth test
 	glEnable(GL_DEPTH_TEST);
 
 	//Get a handle for our "MVP" uniform
-	m_parameters[U_MVP] = glGetUniformLocation(m_programID, "MVP");
+	m_parameters[U_MVP] = m_uniforms->GetLocation("MVP");
 
 	Mesh::SetMaterialLoc(m_parameters[U_MATERIAL_AMBIENT],
 		m_parameters[U_MATERIAL_DIFFUSE],
@@ -2595,33 +2346,25 @@ void LobbyScene::Init()
 
 	//Journal
 	{
-		meshList[GEO_JOURNAL_PAGE1] = MeshBuilder::GenerateQuad("Journal Page 1", Color(1, 1, 1), 1.f);
-		meshList[GEO_JOURNAL_PAGE1]->textureID = LoadTGA("Image//journal_1.tga");
+		meshList[GEO_JOURNAL_PAGE1] = MeshBuilder::GenerateQuad("Journal Page 1", Color(1, 1, 1), 1.f, TextureAtlas::GetUI().AcquireRegion("Image//journal_1.tga"));
 
-		meshList[GEO_JOURNAL_PAGE2] = MeshBuilder::GenerateQuad("Journal Page 2", Color(1, 1, 1), 1.f);
-		meshList[GEO_JOURNAL_PAGE2]->textureID = LoadTGA("Image//journal_2.tga");
+		meshList[GEO_JOURNAL_PAGE2] = MeshBuilder::GenerateQuad("Journal Page 2", Color(1, 1, 1), 1.f, TextureAtlas::GetUI().AcquireRegion("Image//journal_2.tga"));
 
 
-		meshList[GEO_CHARACTER_PROFILE1] = MeshBuilder::GenerateQuad("Gamer Profile", Color(1, 1, 1), 1.f);
-		meshList[GEO_CHARACTER_PROFILE1]->textureID = LoadTGA("Image//profile//gamer_profile.tga");
+		meshList[GEO_CHARACTER_PROFILE1] = MeshBuilder::GenerateQuad("Gamer Profile", Color(1, 1, 1), 1.f, TextureAtlas::GetUI().AcquireRegion("Image//profile//gamer_profile.tga"));
 
-		meshList[GEO_CHARACTER_PROFILE2] = MeshBuilder::GenerateQuad("Guard Profile", Color(1, 1, 1), 1.f);
-		meshList[GEO_CHARACTER_PROFILE2]->textureID = LoadTGA("Image//profile//guard_profile.tga");
+		meshList[GEO_CHARACTER_PROFILE2] = MeshBuilder::GenerateQuad("Guard Profile", Color(1, 1, 1), 1.f, TextureAtlas::GetUI().AcquireRegion("Image//profile//guard_profile.tga"));
 
-		meshList[GEO_CHARACTER_PROFILE3] = MeshBuilder::GenerateQuad("Janitor Profile", Color(1, 1, 1), 1.f);
-		meshList[GEO_CHARACTER_PROFILE3]->textureID = LoadTGA("Image//profile//janitor_profile.tga");
+		meshList[GEO_CHARACTER_PROFILE3] = MeshBuilder::GenerateQuad("Janitor Profile", Color(1, 1, 1), 1.f, TextureAtlas::GetUI().AcquireRegion("Image//profile//janitor_profile.tga"));
 
-		meshList[GEO_CHARACTER_PROFILE4] = MeshBuilder::GenerateQuad("Kid Profile", Color(1, 1, 1), 1.f);
-		meshList[GEO_CHARACTER_PROFILE4]->textureID = LoadTGA("Image//profile//kid_profile.tga");
+		meshList[GEO_CHARACTER_PROFILE4] = MeshBuilder::GenerateQuad("Kid Profile", Color(1, 1, 1), 1.f, TextureAtlas::GetUI().AcquireRegion("Image//profile//kid_profile.tga"));
 
-		meshList[GEO_CHARACTER_PROFILE5] = MeshBuilder::GenerateQuad("Old Man Profile", Color(1, 1, 1), 1.f);
-		meshList[GEO_CHARACTER_PROFILE5]->textureID = LoadTGA("Image//profile//oldman_profile.tga");
+		meshList[GEO_CHARACTER_PROFILE5] = MeshBuilder::GenerateQuad("Old Man Profile", Color(1, 1, 1), 1.f, TextureAtlas::GetUI().AcquireRegion("Image//profile//oldman_profile.tga"));
 	}
 
 	//Dialogue BG
 	{
-		meshList[GEO_DIALOGUE] = MeshBuilder::GenerateQuad("dialogue", Color(0.5, 0.5, 0.5), 1.f);
-		meshList[GEO_DIALOGUE]->textureID = LoadTGA("Image//dialogue_bg2.tga");
+		meshList[GEO_DIALOGUE] = MeshBuilder::GenerateQuad("dialogue", Color(0.5, 0.5, 0.5), 1.f, TextureAtlas::GetUI().AcquireRegion("Image//dialogue_bg2.tga"));
 	}
 
 	//Skybox 
@@ -2733,11 +2476,12 @@ LobbyScene::LobbyScene()
 	camera.Init(Vector3(-7, 1.5f, 30), Vector3(0, 1.5, 30), Vector3(0, 1, 0));
 
 	//Init dialogues
-	ChatDialogueInit("Text//GuardChat.txt", guardChat);// file format to be like this "Text//OldManChat.txt" and vector to store into
-	ChatDialogueInit("Text//JanitorChat.txt", janitorChat);
-	ChatDialogueInit("Text//GamerChat.txt", gamerChat);
-	ChatDialogueInit("Text//KidChat.txt", kidChat);
-	ChatDialogueInit("Text//OldManChat.txt", oldManChat);
+	const DialogueTable& dialogue = DialogueTable::Get();
+	guardChat = dialogue.Find("GuardChat");
+	janitorChat = dialogue.Find("JanitorChat");
+	gamerChat = dialogue.Find("GamerChat");
+	kidChat = dialogue.Find("KidChat");
+	oldManChat = dialogue.Find("OldManChat");
 
 	Application::AddEvidence("Guest list: Kids", "Kid");
 	Application::AddEvidence("Guest list: daughter", "Old Man");
@@ -2882,27 +2626,27 @@ void LobbyScene::Render()
 	modelStack.LoadIdentity();
 
 	Position lightPosition_cameraspace = viewStack.Top() * light[0].position;
-	glUniform3fv(m_parameters[U_LIGHT0_POSITION], 1, &lightPosition_cameraspace.x);
+	glUniform3fv(m_uniforms->GetLight(0, UniformTable::LIGHT_POSITION), 1, &lightPosition_cameraspace.x);
 	Vector3 spotDirection_cameraspace = viewStack.Top() * light[0].spotDirection;
-	glUniform3fv(m_parameters[U_LIGHT0_SPOTDIRECTION], 1, &spotDirection_cameraspace.x);
+	glUniform3fv(m_uniforms->GetLight(0, UniformTable::LIGHT_SPOTDIRECTION), 1, &spotDirection_cameraspace.x);
 
 	//2nd Light Parameters
 	lightPosition_cameraspace = viewStack.Top() * light[1].position;
-	glUniform3fv(m_parameters[U_LIGHT1_POSITION], 1, &lightPosition_cameraspace.x);
+	glUniform3fv(m_uniforms->GetLight(1, UniformTable::LIGHT_POSITION), 1, &lightPosition_cameraspace.x);
 	spotDirection_cameraspace = viewStack.Top() * light[1].spotDirection;
-	glUniform3fv(m_parameters[U_LIGHT1_SPOTDIRECTION], 1, &spotDirection_cameraspace.x);
+	glUniform3fv(m_uniforms->GetLight(1, UniformTable::LIGHT_SPOTDIRECTION), 1, &spotDirection_cameraspace.x);
 
 	//3rd Light Parameters
 	lightPosition_cameraspace = viewStack.Top() * light[2].position;
-	glUniform3fv(m_parameters[U_LIGHT2_POSITION], 1, &lightPosition_cameraspace.x);
+	glUniform3fv(m_uniforms->GetLight(2, UniformTable::LIGHT_POSITION), 1, &lightPosition_cameraspace.x);
 	spotDirection_cameraspace = viewStack.Top() * light[2].spotDirection;
-	glUniform3fv(m_parameters[U_LIGHT2_SPOTDIRECTION], 1, &spotDirection_cameraspace.x);
+	glUniform3fv(m_uniforms->GetLight(2, UniformTable::LIGHT_SPOTDIRECTION), 1, &spotDirection_cameraspace.x);
 
 	//4th Light Parameters
 	lightPosition_cameraspace = viewStack.Top() * light[3].position;
-	glUniform3fv(m_parameters[U_LIGHT3_POSITION], 1, &lightPosition_cameraspace.x);
+	glUniform3fv(m_uniforms->GetLight(3, UniformTable::LIGHT_POSITION), 1, &lightPosition_cameraspace.x);
 	spotDirection_cameraspace = viewStack.Top() * light[3].spotDirection;
-	glUniform3fv(m_parameters[U_LIGHT3_SPOTDIRECTION], 1, &spotDirection_cameraspace.x);
+	glUniform3fv(m_uniforms->GetLight(3, UniformTable::LIGHT_SPOTDIRECTION), 1, &spotDirection_cameraspace.x);
 
 	modelStack.PushMatrix();
 	modelStack.Rotate(rotateSkybox, 0,1,0);
@@ -2972,11 +2716,27 @@ void LobbyScene::Render()
 	{
 		RenderJournal();
 	}
+
+	renderer.Flush();
+}
+
+//Delete the scene's meshes, releasing the assets they share through the AssetRegistry
+void LobbyScene::ReleaseMeshes()
+{
+	for (int i = 0; i < NUM_GEOMETRY; ++i)
+	{
+		delete meshList[i];
+		meshList[i] = nullptr;
+	}
+	for (int i = 0; i < NUM_ENTITY; ++i)
+	{
+		delete entityList[i].getMesh();
+		entityList[i].setMesh(nullptr);
+	}
 }
 
 void LobbyScene::Exit()
 {
-	// Cleanup VBO here
-	glDeleteVertexArrays(1, &m_vertexArrayID);
-	glDeleteProgram(m_programID);
+	ReleaseMeshes();
+	//the program is shared, ClearShaderCache frees it
 }
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include "Mesh.h"
 #include "MatrixStack.h"
 #include "Light.h"
+#include "UniformTable.h"
+#include "DialogueTable.h"
 #include "Utility.h"
 #include "LoadTGA.h"
 #include "Entity.h"
@@ -81,54 +83,6 @@ private:
 		U_MATERIAL_DIFFUSE,
 		U_MATERIAL_SPECULAR,
 		U_MATERIAL_SHININESS,
-		//Lights 1 (Window)
-		U_LIGHT0_POSITION,
-		U_LIGHT0_COLOR,
-		U_LIGHT0_POWER,
-		U_LIGHT0_KC,
-		U_LIGHT0_KL,
-		U_LIGHT0_KQ,
-		U_LIGHT0_TYPE,
-		U_LIGHT0_SPOTDIRECTION,
-		U_LIGHT0_COSCUTOFF,
-		U_LIGHT0_COSINNER,
-		U_LIGHT0_EXPONENT,
-		//Lights 2 (Bar)
-		U_LIGHT1_POSITION,
-		U_LIGHT1_COLOR,
-		U_LIGHT1_POWER,
-		U_LIGHT1_KC,
-		U_LIGHT1_KL,
-		U_LIGHT1_KQ,
-		U_LIGHT1_TYPE,
-		U_LIGHT1_SPOTDIRECTION,
-		U_LIGHT1_COSCUTOFF,
-		U_LIGHT1_COSINNER,
-		U_LIGHT1_EXPONENT,
-		//Lights 3 (Arcade)
-		U_LIGHT2_POSITION,
-		U_LIGHT2_COLOR,
-		U_LIGHT2_POWER,
-		U_LIGHT2_KC,
-		U_LIGHT2_KL,
-		U_LIGHT2_KQ,
-		U_LIGHT2_TYPE,
-		U_LIGHT2_SPOTDIRECTION,
-		U_LIGHT2_COSCUTOFF,
-		U_LIGHT2_COSINNER,
-		U_LIGHT2_EXPONENT,
-		//Lights 4 (Lift)
-		U_LIGHT3_POSITION,
-		U_LIGHT3_COLOR,
-		U_LIGHT3_POWER,
-		U_LIGHT3_KC,
-		U_LIGHT3_KL,
-		U_LIGHT3_KQ,
-		U_LIGHT3_TYPE,
-		U_LIGHT3_SPOTDIRECTION,
-		U_LIGHT3_COSCUTOFF,
-		U_LIGHT3_COSINNER,
-		U_LIGHT3_EXPONENT,
 		//Others
 		U_LIGHTENABLED,
 		U_NUMLIGHTS,
@@ -150,22 +104,21 @@ private:
 	int interactOffset;
 	bool canInteract;
 	bool isTalking, isChatting, isAbleToTalk, isAbleToPin, isDoneGaming;
-	int chatCounter = 0;
-	int tempCounter = 0;
+	unsigned chatCounter = 0;
 	bool isInterrogate;
 	bool isGossiping;
 	bool printGossip, printInterrogate, haveEvidence;
 	std::ostringstream ss;
 	std::string screenTxt, culpritText;
-	std::vector <std::string> guardChat;
-	std::vector <std::string> janitorChat;
-	std::vector <std::string> gamerChat;
-	std::vector <std::string> kidChat;
-	std::vector <std::string> oldManChat;
+	DialogueTable::Conversation guardChat;
+	DialogueTable::Conversation janitorChat;
+	DialogueTable::Conversation gamerChat;
+	DialogueTable::Conversation kidChat;
+	DialogueTable::Conversation oldManChat;
 
 	unsigned m_parameters[U_TOTAL];
-	unsigned m_vertexArrayID;
-	Mesh* meshList[NUM_GEOMETRY];
+	const UniformTable* m_uniforms;
+	Mesh* meshList[NUM_GEOMETRY] = {};
 	Entity entityList[NUM_ENTITY];
 
 	unsigned m_programID;
@@ -185,10 +138,12 @@ private:
 	bool Inspect;
 
 	void RenderMesh(Mesh* mesh, bool enableLight);
+	void RenderMeshInstanced(Mesh* mesh, const std::vector<Mtx44>& models, bool enableLight);
 	void RenderEntity(Entity* entity, bool enableLight);
 	void RenderMeshOnScreen(Mesh* mesh, float x, float y, float sizex, float sizey);
 	void RenderText(Mesh* mesh, std::string text, Color color);
 	void RenderTextOnScreen(Mesh* mesh, std::string text, Color color, float size, float x, float y);
+	void ReleaseMeshes();
 	void RenderEvidenceObject(Entity* entity, float rangeX, float rangeY);
 	void InspectEvidenceOnScreen(Mesh* mesh, float x, float y, float sizex, float sizey, float rotatez, float rotatex);
 	void RenderSkybox();
@@ -200,7 +155,6 @@ private:
 	void ResetJournal();
 	void PrintEvidence();	//for journal
 	void PrintProfiles();	//for char profile
-	void ChatDialogueInit(std::string, std::vector<std::string>& vec);
 	void RenderInteraction();
 	void Interaction();
 	void TalkButtons();
@@ -212,6 +166,7 @@ private:
 
 public:
 	LobbyScene();
+	virtual void Preload();
 	virtual void Init();
 	virtual void Update(double dt);
 	virtual void Render();
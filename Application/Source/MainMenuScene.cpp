@@ -2,136 +2,43 @@
 #include "GL\glew.h"
 
 #include "shader.hpp"
+#include "UniformTable.h"
 #include "MeshBuilder.h"
+#include "TextureAtlas.h"
 
 #define LSPEED 20
 
 void MainMenuScene::RenderMesh(Mesh* mesh, bool enableLight)
 {
-	Mtx44 MVP, modelView, modelView_inverse_transpose;
-
-	MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, &MVP.a[0]);
-	modelView = viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MODELVIEW], 1, GL_FALSE, &modelView.a[0]);
-	if (enableLight)
-	{
-		modelView_inverse_transpose = modelView.GetInverse().GetTranspose();
-		glUniformMatrix4fv(m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE], 1, GL_FALSE, &modelView_inverse_transpose.a[0]);
-
-		//load material
-		glUniform3fv(m_parameters[U_MATERIAL_AMBIENT], 1, &mesh->material.kAmbient.r);
-		glUniform3fv(m_parameters[U_MATERIAL_DIFFUSE], 1, &mesh->material.kDiffuse.r);
-		glUniform3fv(m_parameters[U_MATERIAL_SPECULAR], 1, &mesh->material.kSpecular.r);
-		glUniform1f(m_parameters[U_MATERIAL_SHININESS], mesh->material.kShininess);
-	}
-
-	if (mesh->textureID > 0)
-	{
-		glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 1);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, mesh->textureID);
-		glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
-	}
-	else
-	{
-		glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 0);
-	}
-	mesh->Render(); //this line should only be called once
-	if (mesh->textureID > 0)
-	{
-		glBindTexture(GL_TEXTURE_2D, 0);
-	}
+	Mtx44 modelView = viewStack.Top() * modelStack.Top();
+	//imported meshes with LODs, such as the dining hall tables, draw a coarser one from afar
+	renderer.DrawMesh(mesh, projectionStack.Top(), modelView, enableLight,
+		mesh != nullptr ? mesh->SelectLod(modelView, projectionStack.Top()) : 0);
 }
 
 void MainMenuScene::RenderEntity(Entity* entity, bool enableLight)
 {
-	modelStack.PushMatrix();
-	modelStack.Translate(entity->getTransform().x, entity->getTransform().y, entity->getTransform().z);
-	modelStack.Rotate(entity->getRotationAngle(), entity->getRotationAxis().x, entity->getRotationAxis().y, entity->getRotationAxis().z);
-	modelStack.Scale(entity->getScale().x, entity->getScale().x, entity->getScale().x);
-
-	Mtx44 MVP, modelView, modelView_inverse_transpose;
-
-	MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, &MVP.a[0]);
-	modelView = viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MODELVIEW], 1, GL_FALSE, &modelView.a[0]);
-	if (enableLight)
-	{
-		modelView_inverse_transpose = modelView.GetInverse().GetTranspose();
-		glUniformMatrix4fv(m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE], 1, GL_FALSE, &modelView_inverse_transpose.a[0]);
-
-		//load material
-		glUniform3fv(m_parameters[U_MATERIAL_AMBIENT], 1, &entity->getMesh()->material.kAmbient.r);
-		glUniform3fv(m_parameters[U_MATERIAL_DIFFUSE], 1, &entity->getMesh()->material.kDiffuse.r);
-		glUniform3fv(m_parameters[U_MATERIAL_SPECULAR], 1, &entity->getMesh()->material.kSpecular.r);
-		glUniform1f(m_parameters[U_MATERIAL_SHININESS], entity->getMesh()->material.kShininess);
-	}
-
-	if (entity->getMesh()->textureID > 0)
-	{
-		glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 1);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, entity->getMesh()->textureID);
-		glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
-	}
-	else
-	{
-		glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 0);
-	}
-	entity->getMesh()->Render(); //this line should only be called once
-	if (entity->getMesh()->textureID > 0)
-	{
-		glBindTexture(GL_TEXTURE_2D, 0);
-	}
-
-	modelStack.PopMatrix();
+	Mtx44 modelView = viewStack.Top() * modelStack.Top() * entity->getModelMatrix();
+	//distant characters and props draw a coarser LOD
+	Mesh* mesh = entity->getMesh();
+	renderer.DrawMesh(mesh, projectionStack.Top(), modelView, enableLight, mesh->SelectLod(modelView, projectionStack.Top()));
 }
 
 void MainMenuScene::RenderText(Mesh* mesh, std::string text, Color color)
 {
-	if (!mesh || mesh->textureID <= 0) //Proper error check
-	{
-		return;
-	}
-	glUniform1i(m_parameters[U_TEXT_ENABLED], 1);
-	glUniform3fv(m_parameters[U_TEXT_COLOR], 1, &color.r);
-	glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 1);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, mesh->textureID);
-	glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
-	for (unsigned i = 0; i < text.length(); ++i)
-	{
-		Mtx44 characterSpacing;
-		characterSpacing.SetToTranslation(i * 1.0f, 0, 0); //1.0f is the spacing of each character, you may change this value
-		Mtx44 MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top() * characterSpacing;
-		glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, &MVP.a[0]);
-		mesh->Render((unsigned)text[i] * 6, 6);
-	}
-
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glUniform1i(m_parameters[U_TEXT_ENABLED], 0);
+	renderer.DrawText(mesh, text, color, projectionStack.Top() * viewStack.Top() * modelStack.Top(), 1.0f);
 }
 
 void MainMenuScene::RenderMeshOnScreen(Mesh* mesh, float x, float y, float sizex, float sizey)
 {
-	glDisable(GL_DEPTH_TEST);
 	Mtx44 ortho;
 	ortho.SetToOrtho(0, Application::screenUISizeX, 0, Application::screenUISizeY, -10, 10); //size of screen UI
-	projectionStack.PushMatrix();
-	projectionStack.LoadMatrix(ortho);
-	viewStack.PushMatrix();
-	viewStack.LoadIdentity(); //No need camera for ortho mode
 	modelStack.PushMatrix();
 	modelStack.LoadIdentity(); //Reset modelStack
 	modelStack.Translate(x, y, 0);
 	modelStack.Scale(sizex, sizey, 1);
-	RenderMesh(mesh, false);
-	projectionStack.PopMatrix();
-	viewStack.PopMatrix();
+	renderer.DrawMesh(mesh, ortho, modelStack.Top(), false, 0, Renderer::PASS_SCREEN);
 	modelStack.PopMatrix();
-	glEnable(GL_DEPTH_TEST);
 }
 
 void MainMenuScene::RenderTextOnScreen(Mesh* mesh, std::string text, Color color, float size, float x, float y)
@@ -142,39 +49,14 @@ void MainMenuScene::RenderTextOnScreen(Mesh* mesh, std::string text, Color color
 	{
 		return;
 	}
-	glDisable(GL_DEPTH_TEST);
 	Mtx44 ortho;
 	ortho.SetToOrtho(0, Application::screenUISizeX, 0, Application::screenUISizeY, -10, 10); //size of screen UI
-	projectionStack.PushMatrix();
-	projectionStack.LoadMatrix(ortho);
-	viewStack.PushMatrix();
-	viewStack.LoadIdentity(); //No need camera for ortho mode
 	modelStack.PushMatrix();
 	modelStack.LoadIdentity(); //Reset modelStack
 	modelStack.Translate(x - (text.size() * (0.5f * spacing))*size, y, 0);
 	modelStack.Scale(size, size, size);
-	glUniform1i(m_parameters[U_TEXT_ENABLED], 1);
-	glUniform3fv(m_parameters[U_TEXT_COLOR], 1, &color.r);
-	glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 1);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, mesh->textureID);
-	glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
-	for (unsigned i = 0; i < text.length(); ++i)
-	{
-		Mtx44 characterSpacing;
-		std::stringstream ss;
-		characterSpacing.SetToTranslation(0.5f + i * spacing, 0.5f, 0); //1.0f is the spacing of each character, you may change this value
-		Mtx44 MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top() * characterSpacing;
-		glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, &MVP.a[0]);
-		mesh->Render((unsigned)text[i] * 6, 6);
-	}
-
-		glBindTexture(GL_TEXTURE_2D, 0);
-		glUniform1i(m_parameters[U_TEXT_ENABLED], 0);
-		projectionStack.PopMatrix();
-		viewStack.PopMatrix();
-		modelStack.PopMatrix();
-		glEnable(GL_DEPTH_TEST);
+	renderer.DrawText(mesh, text, color, ortho * modelStack.Top(), spacing, 0.5f, 0.5f, Renderer::PASS_SCREEN);
+	modelStack.PopMatrix();
 }
 
 bool MainMenuScene::CreateButton(float buttonTop, float buttonBottom, float buttonRight, float buttonLeft)
@@ -335,9 +217,8 @@ void MainMenuScene::RenderMainMenu()
 		}
 		else
 		{
-			Application::soundManager.ReleaseSound(Application::soundList[Application::SOUND_MAINMENU]);
-			Application::soundManager.CreateSound(&Application::soundList[Application::SOUND_MAINGAME], "Sound/MainGame.wav");
-			Application::soundManager.RunSound(Application::soundList[Application::SOUND_MAINGAME], true);
+			Application::soundManager.StopAll(Application::SOUND_MAINMENU);
+			Application::soundManager.Play(Application::SOUND_MAINGAME, true);
 			Application::skipIntro = true;
 			Application::sceneState = Application::STATE_MAINMENU_EXIT;
 		}
@@ -710,6 +591,9 @@ MainMenuScene::~MainMenuScene()
 
 void MainMenuScene::Init()
 {
+	//meshes of an earlier Init, when the scene is entered again
+	ReleaseMeshes();
+
 	// Init VBO here
 	Mtx44 projection;
 
@@ -727,28 +611,26 @@ void MainMenuScene::Init()
 	//set background color
 	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 
-	//generate default VAO for now
-	glGenVertexArrays(1, &m_vertexArrayID);
-	glBindVertexArray(m_vertexArrayID);
-
 	//load vertex and fragment shaders
 	m_programID = LoadShaders("Shader//Texture.vertexshader", "Shader//Text.fragmentshader");
+	renderer.Init(m_programID);
+	const UniformTable& uniforms = UniformTable::Get(m_programID);
 
-	m_parameters[U_MVP] = glGetUniformLocation(m_programID, "MVP");
-	m_parameters[U_MODELVIEW] = glGetUniformLocation(m_programID, "MV");
-	m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE] = glGetUniformLocation(m_programID, "MV_inverse_transpose");
-	m_parameters[U_MATERIAL_AMBIENT] = glGetUniformLocation(m_programID, "material.kAmbient");
-	m_parameters[U_MATERIAL_DIFFUSE] = glGetUniformLocation(m_programID, "material.kDiffuse");
-	m_parameters[U_MATERIAL_SPECULAR] = glGetUniformLocation(m_programID, "material.kSpecular");
-	m_parameters[U_MATERIAL_SHININESS] = glGetUniformLocation(m_programID, "material.kShininess");
+	m_parameters[U_MVP] = uniforms.GetLocation("MVP");
+	m_parameters[U_MODELVIEW] = uniforms.GetLocation("MV");
+	m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE] = uniforms.GetLocation("MV_inverse_transpose");
+	m_parameters[U_MATERIAL_AMBIENT] = uniforms.GetLocation("material.kAmbient");
+	m_parameters[U_MATERIAL_DIFFUSE] = uniforms.GetLocation("material.kDiffuse");
+	m_parameters[U_MATERIAL_SPECULAR] = uniforms.GetLocation("material.kSpecular");
+	m_parameters[U_MATERIAL_SHININESS] = uniforms.GetLocation("material.kShininess");
 
 	// Get a handle for our "colorTexture" uniform
-	m_parameters[U_COLOR_TEXTURE_ENABLED] = glGetUniformLocation(m_programID, "colorTextureEnabled");
-	m_parameters[U_COLOR_TEXTURE] = glGetUniformLocation(m_programID, "colorTexture");
+	m_parameters[U_COLOR_TEXTURE_ENABLED] = uniforms.GetLocation("colorTextureEnabled");
+	m_parameters[U_COLOR_TEXTURE] = uniforms.GetLocation("colorTexture");
 
 	// Get a handle for our "textColor" uniform
-	m_parameters[U_TEXT_ENABLED] = glGetUniformLocation(m_programID, "textEnabled");
-	m_parameters[U_TEXT_COLOR] = glGetUniformLocation(m_programID, "textColor");
+	m_parameters[U_TEXT_ENABLED] = uniforms.GetLocation("textEnabled");
+	m_parameters[U_TEXT_COLOR] = uniforms.GetLocation("textColor");
 
 	//use our shader
 	glUseProgram(m_programID);
@@ -757,7 +639,7 @@ void MainMenuScene::Init()
 	glEnable(GL_DEPTH_TEST);
 
 	//Get a handle for our "MVP" uniform
-	m_parameters[U_MVP] = glGetUniformLocation(m_programID, "MVP");
+	m_parameters[U_MVP] = uniforms.GetLocation("MVP");
 
 	Mesh::SetMaterialLoc(m_parameters[U_MATERIAL_AMBIENT],
 		m_parameters[U_MATERIAL_DIFFUSE],
@@ -791,8 +673,7 @@ void MainMenuScene::Init()
 	meshList[GEO_TEXT] = MeshBuilder::GenerateText("text", 16, 16);
 	meshList[GEO_TEXT]->textureID = LoadTGA("Image//typewriter.tga");
 
-	meshList[GEO_TITLEBG] = MeshBuilder::GenerateQuad("titlebg", 16, 16);
-	meshList[GEO_TITLEBG]->textureID = LoadTGA("Image//dialogue_bg2.tga");
+	meshList[GEO_TITLEBG] = MeshBuilder::GenerateQuad("titlebg", 16, 16, TextureAtlas::GetUI().AcquireRegion("Image//dialogue_bg2.tga"));
 
 	//hide and reset the cursor
 	Application::ResetCursor();
@@ -803,8 +684,7 @@ void MainMenuScene::Init()
 	//main menu bgm
 	if (Application::skipIntro == false)
 	{
-		Application::soundManager.CreateSound(&Application::soundList[Application::SOUND_MAINMENU], "Sound/MainMenu.wav");
-		Application::soundManager.RunSound(Application::soundList[Application::SOUND_MAINMENU], true);
+		Application::soundManager.Play(Application::SOUND_MAINMENU, true);
 	}
 }
 
@@ -860,11 +740,22 @@ void MainMenuScene::Render()
 	modelStack.PopMatrix();
 
 	RenderMainMenu();
+
+	renderer.Flush();
+}
+
+//Delete the scene's meshes, releasing the assets they share through the AssetRegistry
+void MainMenuScene::ReleaseMeshes()
+{
+	for (int i = 0; i < NUM_GEOMETRY; ++i)
+	{
+		delete meshList[i];
+		meshList[i] = nullptr;
+	}
 }
 
 void MainMenuScene::Exit()
 {
-	// Cleanup VBO here
-	glDeleteVertexArrays(1, &m_vertexArrayID);
-	glDeleteProgram(m_programID);
+	ReleaseMeshes();
+	//the program is shared, ClearShaderCache frees it
 }
\ No newline at end of file
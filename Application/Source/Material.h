@@ -42,4 +42,8 @@ struct Material
 	}
 
 	Material();
+	Material(const Material& rhs)
+	{
+		*this = rhs;
+	}
 };
\ No newline at end of file
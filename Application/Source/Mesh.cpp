@@ -1,10 +1,39 @@
+#include <cstring>
 #include "Mesh.h"
+#include "AssetRegistry.h"
 #include "GL\glew.h"
 
+//layout(location) of the per-instance model matrix in Texture.vertexshader; a
+//mat4 takes this location and the next three, one per column
+static const unsigned INSTANCE_MODEL_LOCATION = 4;
+
+//Projected radius, as a fraction of half the screen height, below which each LOD is drawn
+static const float LOD_SCREEN_SIZES[Mesh::MAX_LODS] = { 0.25f, 0.1f, 0.04f };
+
+//std140 layout of the MeshMaterials block in Text.fragmentshader
+struct MaterialBlock
+{
+	int count;
+	int padding[3];
+	int ends[Mesh::MAX_BLOCK_MATERIALS]; //triangle after each material's last, an ivec4 array in GLSL
+	struct
+	{
+		float kAmbient[3], padding0;
+		float kDiffuse[3], padding1;
+		float kSpecular[3];
+		float kShininess;
+	} materials[Mesh::MAX_BLOCK_MATERIALS];
+};
+
+//Range last bound to MATERIAL_BLOCK_BINDING, so repeated binds are skipped
+static unsigned boundMaterialBuffer = 0;
+static unsigned boundMaterialOffset = 0;
+
 /******************************************************************************/
 /*!
 \brief
-Default constructor - generate VBO/IBO here
+Default constructor - the mesh is empty until MeshBuilder places its
+geometry in the GeometryArena
 
 \param meshName - name of mesh
 */
@@ -12,28 +41,81 @@ Default constructor - generate VBO/IBO here
 Mesh::Mesh(const std::string& meshName)
 	: name(meshName)
 	, mode(DRAW_TRIANGLES)
+	, vertexFormat(VertexFormat::FORMAT_FLOAT)
+	, vertexArray(0)
+	, vertexBuffer(0)
+	, indexBuffer(0)
+	, indexSize(0)
+	, indexType(GL_UNSIGNED_INT)
+	, textureID(0)
+	, sharedMesh(nullptr)
+	, materialBuffer(0)
+{
+	geometry.page = nullptr;
+	geometry.baseVertex = 0;
+	geometry.firstIndex = 0;
+	geometry.vertexBytes = 0;
+	geometry.indexBytes = 0;
+}
+
+/******************************************************************************/
+/*!
+\brief
+View constructor - draw the buffers and materials of a mesh owned by the
+AssetRegistry without copying or owning them. The view keeps its own
+textureID and color, so scenes can texture and tint the same model
+differently.
+
+\param meshName - name of mesh
+\param shared - registry mesh to draw
+*/
+/******************************************************************************/
+Mesh::Mesh(const std::string& meshName, const Mesh& shared)
+	: material(shared.material)
+	, name(meshName)
+	, mode(shared.mode)
+	, vertexFormat(shared.vertexFormat)
+	, vertexArray(shared.vertexArray)
+	, vertexBuffer(shared.vertexBuffer)
+	, indexBuffer(shared.indexBuffer)
+	, geometry(shared.geometry)
+	, indexSize(shared.indexSize)
+	, indexType(shared.indexType)
 	, textureID(0)
+	, color(shared.color)
+	, sharedMesh(&shared)
+	, lods(shared.lods)
+	, bounds(shared.bounds)
+	, materialBounds(shared.materialBounds)
+	, materialBuffer(shared.materialBuffer)
+	, materials(shared.materials)
 {
-	//Generate Buffers
-	glGenBuffers(1, &vertexBuffer);
-	glGenBuffers(1, &indexBuffer); //generate index buffer
+	AssetRegistry::AcquireMesh(sharedMesh);
 }
 
 /******************************************************************************/
 /*!
 \brief
-Destructor - delete VBO/IBO here
+Destructor - free the mesh's arena space, or release the shared mesh for a view.
+Textures come from the AssetRegistry and are released, not deleted.
 */
 /******************************************************************************/
 Mesh::~Mesh()
 {
-	if (textureID > 0)
+	AssetRegistry::ReleaseTexture(textureID);
+	if (sharedMesh != nullptr)
 	{
-		glDeleteTextures(1, &textureID);
+		AssetRegistry::ReleaseMesh(sharedMesh);
+		return;
+	}
+	GeometryArena::Free(geometry);
+	if (materialBuffer != 0)
+	{
+		//a new buffer may get the same name
+		if (boundMaterialBuffer == materialBuffer)
+			boundMaterialBuffer = 0;
+		glDeleteBuffers(1, &materialBuffer);
 	}
-	// Cleanup VBO here
-	glDeleteBuffers(1, &vertexBuffer);
-	glDeleteBuffers(1, &indexBuffer);
 }
 
 /******************************************************************************/
@@ -45,40 +127,33 @@ OpenGL render code
 
 void Mesh::Render()
 {
+	glBindVertexArray(vertexArray);
+	size_t indexBytes = GetIndexBytes();
+	//formats without a color read the constant attribute instead
+	if (!VertexFormat::Get(vertexFormat).Has(VertexFormat::ATTRIBUTE_COLOR))
+		glVertexAttrib3f(VertexFormat::ATTRIBUTE_COLOR, color.r, color.g, color.b);
 
-	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glEnableVertexAttribArray(2); // 3rd attribute : normals
-
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)sizeof(Position));
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(Position) + sizeof(Color)));
-
-	if (textureID > 0)
-	{
-		glEnableVertexAttribArray(3);
-		glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(Position) + sizeof(Color) + sizeof(Vector3)));
-	}
-	
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
-	//glDrawArrays(GL_TRIANGLES, 0, 6); //comment this line
 	if (materials.size() == 0)
 	{
+		BindDefaultMaterials();
 		if (mode == Mesh::DRAW_LINES)
 		{
-			glDrawElements(GL_LINES, indexSize, GL_UNSIGNED_INT, 0);
+			glDrawElementsBaseVertex(GL_LINES, indexSize, indexType, (void*)(geometry.firstIndex * indexBytes), geometry.baseVertex);
 		}
 		else if (mode == Mesh::DRAW_TRIANGLE_STRIP)
 		{
-			glDrawElements(GL_TRIANGLE_STRIP, indexSize, GL_UNSIGNED_INT, 0);
+			glDrawElementsBaseVertex(GL_TRIANGLE_STRIP, indexSize, indexType, (void*)(geometry.firstIndex * indexBytes), geometry.baseVertex);
 		}
 		else
 		{
-			glDrawElements(GL_TRIANGLES, indexSize, GL_UNSIGNED_INT, 0);
+			glDrawElementsBaseVertex(GL_TRIANGLES, indexSize, indexType, (void*)(geometry.firstIndex * indexBytes), geometry.baseVertex);
 		}
 	}
+	else if (BindMaterials(0))
+	{
+		//the shader picks each triangle's material from the bound block
+		glDrawElementsBaseVertex(GL_TRIANGLES, indexSize, indexType, (void*)(geometry.firstIndex * indexBytes), geometry.baseVertex);
+	}
 	else
 	{
 		for (unsigned i = 0, offset = 0; i < materials.size(); ++i)
@@ -89,59 +164,139 @@ void Mesh::Render()
 			glUniform3fv(locationKs, 1, &material.kSpecular.r);
 			glUniform1f(locationNs, material.kShininess);
 			if (mode == DRAW_TRIANGLE_STRIP)
-				glDrawElements(GL_TRIANGLE_STRIP, material.size, GL_UNSIGNED_INT, (void*)(offset * sizeof(unsigned)));
+				glDrawElementsBaseVertex(GL_TRIANGLE_STRIP, material.size, indexType, (void*)((geometry.firstIndex + offset) * indexBytes), geometry.baseVertex);
 			else if (mode == DRAW_LINES)
-				glDrawElements(GL_LINES, material.size, GL_UNSIGNED_INT, (void*)(offset * sizeof(unsigned)));
+				glDrawElementsBaseVertex(GL_LINES, material.size, indexType, (void*)((geometry.firstIndex + offset) * indexBytes), geometry.baseVertex);
 			else
-				glDrawElements(GL_TRIANGLES, material.size, GL_UNSIGNED_INT, (void*)(offset * sizeof(unsigned)));
+				glDrawElementsBaseVertex(GL_TRIANGLES, material.size, indexType, (void*)((geometry.firstIndex + offset) * indexBytes), geometry.baseVertex);
 			offset += material.size;
 		}
 	}
+}
+
+void Mesh::Render(unsigned offset, unsigned count)
+{
+	//material ranges cover the whole mesh, so it is drawn in full
+	if (materials.size() != 0)
+	{
+		Render();
+		return;
+	}
 
-	glDisableVertexAttribArray(0);
-	glDisableVertexAttribArray(1);
-	glDisableVertexAttribArray(2);
+	glBindVertexArray(vertexArray);
+	size_t indexBytes = GetIndexBytes();
+	//formats without a color read the constant attribute instead
+	if (!VertexFormat::Get(vertexFormat).Has(VertexFormat::ATTRIBUTE_COLOR))
+		glVertexAttrib3f(VertexFormat::ATTRIBUTE_COLOR, color.r, color.g, color.b);
+	BindDefaultMaterials();
 
-	if (textureID > 0)
+	if (mode == Mesh::DRAW_LINES)
+	{
+		glDrawElementsBaseVertex(GL_LINES, count, indexType, (void*)((geometry.firstIndex + offset) * indexBytes), geometry.baseVertex);
+	}
+	else if (mode == DRAW_TRIANGLE_STRIP)
+	{
+		glDrawElementsBaseVertex(GL_TRIANGLE_STRIP, count, indexType, (void*)((geometry.firstIndex + offset) * indexBytes), geometry.baseVertex);
+	}
+	else
 	{
-		glDisableVertexAttribArray(3);
+		glDrawElementsBaseVertex(GL_TRIANGLES, count, indexType, (void*)((geometry.firstIndex + offset) * indexBytes), geometry.baseVertex);
 	}
 }
 
-void Mesh::Render(unsigned offset, unsigned count)
+/******************************************************************************/
+/*!
+\brief
+Draw one level of detail. Level 0 is the full mesh; levels past the last LOD
+draw the coarsest one.
+*/
+/******************************************************************************/
+void Mesh::RenderLod(unsigned level)
 {
-	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	if (level == 0 || lods.empty())
+	{
+		Render();
+		return;
+	}
+	if (level > lods.size())
+		level = (unsigned)lods.size();
+	const MeshLod& lod = lods[level - 1];
+	if (materials.size() == 0 || lod.materialSizes.size() != materials.size())
+	{
+		Render(lod.offset, lod.count);
+		return;
+	}
+
+	glBindVertexArray(vertexArray);
+	size_t indexBytes = GetIndexBytes();
+	//formats without a color read the constant attribute instead
+	if (!VertexFormat::Get(vertexFormat).Has(VertexFormat::ATTRIBUTE_COLOR))
+		glVertexAttrib3f(VertexFormat::ATTRIBUTE_COLOR, color.r, color.g, color.b);
+
+	if (BindMaterials(level))
+	{
+		glDrawElementsBaseVertex(GL_TRIANGLES, lod.count, indexType, (void*)((geometry.firstIndex + lod.offset) * indexBytes), geometry.baseVertex);
+		return;
+	}
+	for (unsigned i = 0, offset = lod.offset; i < materials.size(); ++i)
+	{
+		Material& material = materials[i];
+		glUniform3fv(locationKa, 1, &material.kAmbient.r);
+		glUniform3fv(locationKd, 1, &material.kDiffuse.r);
+		glUniform3fv(locationKs, 1, &material.kSpecular.r);
+		glUniform1f(locationNs, material.kShininess);
+		glDrawElementsBaseVertex(GL_TRIANGLES, lod.materialSizes[i], indexType, (void*)((geometry.firstIndex + offset) * indexBytes), geometry.baseVertex);
+		offset += lod.materialSizes[i];
+	}
+}
+
+/******************************************************************************/
+/*!
+\brief
+Draw the full mesh once per model matrix in a single instanced draw for each
+material. The matrices are applied before the MVP, MV and MV_inverse_transpose
+uniforms, which then hold the transform shared by all instances (usually just
+the camera). Instance matrices may rotate, translate and scale uniformly.
 
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glEnableVertexAttribArray(2); // 3rd attribute : normals
+\param models - count model matrices, column major like Mtx44
+*/
+/******************************************************************************/
+void Mesh::RenderInstanced(const Mtx44* models, unsigned count)
+{
+	if (count == 0)
+		return;
 
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)sizeof(Position));
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(Position) + sizeof(Color)));
+	//orphan the last frame's matrices instead of waiting for the GPU to finish with them
+	if (instanceBuffer == 0)
+		glGenBuffers(1, &instanceBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	if (count > instanceCapacity)
+		instanceCapacity = count;
+	glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(Mtx44), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(Mtx44), models);
 
-	if (textureID > 0)
+	glBindVertexArray(vertexArray);
+	for (unsigned column = 0; column < 4; ++column)
 	{
-		glEnableVertexAttribArray(3);
-		glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(Position) + sizeof(Color) + sizeof(Vector3)));
+		glEnableVertexAttribArray(INSTANCE_MODEL_LOCATION + column);
+		glVertexAttribPointer(INSTANCE_MODEL_LOCATION + column, 4, GL_FLOAT, GL_FALSE, sizeof(Mtx44), (void*)(column * 4 * sizeof(float)));
+		glVertexAttribDivisor(INSTANCE_MODEL_LOCATION + column, 1);
 	}
+	size_t indexBytes = GetIndexBytes();
+	//formats without a color read the constant attribute instead
+	if (!VertexFormat::Get(vertexFormat).Has(VertexFormat::ATTRIBUTE_COLOR))
+		glVertexAttrib3f(VertexFormat::ATTRIBUTE_COLOR, color.r, color.g, color.b);
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
-	//glDrawArrays(GL_TRIANGLES, 0, 6); //comment this line
+	GLenum primitive = mode == DRAW_TRIANGLE_STRIP ? GL_TRIANGLE_STRIP : (mode == DRAW_LINES ? GL_LINES : GL_TRIANGLES);
 	if (materials.size() == 0)
 	{
-		if (mode == Mesh::DRAW_LINES)
-		{
-			glDrawElements(GL_LINES, count, GL_UNSIGNED_INT, (void*)(offset * sizeof(GLuint)));
-		}
-		else if (mode == DRAW_TRIANGLE_STRIP)
-		{
-			glDrawElements(GL_TRIANGLE_STRIP, count, GL_UNSIGNED_INT, (void*)(offset * sizeof(GLuint)));
-		}
-		else
-		{
-			glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, (void*)(offset * sizeof(GLuint)));
-		}
+		BindDefaultMaterials();
+		glDrawElementsInstancedBaseVertex(primitive, indexSize, indexType, (void*)(geometry.firstIndex * indexBytes), count, geometry.baseVertex);
+	}
+	else if (BindMaterials(0))
+	{
+		//primitive IDs restart with each instance, so one draw still covers every material
+		glDrawElementsInstancedBaseVertex(primitive, indexSize, indexType, (void*)(geometry.firstIndex * indexBytes), count, geometry.baseVertex);
 	}
 	else
 	{
@@ -152,30 +307,111 @@ void Mesh::Render(unsigned offset, unsigned count)
 			glUniform3fv(locationKd, 1, &material.kDiffuse.r);
 			glUniform3fv(locationKs, 1, &material.kSpecular.r);
 			glUniform1f(locationNs, material.kShininess);
-			if (mode == DRAW_TRIANGLE_STRIP)
-				glDrawElements(GL_TRIANGLE_STRIP, material.size, GL_UNSIGNED_INT, (void*)(offset * sizeof(unsigned)));
-			else if (mode == DRAW_LINES)
-				glDrawElements(GL_LINES, material.size, GL_UNSIGNED_INT, (void*)(offset * sizeof(unsigned)));
-			else
-				glDrawElements(GL_TRIANGLES, material.size, GL_UNSIGNED_INT, (void*)(offset * sizeof(unsigned)));
+			glDrawElementsInstancedBaseVertex(primitive, material.size, indexType, (void*)((geometry.firstIndex + offset) * indexBytes), count, geometry.baseVertex);
 			offset += material.size;
 		}
 	}
 
-	glDisableVertexAttribArray(0);
-	glDisableVertexAttribArray(1);
-	glDisableVertexAttribArray(2);
+	//the page's VAO is shared with ordinary draws of every other mesh in it
+	for (unsigned column = 0; column < 4; ++column)
+	{
+		glDisableVertexAttribArray(INSTANCE_MODEL_LOCATION + column);
+	}
+	SetDefaultInstance();
+}
+
+/******************************************************************************/
+/*!
+\brief
+Pick a level of detail from how large the bounding sphere appears on screen
+
+\param modelView - view * model matrix the mesh is drawn with
+\param projection - perspective projection the mesh is drawn with
+
+\return level to pass to RenderLod, 0 when the camera is inside the bounds
+*/
+/******************************************************************************/
+unsigned Mesh::SelectLod(const Mtx44& modelView, const Mtx44& projection) const
+{
+	if (lods.empty())
+		return 0;
+
+	MeshBounds view = bounds.Transform(modelView);
+	float depth = -view.centre.z;
+	if (depth <= view.radius)
+		return 0;
+
+	float screenSize = view.radius * projection.a[5] / depth;
+	unsigned level = 0;
+	while (level < lods.size() && screenSize < LOD_SCREEN_SIZES[level])
+		++level;
+	return level;
+}
+
+MeshBounds::MeshBounds()
+	: radius(0.f)
+{
+}
+
+/******************************************************************************/
+/*!
+\brief
+Bounds of the vertices after a transform. The box is the box around the
+transformed box; the sphere grows by the matrix's largest axis scale.
+
+\param matrix - model or model view matrix, without projection
+*/
+/******************************************************************************/
+MeshBounds MeshBounds::Transform(const Mtx44& matrix) const
+{
+	Vector3 boxCentre = (minimum + maximum) * 0.5f;
+	Vector3 halfSize = (maximum - minimum) * 0.5f;
+	const float* box = &boxCentre.x;
+	const float* half = &halfSize.x;
+	const float* sphere = &centre.x;
 
-	if (textureID > 0)
+	float outBox[3], outHalf[3], outSphere[3];
+	for (unsigned row = 0; row < 3; ++row)
 	{
-		glDisableVertexAttribArray(3);
+		outBox[row] = outSphere[row] = matrix.a[12 + row];
+		outHalf[row] = 0.f;
+		for (unsigned column = 0; column < 3; ++column)
+		{
+			float element = matrix.a[column * 4 + row];
+			outBox[row] += element * box[column];
+			outHalf[row] += fabsf(element) * half[column];
+			outSphere[row] += element * sphere[column];
+		}
 	}
+	float scale = 0.f;
+	for (unsigned column = 0; column < 3; ++column)
+	{
+		const float* axis = &matrix.a[column * 4];
+		scale = Math::Max(scale, axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+	}
+
+	MeshBounds result;
+	result.minimum.Set(outBox[0] - outHalf[0], outBox[1] - outHalf[1], outBox[2] - outHalf[2]);
+	result.maximum.Set(outBox[0] + outHalf[0], outBox[1] + outHalf[1], outBox[2] + outHalf[2]);
+	result.centre.Set(outSphere[0], outSphere[1], outSphere[2]);
+	result.radius = radius * sqrtf(scale);
+	return result;
+}
+
+//Size of one index in the IBO, for byte offsets into it
+unsigned Mesh::GetIndexBytes() const
+{
+	return indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
 }
 
 unsigned Mesh::locationKa;
 unsigned Mesh::locationKd;
 unsigned Mesh::locationKs;
 unsigned Mesh::locationNs;
+unsigned Mesh::instanceBuffer = 0;
+unsigned Mesh::instanceCapacity = 0;
+unsigned Mesh::defaultMaterialBuffer = 0;
+unsigned Mesh::materialBlockStride = 0;
 
 void Mesh::SetMaterialLoc(unsigned ambient, unsigned diffuse, unsigned specular, unsigned shininess)
 {
@@ -184,3 +420,127 @@ void Mesh::SetMaterialLoc(unsigned ambient, unsigned diffuse, unsigned specular,
 	locationKs = specular;
 	locationNs = shininess;
 }
+
+/******************************************************************************/
+/*!
+\brief
+Make draws without an instance buffer read the identity as their instance
+matrix. Current attribute values belong to the context, so this is called
+once after it is created, and again after each instanced draw since drawing
+from an enabled array leaves them undefined.
+*/
+/******************************************************************************/
+void Mesh::SetDefaultInstance()
+{
+	for (unsigned column = 0; column < 4; ++column)
+	{
+		glVertexAttrib4f(INSTANCE_MODEL_LOCATION + column, column == 0 ? 1.f : 0.f, column == 1 ? 1.f : 0.f,
+			column == 2 ? 1.f : 0.f, column == 3 ? 1.f : 0.f);
+	}
+}
+
+void Mesh::ReleaseInstanceBuffer()
+{
+	glDeleteBuffers(1, &instanceBuffer);
+	instanceBuffer = 0;
+	instanceCapacity = 0;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Put the mesh's materials in a uniform buffer, one MeshMaterials block per LOD
+level, so each level draws in one call with the shader picking a material
+per triangle. Meshes with more materials than a block holds keep drawing
+material by material. Call once the materials and LODs are set.
+*/
+/******************************************************************************/
+void Mesh::UploadMaterials()
+{
+	if (materials.empty() || materials.size() > MAX_BLOCK_MATERIALS || mode != DRAW_TRIANGLES || materialBuffer != 0)
+		return;
+
+	if (materialBlockStride == 0)
+	{
+		GLint alignment = 1;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		alignment = alignment > 0 ? alignment : 1;
+		materialBlockStride = (sizeof(MaterialBlock) + alignment - 1) / alignment * alignment;
+	}
+
+	unsigned levels = 1 + (unsigned)lods.size();
+	std::vector<unsigned char> data(levels * materialBlockStride, 0);
+	for (unsigned level = 0; level < levels; ++level)
+	{
+		MaterialBlock* block = (MaterialBlock*)&data[level * materialBlockStride];
+		block->count = (int)materials.size();
+		//LODs without per-material sizes are drawn in full, see RenderLod
+		const std::vector<unsigned>* sizes = level > 0 ? &lods[level - 1].materialSizes : nullptr;
+		for (unsigned i = 0, end = 0; i < materials.size(); ++i)
+		{
+			const Material& material = materials[i];
+			end += (sizes != nullptr && sizes->size() == materials.size() ? (*sizes)[i] : material.size) / 3;
+			block->ends[i] = (int)end;
+			memcpy(block->materials[i].kAmbient, &material.kAmbient.r, sizeof(block->materials[i].kAmbient));
+			memcpy(block->materials[i].kDiffuse, &material.kDiffuse.r, sizeof(block->materials[i].kDiffuse));
+			memcpy(block->materials[i].kSpecular, &material.kSpecular.r, sizeof(block->materials[i].kSpecular));
+			block->materials[i].kShininess = material.kShininess;
+		}
+	}
+
+	glGenBuffers(1, &materialBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, materialBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, data.size(), &data[0], GL_STATIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+//Bind one LOD level's materials; false if the mesh draws material by material
+bool Mesh::BindMaterials(unsigned level) const
+{
+	if (materialBuffer == 0)
+	{
+		BindDefaultMaterials();
+		return false;
+	}
+	unsigned offset = level * materialBlockStride;
+	if (boundMaterialBuffer != materialBuffer || boundMaterialOffset != offset)
+	{
+		glBindBufferRange(GL_UNIFORM_BUFFER, MATERIAL_BLOCK_BINDING, materialBuffer, offset, sizeof(MaterialBlock));
+		boundMaterialBuffer = materialBuffer;
+		boundMaterialOffset = offset;
+	}
+	return true;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Bind a block without materials, so the shader uses the material uniform.
+Draws that do not go through a mesh's materials call this first.
+*/
+/******************************************************************************/
+void Mesh::BindDefaultMaterials()
+{
+	if (defaultMaterialBuffer == 0)
+	{
+		MaterialBlock block = {};
+		glGenBuffers(1, &defaultMaterialBuffer);
+		glBindBuffer(GL_UNIFORM_BUFFER, defaultMaterialBuffer);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(block), &block, GL_STATIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+	if (boundMaterialBuffer != defaultMaterialBuffer)
+	{
+		glBindBufferRange(GL_UNIFORM_BUFFER, MATERIAL_BLOCK_BINDING, defaultMaterialBuffer, 0, sizeof(MaterialBlock));
+		boundMaterialBuffer = defaultMaterialBuffer;
+		boundMaterialOffset = 0;
+	}
+}
+
+void Mesh::ReleaseDefaultMaterials()
+{
+	glDeleteBuffers(1, &defaultMaterialBuffer);
+	defaultMaterialBuffer = 0;
+	boundMaterialBuffer = 0;
+	boundMaterialOffset = 0;
+}
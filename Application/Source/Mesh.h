@@ -5,11 +5,45 @@
 #include <vector>
 #include "Vertex.h"
 #include "Material.h"
+#include "VertexFormat.h"
+#include "GeometryArena.h"
+#include "Mtx44.h"
+
+/******************************************************************************/
+/*!
+		Struct MeshLod:
+\brief	A coarser index range drawn over the same vertices as the full mesh
+*/
+/******************************************************************************/
+struct MeshLod
+{
+	unsigned offset;	//first index, counted from the mesh's first index
+	unsigned count;
+	std::vector<unsigned> materialSizes; //indices drawn with each material, empty without materials
+};
+
+/******************************************************************************/
+/*!
+		Struct MeshBounds:
+\brief	An axis-aligned box and a sphere around the same vertices
+*/
+/******************************************************************************/
+struct MeshBounds
+{
+	MeshBounds();
+
+	Vector3 minimum, maximum;
+	Vector3 centre;
+	float radius;
+
+	MeshBounds Transform(const Mtx44& matrix) const;
+};
 
 /******************************************************************************/
 /*!
 		Class Mesh:
-\brief	To store VBO (vertex & color buffer) and IBO (index buffer)
+\brief	To store where the mesh lives in the GeometryArena: the VAO, VBO and
+		IBO of its page, and its first vertex and index in them
 */
 /******************************************************************************/
 class Mesh
@@ -22,25 +56,57 @@ public:
 		DRAW_LINES,
 		DRAW_MODE_LAST,
 	};
+	enum
+	{
+		MAX_LODS = 3, //coarser levels below the full mesh
+		MAX_BLOCK_MATERIALS = 16, //materials the MeshMaterials uniform block holds
+		MATERIAL_BLOCK_BINDING = 0, //uniform buffer binding point of MeshMaterials
+	};
 	Mesh(const std::string& meshName);
+	Mesh(const std::string& meshName, const Mesh& shared);
 	~Mesh();
 	void Render();
 	void Render(unsigned offset, unsigned count);
+	void RenderLod(unsigned level);
+	void RenderInstanced(const Mtx44* models, unsigned count);
+	unsigned SelectLod(const Mtx44& modelView, const Mtx44& projection) const;
+	void UploadMaterials();
 	Material material;
 	const std::string name;
 	DRAW_MODE mode;
+	VertexFormat::TYPE vertexFormat;
+	unsigned vertexArray;
 	unsigned vertexBuffer;
 	unsigned colorBuffer;
 	unsigned indexBuffer;
+	GeometryArena::Allocation geometry;
 	unsigned indexSize;
+	unsigned indexType; //GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
 	unsigned textureID;
+	Color color; //used for every vertex when the format stores no color
+	const Mesh* sharedMesh; //mesh whose geometry this view draws, nullptr if the geometry is owned
+	std::vector<MeshLod> lods; //lods[0] is level 1; indexSize and materials describe level 0
+	MeshBounds bounds; //model space, around every vertex
+	std::vector<MeshBounds> materialBounds; //one per material range, empty without materials
+	unsigned materialBuffer; //materials for one-call draws, one block per LOD level; 0 to draw material by material
 	
+	unsigned GetIndexBytes() const;
+	bool BindMaterials(unsigned level) const;
+
 	static void SetMaterialLoc(unsigned kA, unsigned kD, unsigned kS, unsigned nS);
+	static void SetDefaultInstance();
+	static void ReleaseInstanceBuffer();
+	static void BindDefaultMaterials();
+	static void ReleaseDefaultMaterials();
 	std::vector<Material> materials;
 	static unsigned locationKa;
 	static unsigned locationKd;
 	static unsigned locationKs;
 	static unsigned locationNs;
+	static unsigned instanceBuffer;
+	static unsigned instanceCapacity; //matrices
+	static unsigned defaultMaterialBuffer; //a block without materials, so draws use the material uniform
+	static unsigned materialBlockStride; //bytes between LOD levels in a materialBuffer
 };
 
 #endif
\ No newline at end of file
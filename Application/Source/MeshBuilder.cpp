@@ -1,7 +1,171 @@
+#include <cstring>
+#include <sstream>
 #include "MeshBuilder.h"
+#include "CookedMesh.h"
+#include "AssetRegistry.h"
+#include "MeshOptimizer.h"
 #include <GL\glew.h>
 #define BIG_NUMBER 1000.f
 
+//Position of a vertex, which every format stores as 3 floats
+static Vector3 GetPosition(const VertexFormat& layout, const void* vertices, unsigned index)
+{
+	Position pos;
+	memcpy(&pos, (const unsigned char*)vertices + index * layout.stride + layout.attributes[VertexFormat::ATTRIBUTE_POSITION].offset, sizeof(pos));
+	return Vector3(pos.x, pos.y, pos.z);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Box around some vertices, and the sphere about the box's centre that holds
+them all, which is never larger than the sphere around the box
+
+\param vertices - vertices encoded in format
+\param indices - which vertices to include, nullptr for the first count
+\param count - number of indices, or of vertices without indices
+*/
+/******************************************************************************/
+static MeshBounds ComputeBounds(VertexFormat::TYPE format, const void* vertices, const unsigned* indices, size_t count)
+{
+	MeshBounds bounds;
+	if (count == 0)
+		return bounds;
+
+	const VertexFormat& layout = VertexFormat::Get(format);
+	Vector3 minimum = GetPosition(layout, vertices, indices ? indices[0] : 0);
+	Vector3 maximum = minimum;
+	for (size_t i = 1; i < count; ++i)
+	{
+		Vector3 pos = GetPosition(layout, vertices, indices ? indices[i] : (unsigned)i);
+		minimum.Set(Math::Min(minimum.x, pos.x), Math::Min(minimum.y, pos.y), Math::Min(minimum.z, pos.z));
+		maximum.Set(Math::Max(maximum.x, pos.x), Math::Max(maximum.y, pos.y), Math::Max(maximum.z, pos.z));
+	}
+	bounds.minimum = minimum;
+	bounds.maximum = maximum;
+	bounds.centre = (minimum + maximum) * 0.5f;
+
+	float radiusSquared = 0.f;
+	for (size_t i = 0; i < count; ++i)
+	{
+		Vector3 pos = GetPosition(layout, vertices, indices ? indices[i] : (unsigned)i);
+		radiusSquared = Math::Max(radiusSquared, (pos - bounds.centre).LengthSquared());
+	}
+	bounds.radius = sqrtf(radiusSquared);
+	return bounds;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Create a mesh and place its vertices and indices in the GeometryArena. The
+vertex layout lives in the arena page's VAO; Mesh::Render just binds it.
+
+\param vertices - vertexCount vertices already encoded in format
+
+\return Mesh with its geometry, indexSize and indexType set. A mesh without
+	indices (e.g. an empty OBJ) gets no geometry, and the Renderer skips it.
+*/
+/******************************************************************************/
+static Mesh* CreateMesh(const std::string& meshName, VertexFormat::TYPE format, const void* vertices, size_t vertexCount,
+	const unsigned* indices, size_t indexCount)
+{
+	Mesh* mesh = new Mesh(meshName);
+	mesh->vertexFormat = format;
+	mesh->indexSize = (unsigned)indexCount;
+	if (indexCount == 0)
+		return mesh;
+
+	//indices are relative to the mesh's base vertex, so meshes with up to
+	//65536 vertices (all but the largest levels) get 16 bit indices
+	if (vertexCount <= 0x10000)
+	{
+		std::vector<GLushort> shortIndices(indices, indices + indexCount);
+		mesh->indexType = GL_UNSIGNED_SHORT;
+		mesh->geometry = GeometryArena::Allocate(format, mesh->indexType, vertices, (unsigned)vertexCount, shortIndices.data(), (unsigned)indexCount);
+	}
+	else
+	{
+		mesh->indexType = GL_UNSIGNED_INT;
+		mesh->geometry = GeometryArena::Allocate(format, mesh->indexType, vertices, (unsigned)vertexCount, indices, (unsigned)indexCount);
+	}
+
+	mesh->vertexArray = mesh->geometry.page->vertexArray;
+	mesh->vertexBuffer = mesh->geometry.page->vertexBuffer;
+	mesh->indexBuffer = mesh->geometry.page->indexBuffer;
+
+	mesh->bounds = ComputeBounds(format, vertices, nullptr, vertexCount);
+	return mesh;
+}
+
+//Bounds of each material's index range, in the order the ranges are drawn
+static void SetMaterialBounds(Mesh* mesh, const void* vertices, const unsigned* indices)
+{
+	mesh->materialBounds.clear();
+	for (size_t i = 0, offset = 0; i < mesh->materials.size(); ++i)
+	{
+		mesh->materialBounds.push_back(ComputeBounds(mesh->vertexFormat, vertices, indices + offset, mesh->materials[i].size));
+		offset += mesh->materials[i].size;
+	}
+}
+
+//Point a mesh at the LODs appended after its full index range
+static void SetLods(Mesh* mesh, const std::vector<MeshLod>& lods)
+{
+	mesh->lods = lods;
+	if (!lods.empty())
+		mesh->indexSize = lods[0].offset;
+}
+
+static Mesh* CreateMesh(const std::string& meshName, const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices,
+	VertexFormat::TYPE format = VertexFormat::FORMAT_FLOAT)
+{
+	if (format == VertexFormat::FORMAT_FLOAT)
+		return CreateMesh(meshName, format, vertices.data(), vertices.size(), indices.data(), indices.size());
+
+	std::vector<unsigned char> encoded(vertices.size() * VertexFormat::Get(format).stride);
+	VertexFormat::Get(format).Encode(vertices.data(), vertices.size(), encoded.data());
+	return CreateMesh(meshName, format, encoded.data(), vertices.size(), indices.data(), indices.size());
+}
+
+/******************************************************************************/
+/*!
+\brief
+Registry key of a generated primitive. Only parameters that change the
+geometry go in the key; color is set per view, so every scene asking for the
+same shape draws the same arena copy.
+*/
+/******************************************************************************/
+static std::string MakePrimitiveKey(const char* shape, const float* parameters, unsigned count)
+{
+	std::ostringstream key;
+	key.precision(9);
+	key << "primitive:" << shape;
+	for (unsigned i = 0; i < count; ++i)
+	{
+		key << ':' << parameters[i];
+	}
+	return key.str();
+}
+
+//Upload white geometry for a primitive and hand it to the registry
+static Mesh* AddPrimitive(const std::string& key, const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices,
+	Mesh::DRAW_MODE mode)
+{
+	Mesh* mesh = CreateMesh(key, vertices, indices, VertexFormat::FORMAT_PACKED);
+	mesh->mode = mode;
+	AssetRegistry::AddMesh(key, mesh);
+	return mesh;
+}
+
+//A view of a registry primitive, tinted through the constant color attribute
+static Mesh* CreatePrimitiveView(const std::string& meshName, const Mesh& shared, Color color)
+{
+	Mesh* mesh = new Mesh(meshName, shared);
+	mesh->color = color;
+	return mesh;
+}
+
 /******************************************************************************/
 /*!
 \brief
@@ -42,13 +206,8 @@ Mesh* MeshBuilder::GenerateAxes(const std::string &meshName)
 		index_buffer_data.push_back(i);
 	}
 
-	Mesh* mesh = new Mesh(meshName);
-	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.size() * sizeof(Vertex), &vertex_buffer_data[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
+	Mesh* mesh = CreateMesh(meshName, vertex_buffer_data, index_buffer_data);
 	mesh->mode = Mesh::DRAW_LINES;
-	mesh->indexSize = index_buffer_data.size();
 
 	return mesh;
 }
@@ -60,41 +219,70 @@ Generate the vertices of a quad; Use random color for each vertex
 Then generate the VBO/IBO and store them in Mesh object
 
 \param meshName - name of mesh
-\param lengthX - width of quad
-\param lengthY - height of quad
+\param color - color of the quad
+\param size - unused, every quad is a unit quad
 
-\return Pointer to mesh storing VBO/IBO of quad
+\return Pointer to a view of the shared unit quad
 */
 /******************************************************************************/
 Mesh* MeshBuilder::GenerateQuad(const std::string& meshName, Color color, float size)
 {
+	AtlasRegion wholeTexture = { 0, 0.f, 0.f, 1.f, 1.f };
+	return GenerateQuad(meshName, color, size, wholeTexture);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Generate a quad textured with one region of an atlas. The mesh takes over
+the region's texture reference.
+
+\param meshName - name of mesh
+\param color - color of the quad
+\param size - unused, kept to match GenerateQuad
+\param region - texture and UV rectangle, e.g. from TextureAtlas::AcquireRegion
+
+\return Pointer to a view of the shared quad with the region's UVs
+*/
+/******************************************************************************/
+Mesh* MeshBuilder::GenerateQuad(const std::string& meshName, Color color, float size, const AtlasRegion& region)
+{
+	float parameters[] = { region.u0, region.v0, region.u1, region.v1 };
+	std::string key = MakePrimitiveKey("quad", parameters, 4);
+	Mesh* shared = AssetRegistry::FindMesh(key);
+	if (shared != nullptr)
+	{
+		Mesh* mesh = CreatePrimitiveView(meshName, *shared, color);
+		mesh->textureID = region.textureID;
+		return mesh;
+	}
+
 	Vertex v;
-	v.color = color;
 	std::vector<Vertex> vertex_buffer_data;
 	std::vector<unsigned> index_buffer_data;
 
 	//top right
 	v.normal.Set(0.f, 0.f, 1.f);
 	v.pos.Set(0.5f, 0.5f, 0.f);
-	v.texCoord.Set(1, 1);
+	v.texCoord.Set(region.u1, region.v1);
 	vertex_buffer_data.push_back(v);
 
 	//top left
 	v.normal.Set(0.f, 0.f, 1.f);
 	v.pos.Set(-0.5f, 0.5f, 0.f); 
-	v.texCoord.Set(0, 1);
+	v.texCoord.Set(region.u0, region.v1);
 	vertex_buffer_data.push_back(v);
 
 	//bottom left
 	v.normal.Set(0.f, 0.f, 1.f);
 	v.pos.Set(-0.5f, -0.5f, 0.f);
-	v.texCoord.Set(0, 0);
+	v.texCoord.Set(region.u0, region.v0);
 	vertex_buffer_data.push_back(v);
 
 	//bottom right
 	v.normal.Set(0.f, 0.f, 1.f);
 	v.pos.Set(0.5f, -0.5f, 0.f); 
-	v.texCoord.Set(1, 0);
+	v.texCoord.Set(region.u1, region.v0);
 	vertex_buffer_data.push_back(v);
 
 	//back face
@@ -105,13 +293,8 @@ Mesh* MeshBuilder::GenerateQuad(const std::string& meshName, Color color, float
 	index_buffer_data.push_back(2);
 	index_buffer_data.push_back(3);
 
-	Mesh *mesh = new Mesh(meshName);
-	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.size() * sizeof(Vertex), &vertex_buffer_data[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
-	mesh->mode = Mesh::DRAW_TRIANGLES;
-	mesh->indexSize = index_buffer_data.size();
+	Mesh* mesh = CreatePrimitiveView(meshName, *AddPrimitive(key, vertex_buffer_data, index_buffer_data, Mesh::DRAW_TRIANGLES), color);
+	mesh->textureID = region.textureID;
 	return mesh;
 }
 
@@ -131,8 +314,12 @@ Then generate the VBO/IBO and store them in Mesh object
 /******************************************************************************/
 Mesh* MeshBuilder::GenerateCube(const std::string& meshName, Color color, float size)
 {
+	std::string key = MakePrimitiveKey("cube", nullptr, 0);
+	Mesh* shared = AssetRegistry::FindMesh(key);
+	if (shared != nullptr)
+		return CreatePrimitiveView(meshName, *shared, color);
+
 	Vertex v;
-	v.color = color;
 	std::vector<Vertex> vertex_buffer_data;
 	std::vector<unsigned> index_buffer_data;
 
@@ -169,15 +356,15 @@ Mesh* MeshBuilder::GenerateCube(const std::string& meshName, Color color, float
 	v.texCoord.Set(1, 1);
 	vertex_buffer_data.push_back(v);
 	//front top left
-	v.pos.Set(-0.5f, 0.5f, 0.5f); v.color.Set(1, 0, 0);
+	v.pos.Set(-0.5f, 0.5f, 0.5f);
 	v.texCoord.Set(0, 1);
 	vertex_buffer_data.push_back(v);
 	//front bottom left
-	v.pos.Set(-0.5f, -0.5f, 0.5f); v.color.Set(1, 0, 0);
+	v.pos.Set(-0.5f, -0.5f, 0.5f);
 	v.texCoord.Set(0, 0);
 	vertex_buffer_data.push_back(v);
 	//front bottom right
-	v.pos.Set(0.5f, -0.5f, 0.5f); v.color.Set(1, 0, 0);
+	v.pos.Set(0.5f, -0.5f, 0.5f);
 	v.texCoord.Set(1, 0);
 	vertex_buffer_data.push_back(v);
 
@@ -194,7 +381,7 @@ Mesh* MeshBuilder::GenerateCube(const std::string& meshName, Color color, float
 	v.texCoord.Set(1, 0);
 	vertex_buffer_data.push_back(v);
 	//front top left
-	v.pos.Set(-0.5f, 0.5f, 0.5f); v.color.Set(1, 0, 0);
+	v.pos.Set(-0.5f, 0.5f, 0.5f);
 	v.texCoord.Set(0, 0);
 	vertex_buffer_data.push_back(v);
 
@@ -207,11 +394,11 @@ Mesh* MeshBuilder::GenerateCube(const std::string& meshName, Color color, float
 	v.texCoord.Set(1, 0);
 	vertex_buffer_data.push_back(v);
 	//front bottom left
-	v.pos.Set(-0.5f, -0.5f, 0.5f); v.color.Set(1, 0, 0);
+	v.pos.Set(-0.5f, -0.5f, 0.5f);
 	v.texCoord.Set(0, 1);
 	vertex_buffer_data.push_back(v);
 	//front bottom right
-	v.pos.Set(0.5f, -0.5f, 0.5f); v.color.Set(1, 0, 0);
+	v.pos.Set(0.5f, -0.5f, 0.5f);
 	v.texCoord.Set(1, 1);
 	vertex_buffer_data.push_back(v);
 
@@ -264,33 +451,28 @@ Mesh* MeshBuilder::GenerateCube(const std::string& meshName, Color color, float
 	index_buffer_data.push_back(11);
 	index_buffer_data.push_back(10);
 
-
-
-	Mesh* mesh = new Mesh(meshName);
-	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.size() * sizeof(Vertex), &vertex_buffer_data[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
-	mesh->mode = Mesh::DRAW_TRIANGLES;
-	mesh->indexSize = index_buffer_data.size();
-	return mesh;
+	return CreatePrimitiveView(meshName, *AddPrimitive(key, vertex_buffer_data, index_buffer_data, Mesh::DRAW_TRIANGLES), color);
 }
 
 Mesh* MeshBuilder::GenerateCircle(const std::string& meshName, Color color, float radius, int sides, float size)
 {
+	float parameters[] = { radius, (float)sides };
+	std::string key = MakePrimitiveKey("circle", parameters, 2);
+	Mesh* shared = AssetRegistry::FindMesh(key);
+	if (shared != nullptr)
+		return CreatePrimitiveView(meshName, *shared, color);
+
 	float degreePerSlice = Math::DegreeToRadian(360.f / sides);
 	Vertex v;
 	std::vector<Vertex> vertex_buffer_data;
 	std::vector<unsigned> index_buffer_data;
 
 	v.pos.Set(0.f, 0.f, 0.f);
-	v.color = color;
 	vertex_buffer_data.push_back(v);
 
 	for (int i = 0; i <= sides; ++i)
 	{
 		v.pos.Set(radius * cosf(i * degreePerSlice), 0.f, radius* sinf(i * degreePerSlice));
-		v.color = color;
 		vertex_buffer_data.push_back(v);
 	}
 
@@ -300,22 +482,20 @@ Mesh* MeshBuilder::GenerateCircle(const std::string& meshName, Color color, floa
 		index_buffer_data.push_back(0);
 	}
 
-	Mesh* mesh = new Mesh(meshName);
-	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.size() * sizeof(Vertex), &vertex_buffer_data[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
-	mesh->mode = Mesh::DRAW_TRIANGLE_STRIP;
-	mesh->indexSize = index_buffer_data.size();
-
-	return mesh;
+	return CreatePrimitiveView(meshName, *AddPrimitive(key, vertex_buffer_data, index_buffer_data, Mesh::DRAW_TRIANGLE_STRIP), color);
 }
 
 Mesh* MeshBuilder::GenerateSphere(const std::string& meshName, Color color, unsigned numStacks, unsigned numSlices, float radius)
 {
+	float parameters[] = { (float)numStacks, (float)numSlices, radius };
+	std::string key = MakePrimitiveKey("sphere", parameters, 3);
+	Mesh* shared = AssetRegistry::FindMesh(key);
+	if (shared != nullptr)
+		return CreatePrimitiveView(meshName, *shared, color);
+
 	Vertex v;
 	std::vector<Vertex> vertex_buffer_data;
-	std::vector<GLuint> index_buffer_data;
+	std::vector<unsigned> index_buffer_data;
 
 	float degreePerStack = 180.f / numStacks;
 	float degreePerSlice = 360.f / numSlices;
@@ -330,8 +510,7 @@ Mesh* MeshBuilder::GenerateSphere(const std::string& meshName, Color color, unsi
 			float y = radius * sin(Math::DegreeToRadian(phi));
 			float z = radius * cos(Math::DegreeToRadian(phi)) * sin(Math::DegreeToRadian(theta));
 			v.pos.Set(x, y, z);
-			v.normal.Set(x,y,z);
-			v.color = color;
+			v.normal.Set(x / radius, y / radius, z / radius);
 			if (theta < numStacks / 2)
 			{
 				if (theta < 180)
@@ -358,7 +537,7 @@ Mesh* MeshBuilder::GenerateSphere(const std::string& meshName, Color color, unsi
 			vertex_buffer_data.push_back(v);
 		}
 	}
-	for (unsigned stack = 0; stack <= numStacks; ++stack)
+	for (unsigned stack = 0; stack < numStacks; ++stack)
 	{
 		for (unsigned slice = 0; slice <= numSlices; ++slice)
 		{
@@ -367,19 +546,17 @@ Mesh* MeshBuilder::GenerateSphere(const std::string& meshName, Color color, unsi
 		}
 	}
 
-	Mesh* mesh = new Mesh(meshName);
-	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.size() * sizeof(Vertex), &vertex_buffer_data[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
-	mesh->indexSize = index_buffer_data.size();
-	mesh->mode = Mesh::DRAW_TRIANGLE_STRIP;
-
-	return mesh;
+	return CreatePrimitiveView(meshName, *AddPrimitive(key, vertex_buffer_data, index_buffer_data, Mesh::DRAW_TRIANGLE_STRIP), color);
 }
 
 Mesh* MeshBuilder::GenerateCylinder(const std::string& meshName, Color color, float radius, int sides, float size)
 {
+	float parameters[] = { radius, (float)sides };
+	std::string key = MakePrimitiveKey("cylinder", parameters, 2);
+	Mesh* shared = AssetRegistry::FindMesh(key);
+	if (shared != nullptr)
+		return CreatePrimitiveView(meshName, *shared, color);
+
 	float degreePerSlice = Math::DegreeToRadian(360.f / sides);
 	int height = 1;
 	int stacks = 1;
@@ -393,12 +570,10 @@ Mesh* MeshBuilder::GenerateCylinder(const std::string& meshName, Color color, fl
 	{
 		v.pos.Set(radius * cosf(i * degreePerSlice), -height * 0.5f + stacks * stackHeight, radius * sinf(i * degreePerSlice));
 		v.normal.Set(cosf(i * degreePerSlice), 0.f, sinf(i * degreePerSlice));
-		v.color = color;
 		vertex_buffer_data.push_back(v);
 
 		v.pos.Set(radius * cosf(i * degreePerSlice), -height * 0.5f + (stacks + 1) * stackHeight, radius * sinf(i * degreePerSlice));
 		v.normal.Set(cosf(i * degreePerSlice), 0.f, sinf(i * degreePerSlice));
-		v.color = color;
 		vertex_buffer_data.push_back(v);
 	}
 
@@ -407,38 +582,33 @@ Mesh* MeshBuilder::GenerateCylinder(const std::string& meshName, Color color, fl
 		index_buffer_data.push_back(i);
 	}
 
-	Mesh* mesh = new Mesh(meshName);
-	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.size() * sizeof(Vertex), &vertex_buffer_data[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
-	mesh->mode = Mesh::DRAW_TRIANGLE_STRIP;
-	mesh->indexSize = index_buffer_data.size();
-
-	return mesh;
+	return CreatePrimitiveView(meshName, *AddPrimitive(key, vertex_buffer_data, index_buffer_data, Mesh::DRAW_TRIANGLE_STRIP), color);
 }
 
 Mesh* MeshBuilder::GenerateCone(const std::string& meshName, Color color, float radius, int sides, int height, float size)
 {
+	float parameters[] = { radius, (float)sides, (float)height };
+	std::string key = MakePrimitiveKey("cone", parameters, 3);
+	Mesh* shared = AssetRegistry::FindMesh(key);
+	if (shared != nullptr)
+		return CreatePrimitiveView(meshName, *shared, color);
+
 	float degreePerSlice = Math::DegreeToRadian(360.f / sides);
 	Vertex v;
 	std::vector<Vertex> vertex_buffer_data;
 	std::vector<unsigned> index_buffer_data;
 
 	v.pos.Set(0, height * 0.5f, 0);
-	v.color = color;
 	vertex_buffer_data.push_back(v);
 
 	v.pos.Set(0, -height * 0.5f, 0);
 	v.normal.Set(0, -1, 0);
-	v.color = color;
 	vertex_buffer_data.push_back(v);
 
 	for (int i = 0; i <= sides; ++i)
 	{
 		v.pos.Set(radius * cosf(i * degreePerSlice), -height * 0.5, radius * sinf(i * degreePerSlice));
 		v.normal.Set(0, -1, 0);
-		v.color = color;
 		vertex_buffer_data.push_back(v);
 	}
 
@@ -453,7 +623,6 @@ Mesh* MeshBuilder::GenerateCone(const std::string& meshName, Color color, float
 		v.pos.Set(radius * cosf(i * degreePerSlice), -height* 0.5, radius * sinf(i * degreePerSlice));
 		v.normal.Set(height * cosf(i * degreePerSlice), radius, height * sinf(i * degreePerSlice));
 		v.normal.Normalize();
-		v.color = color;
 		vertex_buffer_data.push_back(v);
 	}
 
@@ -465,22 +634,20 @@ Mesh* MeshBuilder::GenerateCone(const std::string& meshName, Color color, float
 
 	
 
-	Mesh* mesh = new Mesh(meshName);
-	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.size() * sizeof(Vertex), &vertex_buffer_data[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
-	mesh->mode = Mesh::DRAW_TRIANGLE_STRIP;
-	mesh->indexSize = index_buffer_data.size();
-
-	return mesh;
+	return CreatePrimitiveView(meshName, *AddPrimitive(key, vertex_buffer_data, index_buffer_data, Mesh::DRAW_TRIANGLE_STRIP), color);
 }
 
 Mesh* MeshBuilder::GenerateTorus(const std::string& meshName, Color color, unsigned numStacks, unsigned numSlices, float outerRadius, float innerRadius)
 {
+	float parameters[] = { (float)numStacks, (float)numSlices, outerRadius, innerRadius };
+	std::string key = MakePrimitiveKey("torus", parameters, 4);
+	Mesh* shared = AssetRegistry::FindMesh(key);
+	if (shared != nullptr)
+		return CreatePrimitiveView(meshName, *shared, color);
+
 	Vertex v;
 	std::vector<Vertex> vertex_buffer_data;
-	std::vector<GLuint> index_buffer_data;
+	std::vector<unsigned> index_buffer_data;
 
 	float degreePerStack = 360.f / numStacks;
 	float degreePerSlice = 360.f / numSlices;
@@ -499,13 +666,12 @@ Mesh* MeshBuilder::GenerateTorus(const std::string& meshName, Color color, unsig
 			x2 = (outerRadius + innerRadius * cosf(Math::DegreeToRadian(slice * degreePerSlice))) * sinf(Math::DegreeToRadian(stack * degreePerStack));
 
 			v.pos.Set(x2, y2, z2);
-			v.color = color;
 			v.normal.Set(x2 - x1, y2, z2 - z1);
 			v.normal.Normalize();
 			vertex_buffer_data.push_back(v);
 		}
 	}
-	for (unsigned stack = 0; stack <= numStacks; ++stack)
+	for (unsigned stack = 0; stack < numStacks; ++stack)
 	{
 		for (unsigned slice = 0; slice <= numSlices; ++slice)
 		{
@@ -514,18 +680,104 @@ Mesh* MeshBuilder::GenerateTorus(const std::string& meshName, Color color, unsig
 		}
 	}
 
-	Mesh* mesh = new Mesh(meshName);
-	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.size() * sizeof(Vertex), &vertex_buffer_data[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
-	mesh->indexSize = index_buffer_data.size();
-	mesh->mode = Mesh::DRAW_TRIANGLE_STRIP;
+	return CreatePrimitiveView(meshName, *AddPrimitive(key, vertex_buffer_data, index_buffer_data, Mesh::DRAW_TRIANGLE_STRIP), color);
+}
 
-	return mesh;
+//Meshes below this are cheap enough to always draw in full
+static const unsigned LOD_MIN_TRIANGLES = 1000;
+//Triangles kept at each LOD, as a fraction of the full mesh
+static const float LOD_TRIANGLE_RATIOS[Mesh::MAX_LODS] = { 0.5f, 0.25f, 0.12f };
+
+//Index count of each material's range, or of the whole mesh without materials
+static std::vector<unsigned> GetIndexRanges(const std::vector<Material>& materials, unsigned indexCount)
+{
+	std::vector<unsigned> ranges;
+	for (size_t i = 0; i < materials.size(); ++i)
+	{
+		ranges.push_back(materials[i].size);
+	}
+	if (ranges.empty())
+		ranges.push_back(indexCount);
+	return ranges;
 }
 
-Mesh* MeshBuilder::GenerateOBJ(const std::string& meshName, const std::string& file_path)
+/******************************************************************************/
+/*!
+\brief
+Simplify a cache optimised mesh into up to MAX_LODS coarser levels, each built
+from the one before and appended to indices. A level is dropped, along with
+the ones after it, if simplification cannot get it well below the last or
+turns any triangle inside out.
+
+\param lods - receives where each level lives in indices
+*/
+/******************************************************************************/
+static void BuildLods(const std::vector<Vertex>& vertices, std::vector<unsigned>& indices, const std::vector<Material>& materials,
+	std::vector<MeshLod>& lods)
+{
+	lods.clear();
+	unsigned fullCount = (unsigned)indices.size();
+	if (fullCount / 3 < LOD_MIN_TRIANGLES)
+		return;
+
+	std::vector<unsigned> source(indices);
+	std::vector<unsigned> sourceRanges = GetIndexRanges(materials, fullCount);
+	for (unsigned level = 0; level < Mesh::MAX_LODS; ++level)
+	{
+		std::vector<unsigned> lodIndices, lodRanges;
+		SimplifyMesh(vertices, source, sourceRanges, (unsigned)(fullCount * LOD_TRIANGLE_RATIOS[level]), lodIndices, lodRanges);
+		if (lodIndices.empty() || lodIndices.size() > source.size() * 3 / 4 ||
+			CountFlippedTriangles(vertices, &lodIndices[0], (unsigned)lodIndices.size()) > 0)
+			break;
+
+		for (unsigned i = 0, first = 0; i < lodRanges.size(); first += lodRanges[i++])
+		{
+			OptimizeVertexCache(lodIndices, first, lodRanges[i], (unsigned)vertices.size());
+		}
+		MeshLod lod;
+		lod.offset = (unsigned)indices.size();
+		lod.count = (unsigned)lodIndices.size();
+		if (!materials.empty())
+			lod.materialSizes = lodRanges;
+		lods.push_back(lod);
+		indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+
+		source.swap(lodIndices);
+		sourceRanges.swap(lodRanges);
+	}
+}
+
+/******************************************************************************/
+/*!
+\brief
+Reorder a welded mesh for the post-transform cache and for overdraw, build its
+LODs, then lay its vertices out in draw order. Each material's range is
+reordered on its own so the ranges stay where the materials expect them.
+
+\param materials - index ranges to keep, empty if the mesh is one range
+\param lods - receives the LODs appended to indices
+*/
+/******************************************************************************/
+void MeshBuilder::OptimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned>& indices,
+	const std::vector<Material>& materials, std::vector<MeshLod>& lods)
+{
+	lods.clear();
+	if (indices.empty())
+		return;
+	unsigned vertexCount = (unsigned)vertices.size();
+	unsigned fullCount = (unsigned)indices.size();
+
+	std::vector<unsigned> ranges = GetIndexRanges(materials, fullCount);
+	for (unsigned i = 0, first = 0; i < ranges.size() && first + ranges[i] <= fullCount; first += ranges[i++])
+	{
+		OptimizeVertexCache(indices, first, ranges[i], vertexCount);
+		OptimizeOverdraw(indices, first, ranges[i], vertices);
+	}
+	BuildLods(vertices, indices, materials, lods);
+	OptimizeVertexFetch(vertices, indices);
+}
+
+static Mesh* LoadOBJMesh(const std::string& meshName, const std::string& file_path)
 {
 	//Read vertices, texcoords & normals from OBJ
 	std::vector<Position> vertices;
@@ -539,49 +791,181 @@ Mesh* MeshBuilder::GenerateOBJ(const std::string& meshName, const std::string& f
 	std::vector<Vertex> vertex_buffer_data;
 	std::vector<GLuint> index_buffer_data;
 	IndexVBO(vertices, uvs, normals, index_buffer_data, vertex_buffer_data);
+	std::vector<MeshLod> lods;
+	MeshBuilder::OptimizeMesh(vertex_buffer_data, index_buffer_data, std::vector<Material>(), lods);
 
-	Mesh* mesh = new Mesh(meshName);
-	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.size() * sizeof(Vertex), &vertex_buffer_data[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
-	mesh->indexSize = index_buffer_data.size();
+	Mesh* mesh = CreateMesh(meshName, vertex_buffer_data, index_buffer_data, VertexFormat::ChooseCompact(vertex_buffer_data));
+	SetLods(mesh, lods);
 	mesh->mode = Mesh::DRAW_TRIANGLES;
 
 	return mesh;
 }
 
-Mesh* MeshBuilder::GenerateOBJMTL(const std::string& meshName, const std::string& file_path, const std::string& mtl_path)
+//Parse and weld an OBJ + MTL pair, then write the cooked file for next time
+static bool CookOBJMTLData(const std::string& file_path, const std::string& mtl_path, const std::string& cooked_path, MeshData& data)
 {
 	//Read vertices, texcoords & normals from OBJ
 	std::vector<Position> vertices;
 	std::vector<TexCoord> uvs;
 
 	std::vector<Vector3> normals;
-	std::vector<Material> materials;
-	bool success = LoadOBJMTL(file_path.c_str(), mtl_path.c_str(),
-		vertices, uvs, normals, materials);
-	if (!success)
-		return NULL;
+	bool success = LoadOBJMTLParallel(file_path.c_str(), mtl_path.c_str(),
+		vertices, uvs, normals, data.materials);
+	if (!success || vertices.empty())
+		return false;
 	//Index the vertices, texcoords & normals properly
-	std::vector<Vertex> vertex_buffer_data;
-	std::vector<GLuint> index_buffer_data;
-	IndexVBO(vertices, uvs, normals, index_buffer_data,
-		vertex_buffer_data);
-	Mesh* mesh = new Mesh(meshName);
-	for (Material& material : materials)
-		mesh->materials.push_back(material);
-	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.size() *
-		sizeof(Vertex), &vertex_buffer_data[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size()
-		* sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
-	mesh->indexSize = index_buffer_data.size();
+	std::vector<Vertex> welded;
+	IndexVBO(vertices, uvs, normals, data.indices, welded);
+	MeshBuilder::OptimizeMesh(welded, data.indices, data.materials, data.lods);
+
+	//level and character meshes are white, so they usually pack to 20 bytes a vertex
+	data.format = VertexFormat::ChooseCompact(welded);
+	data.vertexCount = (unsigned)welded.size();
+	data.vertices.resize(welded.size() * VertexFormat::Get(data.format).stride);
+	VertexFormat::Get(data.format).Encode(&welded[0], welded.size(), &data.vertices[0]);
+	CookedMesh::Save(cooked_path, data.format, data.vertices, data.vertexCount, data.indices, data.materials, data.lods);
+	return true;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Load an OBJ + MTL pair into memory without touching OpenGL, so it can run on
+a worker thread. Uses the cooked .mesh file when it is up to date.
+
+\param file_path - path of the .obj file
+\param mtl_path - path of the .mtl file
+\param data - receives the welded vertices, indices and materials
+
+\return false if loading failed
+*/
+/******************************************************************************/
+bool MeshBuilder::LoadOBJMTLData(const std::string& file_path, const std::string& mtl_path, MeshData& data)
+{
+	std::string cooked_path = CookedMesh::GetCookedPath(file_path);
+	CookedMesh cooked;
+	if (!CookedMesh::IsStale(cooked_path, file_path, mtl_path) && cooked.Load(cooked_path))
+	{
+		const unsigned char* vertices = (const unsigned char*)cooked.GetVertexData();
+		data.format = cooked.GetVertexFormat();
+		data.vertexCount = cooked.GetVertexCount();
+		data.vertices.assign(vertices, vertices + data.vertexCount * VertexFormat::Get(data.format).stride);
+		data.indices.assign(cooked.GetIndexData(), cooked.GetIndexData() + cooked.GetIndexCount());
+		cooked.GetMaterials(data.materials);
+		cooked.GetLods(data.lods);
+		return true;
+	}
+	return CookOBJMTLData(file_path, mtl_path, cooked_path, data);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Upload mesh data produced by LoadOBJMTLData
+
+\param meshName - name of mesh
+\param data - welded vertices, indices and materials
+
+\return Pointer to mesh storing VBO/IBO of the model
+*/
+/******************************************************************************/
+Mesh* MeshBuilder::GenerateMesh(const std::string& meshName, const MeshData& data)
+{
+	Mesh* mesh = CreateMesh(meshName, data.format, data.vertices.data(), data.vertexCount, data.indices.data(), data.indices.size());
+	mesh->materials = data.materials;
+	SetMaterialBounds(mesh, data.vertices.data(), data.indices.data());
+	SetLods(mesh, data.lods);
 	mesh->mode = Mesh::DRAW_TRIANGLES;
+	mesh->UploadMaterials();
 	return mesh;
 }
 
+/******************************************************************************/
+/*!
+\brief
+Load an OBJ + MTL pair. The welded result is cached next to the OBJ as a
+cooked .mesh file; later loads map that file and upload it directly, and the
+text files are only parsed again when they are newer than the cooked file.
+*/
+/******************************************************************************/
+static Mesh* LoadOBJMTLMesh(const std::string& meshName, const std::string& file_path, const std::string& mtl_path)
+{
+	std::string cooked_path = CookedMesh::GetCookedPath(file_path);
+	CookedMesh cooked;
+	if (!CookedMesh::IsStale(cooked_path, file_path, mtl_path) && cooked.Load(cooked_path))
+	{
+		Mesh* mesh = CreateMesh(meshName, cooked.GetVertexFormat(), cooked.GetVertexData(), cooked.GetVertexCount(),
+			cooked.GetIndexData(), cooked.GetIndexCount());
+		cooked.GetMaterials(mesh->materials);
+		SetMaterialBounds(mesh, cooked.GetVertexData(), cooked.GetIndexData());
+		std::vector<MeshLod> lods;
+		cooked.GetLods(lods);
+		SetLods(mesh, lods);
+		mesh->mode = Mesh::DRAW_TRIANGLES;
+		mesh->UploadMaterials();
+		return mesh;
+	}
+
+	MeshData data;
+	if (!CookOBJMTLData(file_path, mtl_path, cooked_path, data))
+		return NULL;
+	return MeshBuilder::GenerateMesh(meshName, data);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Load an OBJ file through the AssetRegistry. The model is only loaded the
+first time; every call returns a new view of the shared buffers.
+
+\param meshName - name of mesh
+\param file_path - path of the .obj file
+
+\return Pointer to a view of the model's VBO/IBO, NULL if loading failed
+*/
+/******************************************************************************/
+Mesh* MeshBuilder::GenerateOBJ(const std::string& meshName, const std::string& file_path)
+{
+	std::string key = AssetRegistry::MakeKey(file_path);
+	Mesh* shared = AssetRegistry::FindMesh(key);
+	if (shared == nullptr)
+	{
+		shared = LoadOBJMesh(file_path, file_path);
+		if (shared == nullptr)
+			return NULL;
+		AssetRegistry::AddMesh(key, shared);
+	}
+	return new Mesh(meshName, *shared);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Load an OBJ + MTL pair through the AssetRegistry. The model is only loaded
+the first time; every call returns a new view of the shared buffers, so each
+caller can set its own textureID.
+
+\param meshName - name of mesh
+\param file_path - path of the .obj file
+\param mtl_path - path of the .mtl file
+
+\return Pointer to a view of the model's VBO/IBO, NULL if loading failed
+*/
+/******************************************************************************/
+Mesh* MeshBuilder::GenerateOBJMTL(const std::string& meshName, const std::string& file_path, const std::string& mtl_path)
+{
+	std::string key = AssetRegistry::MakeMeshKey(file_path, mtl_path);
+	Mesh* shared = AssetRegistry::FindMesh(key);
+	if (shared == nullptr)
+	{
+		shared = LoadOBJMTLMesh(file_path, file_path, mtl_path);
+		if (shared == nullptr)
+			return NULL;
+		AssetRegistry::AddMesh(key, shared);
+	}
+	return new Mesh(meshName, *shared);
+}
+
 Mesh* MeshBuilder::GenerateText(const std::string& meshName, unsigned numRow, unsigned numCol)
 {
 	Vertex v;
@@ -639,13 +1023,8 @@ Mesh* MeshBuilder::GenerateText(const std::string& meshName, unsigned numRow, un
 	index_buffer_data.push_back(3);
 
 
-	Mesh* mesh = new Mesh(meshName);
-	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.size() * sizeof(Vertex), &vertex_buffer_data[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
+	Mesh* mesh = CreateMesh(meshName, vertex_buffer_data, index_buffer_data);
 	mesh->mode = Mesh::DRAW_TRIANGLES;
-	mesh->indexSize = index_buffer_data.size();
 	return mesh;
 }
 
@@ -3,9 +3,29 @@
 
 #include "Mesh.h"
 #include "Vertex.h"
+#include "VertexFormat.h"
 #include "MyMath.h"
 #include <vector>
 #include "loadOBJ.h"
+#include "TextureAtlas.h"
+
+/******************************************************************************/
+/*!
+		Struct MeshData:
+\brief	Welded model data in system memory, ready to be uploaded
+*/
+/******************************************************************************/
+struct MeshData
+{
+	MeshData() : format(VertexFormat::FORMAT_FLOAT), vertexCount(0) {}
+
+	VertexFormat::TYPE format;
+	std::vector<unsigned char> vertices; //vertexCount vertices encoded in format
+	unsigned vertexCount;
+	std::vector<unsigned> indices;
+	std::vector<Material> materials;
+	std::vector<MeshLod> lods; //coarser ranges appended to indices
+};
 
 /******************************************************************************/
 /*!
@@ -18,6 +38,7 @@ class MeshBuilder
 public:
 	static Mesh* GenerateAxes(const std::string &meshName);
 	static Mesh* GenerateQuad(const std::string& meshName, Color color, float size = 1.f);
+	static Mesh* GenerateQuad(const std::string& meshName, Color color, float size, const AtlasRegion& region);
 	static Mesh* GenerateCube(const std::string& meshName, Color color, float size = 1.f);
 	static Mesh* GenerateCircle(const std::string& meshName, Color color, float radius, int sides, float size = 1.f);
 	static Mesh* GenerateSphere(const std::string& meshName, Color color, unsigned numStacks, unsigned numSlices, float radius);
@@ -27,6 +48,11 @@ public:
 	static Mesh* GenerateOBJ(const std::string& meshName, const std::string& file_path);
 	static Mesh* GenerateOBJMTL(const std::string& meshName, const std::string& file_path, const std::string& mtl_path);
 	static Mesh* GenerateText(const std::string& meshName, unsigned numRow, unsigned numCol);
+	static Mesh* GenerateMesh(const std::string& meshName, const MeshData& data);
+
+	static bool LoadOBJMTLData(const std::string& file_path, const std::string& mtl_path, MeshData& data);
+	static void OptimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned>& indices,
+		const std::vector<Material>& materials, std::vector<MeshLod>& lods);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,699 @@
+#include <cmath>
+#include <algorithm>
+
+#include "MeshOptimizer.h"
+
+//Forsyth's scoring constants
+static const float CACHE_DECAY_POWER = 1.5f;
+static const float LAST_TRIANGLE_SCORE = 0.75f;
+static const float VALENCE_BOOST_SCALE = 2.f;
+static const float VALENCE_BOOST_POWER = 0.5f;
+
+//How much more a simplified mesh is kept from pulling away from an open edge than from a face
+static const double BORDER_WEIGHT = 10.0;
+
+//Cosine of the furthest a simplified triangle may turn from the triangle it started as
+static const float MIN_NORMAL_COS = 0.3f;
+
+/******************************************************************************/
+/*!
+\brief
+Simulate a FIFO post-transform cache of VERTEX_CACHE_SIZE entries
+
+\return cache misses per triangle
+*/
+/******************************************************************************/
+float ComputeACMR(const unsigned* indices, unsigned indexCount, unsigned vertexCount)
+{
+	if (indexCount < 3)
+		return 0.f;
+
+	std::vector<unsigned> timestamp(vertexCount, 0);
+	unsigned time = VERTEX_CACHE_SIZE + 1;
+	unsigned misses = 0;
+	for (unsigned i = 0; i < indexCount; ++i)
+	{
+		unsigned vertex = indices[i];
+		if (time - timestamp[vertex] > VERTEX_CACHE_SIZE)
+		{
+			timestamp[vertex] = time++;
+			++misses;
+		}
+	}
+	return (float)misses / (indexCount / 3);
+}
+
+//How much drawing a triangle that uses this vertex next is worth
+static float GetVertexScore(int cachePosition, unsigned remainingTriangles)
+{
+	if (remainingTriangles == 0)
+		return -1.f;
+
+	float score = 0.f;
+	if (cachePosition >= 3)
+		score = powf(1.f - (float)(cachePosition - 3) / (VERTEX_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+	else if (cachePosition >= 0)
+		score = LAST_TRIANGLE_SCORE; //the triangle just drawn, scored lower so strips do not run forever
+	return score + VALENCE_BOOST_SCALE * powf((float)remainingTriangles, -VALENCE_BOOST_POWER);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Greedily emit the triangle whose vertices score best in a simulated LRU cache.
+Only triangles touching cached vertices are rescored after each step.
+
+\param first - first index of the range, a multiple of 3
+\param count - indices in the range, a multiple of 3
+\param vertexCount - number of vertices the indices refer to
+*/
+/******************************************************************************/
+void OptimizeVertexCache(std::vector<unsigned>& indices, unsigned first, unsigned count, unsigned vertexCount)
+{
+	unsigned triangleCount = count / 3;
+	if (triangleCount < 2)
+		return;
+	const unsigned* source = &indices[first];
+
+	//triangles using each vertex, packed into one array
+	std::vector<unsigned> remaining(vertexCount, 0);
+	for (unsigned i = 0; i < count; ++i)
+	{
+		++remaining[source[i]];
+	}
+	std::vector<unsigned> adjacencyStart(vertexCount + 1, 0);
+	for (unsigned v = 0; v < vertexCount; ++v)
+	{
+		adjacencyStart[v + 1] = adjacencyStart[v] + remaining[v];
+	}
+	std::vector<unsigned> adjacency(count);
+	std::vector<unsigned> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+	for (unsigned i = 0; i < count; ++i)
+	{
+		adjacency[fill[source[i]]++] = i / 3;
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for (unsigned v = 0; v < vertexCount; ++v)
+	{
+		vertexScore[v] = GetVertexScore(-1, remaining[v]);
+	}
+
+	int best = -1;
+	float bestScore = -1.f;
+	std::vector<float> triangleScore(triangleCount);
+	std::vector<bool> emitted(triangleCount, false);
+	for (unsigned t = 0; t < triangleCount; ++t)
+	{
+		triangleScore[t] = vertexScore[source[t * 3]] + vertexScore[source[t * 3 + 1]] + vertexScore[source[t * 3 + 2]];
+		if (triangleScore[t] > bestScore)
+		{
+			best = t;
+			bestScore = triangleScore[t];
+		}
+	}
+
+	std::vector<unsigned> output;
+	output.reserve(count);
+	unsigned cache[VERTEX_CACHE_SIZE + 3];
+	unsigned cacheCount = 0;
+	unsigned nextUnemitted = 0;
+	while (output.size() < count)
+	{
+		//nothing in the cache is worth anything, start again from the next triangle in file order
+		if (best < 0)
+		{
+			while (emitted[nextUnemitted])
+				++nextUnemitted;
+			best = nextUnemitted;
+		}
+
+		emitted[best] = true;
+		const unsigned* triangle = source + best * 3;
+		output.insert(output.end(), triangle, triangle + 3);
+
+		unsigned newCache[VERTEX_CACHE_SIZE + 3];
+		unsigned newCount = 0;
+		for (unsigned k = 0; k < 3; ++k)
+		{
+			unsigned vertex = triangle[k];
+			unsigned* list = &adjacency[adjacencyStart[vertex]];
+			unsigned* last = list + remaining[vertex] - 1;
+			*std::find(list, last + 1, (unsigned)best) = *last;
+			--remaining[vertex];
+
+			if (std::find(newCache, newCache + newCount, vertex) == newCache + newCount)
+				newCache[newCount++] = vertex;
+		}
+		for (unsigned i = 0; i < cacheCount; ++i)
+		{
+			if (std::find(newCache, newCache + newCount, cache[i]) == newCache + newCount)
+				newCache[newCount++] = cache[i];
+		}
+
+		//rescore everything that moved in or fell out of the cache
+		for (unsigned i = 0; i < newCount; ++i)
+		{
+			unsigned vertex = newCache[i];
+			cachePosition[vertex] = i < VERTEX_CACHE_SIZE ? (int)i : -1;
+			float score = GetVertexScore(cachePosition[vertex], remaining[vertex]);
+			float delta = score - vertexScore[vertex];
+			vertexScore[vertex] = score;
+			for (unsigned j = 0; j < remaining[vertex]; ++j)
+			{
+				triangleScore[adjacency[adjacencyStart[vertex] + j]] += delta;
+			}
+		}
+		cacheCount = std::min(newCount, VERTEX_CACHE_SIZE);
+		std::copy(newCache, newCache + cacheCount, cache);
+
+		best = -1;
+		bestScore = -1.f;
+		for (unsigned i = 0; i < cacheCount; ++i)
+		{
+			unsigned vertex = cache[i];
+			for (unsigned j = 0; j < remaining[vertex]; ++j)
+			{
+				unsigned t = adjacency[adjacencyStart[vertex] + j];
+				if (triangleScore[t] > bestScore)
+				{
+					best = t;
+					bestScore = triangleScore[t];
+				}
+			}
+		}
+	}
+
+	std::copy(output.begin(), output.end(), indices.begin() + first);
+}
+
+static Vector3 ToVector3(const Position& position)
+{
+	return Vector3(position.x, position.y, position.z);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Split a cache optimised range into clusters where the cache runs cold (a
+triangle missing on all three vertices), then draw the clusters facing away
+from the mesh centre first so they hide what is behind them. Splitting only
+at cold points keeps the ACMR almost unchanged.
+*/
+/******************************************************************************/
+void OptimizeOverdraw(std::vector<unsigned>& indices, unsigned first, unsigned count, const std::vector<Vertex>& vertices)
+{
+	unsigned triangleCount = count / 3;
+	if (triangleCount < 2)
+		return;
+	const unsigned* source = &indices[first];
+
+	std::vector<unsigned> clusterStart;
+	std::vector<unsigned> timestamp(vertices.size(), 0);
+	unsigned time = VERTEX_CACHE_SIZE + 1;
+	for (unsigned t = 0; t < triangleCount; ++t)
+	{
+		unsigned misses = 0;
+		for (unsigned k = 0; k < 3; ++k)
+		{
+			unsigned vertex = source[t * 3 + k];
+			if (time - timestamp[vertex] > VERTEX_CACHE_SIZE)
+			{
+				timestamp[vertex] = time++;
+				++misses;
+			}
+		}
+		if (t == 0 || misses == 3)
+			clusterStart.push_back(t);
+	}
+	if (clusterStart.size() < 2)
+		return;
+	clusterStart.push_back(triangleCount);
+
+	Vector3 meshCentre;
+	float meshArea = 0.f;
+	std::vector<Vector3> centres(clusterStart.size() - 1);
+	std::vector<Vector3> normals(clusterStart.size() - 1);
+	for (unsigned c = 0; c + 1 < clusterStart.size(); ++c)
+	{
+		float clusterArea = 0.f;
+		for (unsigned t = clusterStart[c]; t < clusterStart[c + 1]; ++t)
+		{
+			Vector3 a = ToVector3(vertices[source[t * 3]].pos);
+			Vector3 b = ToVector3(vertices[source[t * 3 + 1]].pos);
+			Vector3 d = ToVector3(vertices[source[t * 3 + 2]].pos);
+			Vector3 normal = (b - a).Cross(d - a);
+			float area = normal.Length();
+			Vector3 centre = (a + b + d) * (1.f / 3.f);
+
+			normals[c] += normal;
+			centres[c] += centre * area;
+			clusterArea += area;
+			meshCentre += centre * area;
+			meshArea += area;
+		}
+		if (clusterArea > 0.f)
+			centres[c] = centres[c] * (1.f / clusterArea);
+	}
+	if (meshArea > 0.f)
+		meshCentre = meshCentre * (1.f / meshArea);
+
+	std::vector<float> keys(centres.size());
+	std::vector<unsigned> order(centres.size());
+	for (unsigned c = 0; c < centres.size(); ++c)
+	{
+		float length = normals[c].Length();
+		keys[c] = length > 0.f ? (centres[c] - meshCentre).Dot(normals[c]) / length : 0.f;
+		order[c] = c;
+	}
+	std::stable_sort(order.begin(), order.end(), [&keys](unsigned a, unsigned b)
+	{
+		return keys[a] > keys[b];
+	});
+
+	std::vector<unsigned> output;
+	output.reserve(count);
+	for (unsigned i = 0; i < order.size(); ++i)
+	{
+		unsigned c = order[i];
+		output.insert(output.end(), source + clusterStart[c] * 3, source + clusterStart[c + 1] * 3);
+	}
+	std::copy(output.begin(), output.end(), indices.begin() + first);
+}
+
+//Sum of squared distances to a set of planes, as a symmetric 4x4 matrix
+struct Quadric
+{
+	double a00, a01, a02, a11, a12, a22;
+	double b0, b1, b2;
+	double c;
+};
+
+static void AddPlane(Quadric& q, const Vector3& normal, double distance, double weight)
+{
+	q.a00 += weight * normal.x * normal.x;
+	q.a01 += weight * normal.x * normal.y;
+	q.a02 += weight * normal.x * normal.z;
+	q.a11 += weight * normal.y * normal.y;
+	q.a12 += weight * normal.y * normal.z;
+	q.a22 += weight * normal.z * normal.z;
+	q.b0 += weight * normal.x * distance;
+	q.b1 += weight * normal.y * distance;
+	q.b2 += weight * normal.z * distance;
+	q.c += weight * distance * distance;
+}
+
+static void AddQuadric(Quadric& q, const Quadric& rhs)
+{
+	q.a00 += rhs.a00; q.a01 += rhs.a01; q.a02 += rhs.a02;
+	q.a11 += rhs.a11; q.a12 += rhs.a12; q.a22 += rhs.a22;
+	q.b0 += rhs.b0; q.b1 += rhs.b1; q.b2 += rhs.b2;
+	q.c += rhs.c;
+}
+
+static double EvaluateQuadric(const Quadric& q, const Vector3& p)
+{
+	double error = q.a00 * p.x * p.x + q.a11 * p.y * p.y + q.a22 * p.z * p.z
+		+ 2 * (q.a01 * p.x * p.y + q.a02 * p.x * p.z + q.a12 * p.y * p.z)
+		+ 2 * (q.b0 * p.x + q.b1 * p.y + q.b2 * p.z) + q.c;
+	return error < 0 ? 0 : error;
+}
+
+static bool LessPosition(const Position& a, const Position& b)
+{
+	if (a.x != b.x)
+		return a.x < b.x;
+	if (a.y != b.y)
+		return a.y < b.y;
+	return a.z < b.z;
+}
+
+//How different a vertex looks when another vertex at the same position replaces it
+static float GetAttributeDistance(const Vertex& a, const Vertex& b)
+{
+	float du = a.texCoord.u - b.texCoord.u;
+	float dv = a.texCoord.v - b.texCoord.v;
+	return (1.f - a.normal.Dot(b.normal)) + du * du + dv * dv;
+}
+
+struct EdgeUse
+{
+	unsigned a, b;		//positions, a < b
+	unsigned triangle;
+	unsigned corner;	//the edge runs from this corner of the triangle to the next
+
+	bool operator<(const EdgeUse& rhs) const
+	{
+		return a != rhs.a ? a < rhs.a : b < rhs.b;
+	}
+};
+
+struct Collapse
+{
+	unsigned from, to;	//positions
+	double cost;
+
+	bool operator<(const Collapse& rhs) const
+	{
+		return cost < rhs.cost;
+	}
+};
+
+/******************************************************************************/
+/*!
+\brief
+Simplify by collapsing edges onto their cheaper end, costed by the summed
+plane quadrics of both ends (Garland & Heckbert). Open edges add planes
+perpendicular to their triangle so holes and outlines keep their shape.
+
+Collapses move positions rather than vertices, so seams where the welder
+split a position by normal or UV move together and never crack. Each vertex
+at the removed position is replaced by the vertex at the kept position it
+shares a triangle with, or else by the one with the closest normal and UV.
+The output only indexes the input vertices, so LODs share one vertex buffer.
+
+Each pass collapses edges in order of cost, skipping edges whose triangles an
+earlier collapse in the pass changed and collapses that would flip a triangle.
+A triangle is also kept within MIN_NORMAL_COS of its normal in the input, so
+small turns over many passes cannot add up to a flip.
+
+\param ranges - index counts of the consecutive material ranges in indices
+\param targetIndexCount - stop once about this many indices are left in total
+\param out_indices - receives the simplified ranges back to back
+\param out_ranges - receives the index count of each simplified range
+*/
+/******************************************************************************/
+void SimplifyMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices, const std::vector<unsigned>& ranges,
+	unsigned targetIndexCount, std::vector<unsigned>& out_indices, std::vector<unsigned>& out_ranges)
+{
+	unsigned vertexCount = (unsigned)vertices.size();
+
+	//vertices at the same position, grouped by a sort
+	std::vector<unsigned> sorted(vertexCount);
+	for (unsigned v = 0; v < vertexCount; ++v)
+	{
+		sorted[v] = v;
+	}
+	std::sort(sorted.begin(), sorted.end(), [&vertices](unsigned a, unsigned b)
+	{
+		return LessPosition(vertices[a].pos, vertices[b].pos);
+	});
+	std::vector<unsigned> positionOf(vertexCount);
+	std::vector<unsigned> positionStart;
+	std::vector<Vector3> positions;
+	for (unsigned i = 0; i < vertexCount; ++i)
+	{
+		const Position& pos = vertices[sorted[i]].pos;
+		if (i == 0 || LessPosition(vertices[sorted[i - 1]].pos, pos))
+		{
+			positionStart.push_back(i);
+			positions.push_back(ToVector3(pos));
+		}
+		positionOf[sorted[i]] = (unsigned)positions.size() - 1;
+	}
+	unsigned positionCount = (unsigned)positions.size();
+	positionStart.push_back(vertexCount);
+
+	std::vector<unsigned> triangleRange;
+	for (unsigned r = 0; r < ranges.size(); ++r)
+	{
+		triangleRange.insert(triangleRange.end(), ranges[r] / 3, r);
+	}
+	std::vector<unsigned> triangles(indices.begin(), indices.begin() + std::min(indices.size(), triangleRange.size() * 3));
+	triangleRange.resize(triangles.size() / 3);
+
+	//area weighted planes of each triangle, and border planes along edges only one triangle uses
+	std::vector<Quadric> quadrics(positionCount, Quadric());
+	std::vector<EdgeUse> edges;
+	for (unsigned t = 0; t < triangleRange.size(); ++t)
+	{
+		unsigned p[3] = { positionOf[triangles[t * 3]], positionOf[triangles[t * 3 + 1]], positionOf[triangles[t * 3 + 2]] };
+		Vector3 normal = (positions[p[1]] - positions[p[0]]).Cross(positions[p[2]] - positions[p[0]]);
+		float area = normal.Length();
+		if (area <= 0.f)
+			continue;
+		normal = normal * (1.f / area);
+		for (unsigned k = 0; k < 3; ++k)
+		{
+			AddPlane(quadrics[p[k]], normal, -normal.Dot(positions[p[0]]), area);
+			EdgeUse edge = { std::min(p[k], p[(k + 1) % 3]), std::max(p[k], p[(k + 1) % 3]), t, k };
+			edges.push_back(edge);
+		}
+	}
+	std::sort(edges.begin(), edges.end());
+	for (size_t i = 0; i < edges.size(); ++i)
+	{
+		if ((i > 0 && !(edges[i - 1] < edges[i])) || (i + 1 < edges.size() && !(edges[i] < edges[i + 1])))
+			continue;
+		const unsigned* triangle = &triangles[edges[i].triangle * 3];
+		unsigned from = positionOf[triangle[edges[i].corner]];
+		unsigned to = positionOf[triangle[(edges[i].corner + 1) % 3]];
+		Vector3 edge = positions[to] - positions[from];
+		Vector3 normal = (positions[positionOf[triangle[1]]] - positions[positionOf[triangle[0]]]).Cross(
+			positions[positionOf[triangle[2]]] - positions[positionOf[triangle[0]]]);
+		Vector3 border = edge.Cross(normal);
+		float length = border.Length();
+		if (length <= 0.f)
+			continue;
+		border = border * (1.f / length);
+		double weight = BORDER_WEIGHT * edge.LengthSquared();
+		AddPlane(quadrics[from], border, -border.Dot(positions[from]), weight);
+		AddPlane(quadrics[to], border, -border.Dot(positions[from]), weight);
+	}
+
+	//unit normal of each triangle in the input, carried along as triangles are rewritten
+	std::vector<Vector3> triangleNormals(triangleRange.size());
+	for (unsigned t = 0; t < triangleRange.size(); ++t)
+	{
+		Vector3 normal = (positions[positionOf[triangles[t * 3 + 1]]] - positions[positionOf[triangles[t * 3]]]).Cross(
+			positions[positionOf[triangles[t * 3 + 2]]] - positions[positionOf[triangles[t * 3]]]);
+		float area = normal.Length();
+		triangleNormals[t] = area > 0.f ? normal * (1.f / area) : normal;
+	}
+
+	std::vector<unsigned> remap(vertexCount);
+	for (unsigned v = 0; v < vertexCount; ++v)
+	{
+		remap[v] = v;
+	}
+	std::vector<unsigned> adjacencyStart(positionCount + 1);
+	std::vector<unsigned> adjacency;
+	std::vector<Collapse> collapses;
+	std::vector<bool> touched;
+	while (triangles.size() > targetIndexCount)
+	{
+		//triangles around each position
+		std::fill(adjacencyStart.begin(), adjacencyStart.end(), 0);
+		for (size_t i = 0; i < triangles.size(); ++i)
+		{
+			++adjacencyStart[positionOf[triangles[i]] + 1];
+		}
+		for (unsigned p = 0; p < positionCount; ++p)
+		{
+			adjacencyStart[p + 1] += adjacencyStart[p];
+		}
+		adjacency.resize(triangles.size());
+		std::vector<unsigned> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+		for (size_t i = 0; i < triangles.size(); ++i)
+		{
+			adjacency[fill[positionOf[triangles[i]]]++] = (unsigned)(i / 3);
+		}
+
+		//the cheaper direction of every edge
+		edges.clear();
+		for (unsigned t = 0; t * 3 < triangles.size(); ++t)
+		{
+			for (unsigned k = 0; k < 3; ++k)
+			{
+				unsigned a = positionOf[triangles[t * 3 + k]];
+				unsigned b = positionOf[triangles[t * 3 + (k + 1) % 3]];
+				EdgeUse edge = { std::min(a, b), std::max(a, b), t, k };
+				edges.push_back(edge);
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+		collapses.clear();
+		for (size_t i = 0; i < edges.size(); ++i)
+		{
+			if (i > 0 && !(edges[i - 1] < edges[i]))
+				continue;
+			Quadric q = quadrics[edges[i].a];
+			AddQuadric(q, quadrics[edges[i].b]);
+			double costToB = EvaluateQuadric(q, positions[edges[i].b]);
+			double costToA = EvaluateQuadric(q, positions[edges[i].a]);
+			Collapse collapse = { edges[i].a, edges[i].b, costToB };
+			if (costToA < costToB)
+			{
+				collapse.from = edges[i].b;
+				collapse.to = edges[i].a;
+				collapse.cost = costToA;
+			}
+			collapses.push_back(collapse);
+		}
+		std::sort(collapses.begin(), collapses.end());
+
+		touched.assign(positionCount, false);
+		unsigned goal = ((unsigned)triangles.size() - targetIndexCount + 2) / 3;
+		unsigned removed = 0;
+		for (size_t i = 0; i < collapses.size() && removed < goal; ++i)
+		{
+			unsigned from = collapses[i].from;
+			unsigned to = collapses[i].to;
+			if (touched[from] || touched[to])
+				continue;
+
+			bool flips = false;
+			unsigned lost = 0;
+			for (unsigned j = adjacencyStart[from]; j < adjacencyStart[from + 1] && !flips; ++j)
+			{
+				const unsigned* triangle = &triangles[adjacency[j] * 3];
+				Vector3 before[3], after[3];
+				bool degenerate = false;
+				for (unsigned k = 0; k < 3; ++k)
+				{
+					unsigned p = positionOf[triangle[k]];
+					degenerate = degenerate || p == to;
+					before[k] = positions[p];
+					after[k] = p == from ? positions[to] : positions[p];
+				}
+				if (degenerate)
+				{
+					++lost;
+					continue;
+				}
+				Vector3 normalBefore = (before[1] - before[0]).Cross(before[2] - before[0]);
+				Vector3 normalAfter = (after[1] - after[0]).Cross(after[2] - after[0]);
+				flips = normalBefore.Dot(normalAfter) <= 0.f ||
+					triangleNormals[adjacency[j]].Dot(normalAfter) <= MIN_NORMAL_COS * normalAfter.Length();
+			}
+			if (flips)
+				continue;
+
+			//move every vertex at from onto a vertex at to
+			for (unsigned s = positionStart[from]; s < positionStart[from + 1]; ++s)
+			{
+				unsigned vertex = sorted[s];
+				unsigned replacement = vertexCount;
+				for (unsigned j = adjacencyStart[from]; j < adjacencyStart[from + 1] && replacement == vertexCount; ++j)
+				{
+					const unsigned* triangle = &triangles[adjacency[j] * 3];
+					if (triangle[0] != vertex && triangle[1] != vertex && triangle[2] != vertex)
+						continue;
+					for (unsigned k = 0; k < 3; ++k)
+					{
+						if (positionOf[triangle[k]] == to)
+							replacement = triangle[k];
+					}
+				}
+				if (replacement == vertexCount)
+				{
+					float bestDistance = 0.f;
+					for (unsigned t = positionStart[to]; t < positionStart[to + 1]; ++t)
+					{
+						float distance = GetAttributeDistance(vertices[vertex], vertices[sorted[t]]);
+						if (replacement == vertexCount || distance < bestDistance)
+						{
+							bestDistance = distance;
+							replacement = sorted[t];
+						}
+					}
+				}
+				remap[vertex] = replacement;
+			}
+
+			AddQuadric(quadrics[to], quadrics[from]);
+			touched[from] = true;
+			touched[to] = true;
+			for (unsigned j = adjacencyStart[from]; j < adjacencyStart[from + 1]; ++j)
+			{
+				const unsigned* triangle = &triangles[adjacency[j] * 3];
+				for (unsigned k = 0; k < 3; ++k)
+				{
+					touched[positionOf[triangle[k]]] = true;
+				}
+			}
+			removed += lost;
+		}
+		if (removed == 0)
+			break;
+
+		//rewrite the triangles, dropping the ones that collapsed
+		unsigned kept = 0;
+		for (unsigned t = 0; t * 3 < triangles.size(); ++t)
+		{
+			unsigned a = remap[triangles[t * 3]], b = remap[triangles[t * 3 + 1]], c = remap[triangles[t * 3 + 2]];
+			if (positionOf[a] == positionOf[b] || positionOf[b] == positionOf[c] || positionOf[a] == positionOf[c])
+				continue;
+			triangles[kept * 3] = a;
+			triangles[kept * 3 + 1] = b;
+			triangles[kept * 3 + 2] = c;
+			triangleNormals[kept] = triangleNormals[t];
+			triangleRange[kept++] = triangleRange[t];
+		}
+		triangles.resize(kept * 3);
+		triangleRange.resize(kept);
+		triangleNormals.resize(kept);
+	}
+
+	out_indices.swap(triangles);
+	out_ranges.assign(ranges.size(), 0);
+	for (size_t t = 0; t < triangleRange.size(); ++t)
+	{
+		out_ranges[triangleRange[t]] += 3;
+	}
+}
+
+/******************************************************************************/
+/*!
+\brief
+Count triangles facing away from the surface, judged by the vertex normals of
+their corners. Zero for a mesh as imported; a simplified level with any is
+turned inside out somewhere.
+*/
+/******************************************************************************/
+unsigned CountFlippedTriangles(const std::vector<Vertex>& vertices, const unsigned* indices, unsigned indexCount)
+{
+	unsigned flipped = 0;
+	for (unsigned i = 0; i + 2 < indexCount; i += 3)
+	{
+		const Vertex& a = vertices[indices[i]];
+		const Vertex& b = vertices[indices[i + 1]];
+		const Vertex& c = vertices[indices[i + 2]];
+		Vector3 ab = ToVector3(b.pos) - ToVector3(a.pos);
+		Vector3 ac = ToVector3(c.pos) - ToVector3(a.pos);
+		Vector3 normal = ab.Cross(ac);
+		//corners all but in a line face no way in particular
+		if (normal.LengthSquared() <= 1e-8f * ab.LengthSquared() * ac.LengthSquared())
+			continue;
+		if (normal.Dot(a.normal + b.normal + c.normal) < 0.f)
+			++flipped;
+	}
+	return flipped;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Store vertices in the order they are first drawn so vertex fetches walk the
+VBO forwards. Vertices no index refers to are dropped.
+*/
+/******************************************************************************/
+void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned>& indices)
+{
+	const unsigned UNUSED = ~0u;
+	std::vector<unsigned> remap(vertices.size(), UNUSED);
+	std::vector<Vertex> reordered;
+	reordered.reserve(vertices.size());
+	for (size_t i = 0; i < indices.size(); ++i)
+	{
+		unsigned& vertex = remap[indices[i]];
+		if (vertex == UNUSED)
+		{
+			vertex = (unsigned)reordered.size();
+			reordered.push_back(vertices[indices[i]]);
+		}
+		indices[i] = vertex;
+	}
+	vertices.swap(reordered);
+}
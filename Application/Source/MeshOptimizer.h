@@ -0,0 +1,39 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <vector>
+#include "Vertex.h"
+
+/******************************************************************************/
+/*!
+\brief
+Passes run on welded meshes at import. The reordering passes do not change
+what is drawn, only the order triangles and vertices reach the GPU in. Index
+ranges are reordered in place so per-material ranges stay where they are.
+SimplifyMesh builds coarser index buffers over the same vertices for LODs.
+*/
+/******************************************************************************/
+
+//Vertices the cache model assumes the GPU keeps after transform
+const unsigned VERTEX_CACHE_SIZE = 32;
+
+//Average vertex shader runs per triangle for a FIFO cache: 3 without reuse, 0.5 at best
+float ComputeACMR(const unsigned* indices, unsigned indexCount, unsigned vertexCount);
+
+//Forsyth's linear-speed vertex cache optimisation of the triangles in [first, first + count)
+void OptimizeVertexCache(std::vector<unsigned>& indices, unsigned first, unsigned count, unsigned vertexCount);
+
+//Move outward facing clusters of triangles to the front of a cache optimised range
+void OptimizeOverdraw(std::vector<unsigned>& indices, unsigned first, unsigned count, const std::vector<Vertex>& vertices);
+
+//Quadric error edge collapse down to about targetIndexCount indices, reusing the input vertices
+void SimplifyMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices, const std::vector<unsigned>& ranges,
+	unsigned targetIndexCount, std::vector<unsigned>& out_indices, std::vector<unsigned>& out_ranges);
+
+//Triangles whose winding disagrees with their corners' vertex normals
+unsigned CountFlippedTriangles(const std::vector<Vertex>& vertices, const unsigned* indices, unsigned indexCount);
+
+//Renumber vertices in the order the index buffer first uses them
+void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned>& indices);
+
+#endif
@@ -0,0 +1,329 @@
+#include <algorithm>
+#include <GL\glew.h>
+
+#include "Renderer.h"
+#include "UniformTable.h"
+#include "DynamicGeometry.h"
+#include "AssetRegistry.h"
+
+//Key layout, high bits first. The sequence keeps equal-state draws in submit order.
+static const unsigned KEY_PASS_SHIFT = 62;
+static const unsigned long long KEY_PASS_WORLD_BLENDED = 1;
+static const unsigned long long KEY_PASS_SCREEN = 2;
+static const unsigned KEY_PROGRAM_SHIFT = 54;
+static const unsigned KEY_TEXTURE_SHIFT = 38;
+static const unsigned KEY_VERTEX_ARRAY_SHIFT = 26;
+static const unsigned KEY_LIGHT_SHIFT = 25;
+static const unsigned KEY_MATERIAL_SHIFT = 14;
+static const unsigned KEY_SEQUENCE_MASK = (1u << 14) - 1;
+
+static bool SameComponent(const Component& lhs, const Component& rhs)
+{
+	return lhs.r == rhs.r && lhs.g == rhs.g && lhs.b == rhs.b;
+}
+
+static bool SameMaterial(const Material& lhs, const Material& rhs)
+{
+	return SameComponent(lhs.kAmbient, rhs.kAmbient) && SameComponent(lhs.kDiffuse, rhs.kDiffuse) &&
+		SameComponent(lhs.kSpecular, rhs.kSpecular) && lhs.kShininess == rhs.kShininess;
+}
+
+Renderer::Renderer() : programID(0)
+{
+	for (unsigned i = 0; i < U_TOTAL; ++i)
+		parameters[i] = -1;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Look up the uniforms draws set. Call after the scene's LoadShaders.
+*/
+/******************************************************************************/
+void Renderer::Init(unsigned programID)
+{
+	this->programID = programID;
+	const UniformTable& uniforms = UniformTable::Get(programID);
+	parameters[U_MVP] = uniforms.GetLocation("MVP");
+	parameters[U_MODELVIEW] = uniforms.GetLocation("MV");
+	parameters[U_MODELVIEW_INVERSE_TRANSPOSE] = uniforms.GetLocation("MV_inverse_transpose");
+	parameters[U_MATERIAL_AMBIENT] = uniforms.GetLocation("material.kAmbient");
+	parameters[U_MATERIAL_DIFFUSE] = uniforms.GetLocation("material.kDiffuse");
+	parameters[U_MATERIAL_SPECULAR] = uniforms.GetLocation("material.kSpecular");
+	parameters[U_MATERIAL_SHININESS] = uniforms.GetLocation("material.kShininess");
+	parameters[U_LIGHTENABLED] = uniforms.GetLocation("lightEnabled");
+	parameters[U_COLOR_TEXTURE_ENABLED] = uniforms.GetLocation("colorTextureEnabled");
+	parameters[U_COLOR_TEXTURE] = uniforms.GetLocation("colorTexture");
+	parameters[U_TEXT_ENABLED] = uniforms.GetLocation("textEnabled");
+	parameters[U_TEXT_COLOR] = uniforms.GetLocation("textColor");
+}
+
+/******************************************************************************/
+/*!
+\brief
+Queue a mesh
+
+\param lod - level to draw, 0 for the full mesh. See Mesh::SelectLod.
+*/
+/******************************************************************************/
+void Renderer::DrawMesh(Mesh* mesh, const Mtx44& projection, const Mtx44& modelView, bool enableLight, unsigned lod, PASS pass)
+{
+	if (mesh == nullptr)
+		return;
+	Command command;
+	command.type = COMMAND_MESH;
+	command.pass = pass;
+	command.mesh = mesh;
+	command.lod = lod;
+	command.enableLight = enableLight;
+	command.MVP = projection * modelView;
+	command.modelView = modelView;
+	command.first = command.count = 0;
+	Submit(command);
+}
+
+//Queue one instanced draw of a mesh at each model matrix
+void Renderer::DrawMeshInstanced(Mesh* mesh, const Mtx44& projection, const Mtx44& view, const std::vector<Mtx44>& models, bool enableLight)
+{
+	if (mesh == nullptr || models.empty())
+		return;
+	Command command;
+	command.type = COMMAND_INSTANCED;
+	command.pass = PASS_WORLD;
+	command.mesh = mesh;
+	command.lod = 0;
+	command.enableLight = enableLight;
+	command.MVP = projection * view;
+	command.modelView = view;
+	command.first = (unsigned)instances.size();
+	command.count = (unsigned)models.size();
+	instances.insert(instances.end(), models.begin(), models.end());
+	Submit(command);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Queue a line of text from a font mesh of 6 indices per character
+
+\param MVP - transform of the line; character i is drawn at
+	(originX + i * spacing, originY) in it
+*/
+/******************************************************************************/
+void Renderer::DrawText(Mesh* mesh, const std::string& text, Color color, const Mtx44& MVP, float spacing,
+	float originX, float originY, PASS pass)
+{
+	if (mesh == nullptr || mesh->textureID <= 0 || text.empty())
+		return;
+	Command command;
+	command.type = COMMAND_TEXT;
+	command.pass = pass;
+	command.mesh = mesh;
+	command.lod = 0;
+	command.enableLight = false;
+	command.MVP = MVP;
+	command.modelView.SetToIdentity();
+	command.color = color;
+	command.first = (unsigned)characters.size();
+	command.count = (unsigned)text.size();
+	command.spacing = spacing;
+	command.originX = originX;
+	command.originY = originY;
+	characters += text;
+	Submit(command);
+}
+
+//Queue an untextured unit quad from DynamicGeometry
+void Renderer::DrawQuad(Color color, const Mtx44& MVP, PASS pass)
+{
+	Command command;
+	command.type = COMMAND_QUAD;
+	command.pass = pass;
+	command.mesh = nullptr;
+	command.lod = 0;
+	command.enableLight = false;
+	command.MVP = MVP;
+	command.modelView.SetToIdentity();
+	command.color = color;
+	command.first = command.count = 0;
+	Submit(command);
+}
+
+void Renderer::Submit(const Command& command)
+{
+	//meshes built from no indices have no geometry to draw
+	if (command.mesh != nullptr && command.mesh->geometry.page == nullptr)
+		return;
+	Command queued = command;
+	queued.textureID = queued.mesh != nullptr ? queued.mesh->textureID : 0;
+	//state sorting would reorder blended draws among themselves
+	if (queued.pass == PASS_WORLD && AssetRegistry::IsTranslucent(queued.textureID))
+		queued.pass = PASS_WORLD_BLENDED;
+	queued.materialID = queued.enableLight ? InternMaterial(queued.mesh->material) : 0;
+	order.push_back(std::make_pair(MakeKey(queued, (unsigned)commands.size()), (unsigned)commands.size()));
+	commands.push_back(queued);
+}
+
+//Index of an equal material queued this frame, adding it if there is none
+unsigned Renderer::InternMaterial(const Material& material)
+{
+	for (size_t i = 0; i < materials.size(); ++i)
+	{
+		if (SameMaterial(materials[i], material))
+			return (unsigned)i;
+	}
+	materials.push_back(material);
+	return (unsigned)materials.size() - 1;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Sort key of a queued draw. Opaque world draws sort by the state that is most
+expensive to change first; blended world draws and then screen draws follow
+in submission order.
+*/
+/******************************************************************************/
+unsigned long long Renderer::MakeKey(const Command& command, unsigned sequence) const
+{
+	if (command.pass == PASS_WORLD_BLENDED)
+		return (KEY_PASS_WORLD_BLENDED << KEY_PASS_SHIFT) | sequence;
+	if (command.pass != PASS_WORLD)
+		return (KEY_PASS_SCREEN << KEY_PASS_SHIFT) | sequence;
+
+	unsigned vertexArray = command.mesh != nullptr ? command.mesh->vertexArray : 0;
+	return ((unsigned long long)(programID & 0xFF) << KEY_PROGRAM_SHIFT) |
+		((unsigned long long)(command.textureID & 0xFFFF) << KEY_TEXTURE_SHIFT) |
+		((unsigned long long)(vertexArray & 0xFFF) << KEY_VERTEX_ARRAY_SHIFT) |
+		((unsigned long long)(command.enableLight ? 1 : 0) << KEY_LIGHT_SHIFT) |
+		((unsigned long long)(command.materialID & 0x7FF) << KEY_MATERIAL_SHIFT) |
+		(sequence & KEY_SEQUENCE_MASK);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Draw everything queued since the last Flush and empty the queue. Call once at
+the end of the scene's Render, after the lights are set. State is not assumed
+to carry over between flushes, since other scenes share the program.
+*/
+/******************************************************************************/
+void Renderer::Flush()
+{
+	std::sort(order.begin(), order.end());
+
+	glUseProgram(programID);
+	glActiveTexture(GL_TEXTURE0);
+	glUniform1i(parameters[U_COLOR_TEXTURE], 0);
+	glUniform1i(parameters[U_TEXT_ENABLED], 0);
+
+	int depthTest = -1, lightEnabled = -1, textureEnabled = -1, textEnabled = 0;
+	unsigned boundTexture = ~0u;
+	const Material* boundMaterial = nullptr;
+	bool textColorSet = false;
+	Color textColor;
+
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		const Command& command = commands[order[i].second];
+
+		int depth = command.pass == PASS_SCREEN ? 0 : 1;
+		if (depth != depthTest)
+		{
+			if (depth)
+				glEnable(GL_DEPTH_TEST);
+			else
+				glDisable(GL_DEPTH_TEST);
+			depthTest = depth;
+		}
+
+		int light = command.enableLight ? 1 : 0;
+		if (light != lightEnabled)
+		{
+			glUniform1i(parameters[U_LIGHTENABLED], light);
+			lightEnabled = light;
+		}
+		if (command.enableLight)
+		{
+			Mtx44 modelView_inverse_transpose = command.modelView.GetInverse().GetTranspose();
+			glUniformMatrix4fv(parameters[U_MODELVIEW_INVERSE_TRANSPOSE], 1, GL_FALSE, &modelView_inverse_transpose.a[0]);
+
+			const Material& material = materials[command.materialID];
+			if (boundMaterial != &material)
+			{
+				glUniform3fv(parameters[U_MATERIAL_AMBIENT], 1, &material.kAmbient.r);
+				glUniform3fv(parameters[U_MATERIAL_DIFFUSE], 1, &material.kDiffuse.r);
+				glUniform3fv(parameters[U_MATERIAL_SPECULAR], 1, &material.kSpecular.r);
+				glUniform1f(parameters[U_MATERIAL_SHININESS], material.kShininess);
+				boundMaterial = &material;
+			}
+		}
+
+		int texture = command.textureID > 0 ? 1 : 0;
+		if (texture != textureEnabled)
+		{
+			glUniform1i(parameters[U_COLOR_TEXTURE_ENABLED], texture);
+			textureEnabled = texture;
+		}
+		if (texture && command.textureID != boundTexture)
+		{
+			glBindTexture(GL_TEXTURE_2D, command.textureID);
+			boundTexture = command.textureID;
+		}
+
+		int text = command.type == COMMAND_TEXT ? 1 : 0;
+		if (text != textEnabled)
+		{
+			glUniform1i(parameters[U_TEXT_ENABLED], text);
+			textEnabled = text;
+		}
+		if (text && (!textColorSet || command.color.r != textColor.r || command.color.g != textColor.g || command.color.b != textColor.b))
+		{
+			glUniform3fv(parameters[U_TEXT_COLOR], 1, &command.color.r);
+			textColor = command.color;
+			textColorSet = true;
+		}
+
+		glUniformMatrix4fv(parameters[U_MODELVIEW], 1, GL_FALSE, &command.modelView.a[0]);
+		switch (command.type)
+		{
+		case COMMAND_MESH:
+			glUniformMatrix4fv(parameters[U_MVP], 1, GL_FALSE, &command.MVP.a[0]);
+			command.mesh->RenderLod(command.lod);
+			break;
+		case COMMAND_INSTANCED:
+			glUniformMatrix4fv(parameters[U_MVP], 1, GL_FALSE, &command.MVP.a[0]);
+			command.mesh->RenderInstanced(&instances[command.first], command.count);
+			break;
+		case COMMAND_TEXT:
+			for (unsigned c = 0; c < command.count; ++c)
+			{
+				Mtx44 characterSpacing;
+				characterSpacing.SetToTranslation(command.originX + c * command.spacing, command.originY, 0);
+				Mtx44 MVP = command.MVP * characterSpacing;
+				glUniformMatrix4fv(parameters[U_MVP], 1, GL_FALSE, &MVP.a[0]);
+				command.mesh->Render((unsigned)(unsigned char)characters[command.first + c] * 6, 6);
+			}
+			break;
+		case COMMAND_QUAD:
+			glUniformMatrix4fv(parameters[U_MVP], 1, GL_FALSE, &command.MVP.a[0]);
+			DynamicGeometry::DrawQuad(command.color);
+			break;
+		}
+
+		//meshes without a material block set the material uniforms themselves
+		if (command.mesh != nullptr && !command.mesh->materials.empty())
+			boundMaterial = nullptr;
+	}
+
+	if (textEnabled)
+		glUniform1i(parameters[U_TEXT_ENABLED], 0);
+	if (depthTest == 0)
+		glEnable(GL_DEPTH_TEST);
+
+	commands.clear();
+	materials.clear();
+	instances.clear();
+	characters.clear();
+	order.clear();
+}
@@ -0,0 +1,101 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <string>
+#include <vector>
+#include "Mesh.h"
+#include "Mtx44.h"
+
+/******************************************************************************/
+/*!
+		Class Renderer:
+\brief	Collects a scene's draws for the frame and submits them in Flush.
+		World draws are sorted by a 64 bit key (program, texture, vertex
+		array, material) so draws sharing state run back to back and each
+		uniform, bind and depth toggle is only issued when it changes.
+		World draws with a translucent texture, text among them, blend with
+		what is behind them, so they go after the opaque world in the order
+		they were submitted. Screen draws also keep their submission order
+		and go last, as UI is drawn over whatever came before it.
+
+		Matrices are taken as they are at submit time, so callers can keep
+		building them on their MatrixStacks.
+*/
+/******************************************************************************/
+class Renderer
+{
+public:
+	enum PASS
+	{
+		PASS_WORLD,			//depth tested, sorted by state
+		PASS_WORLD_BLENDED,	//depth tested, after the opaque world in submission order
+		PASS_SCREEN,		//after the world in submission order, over everything
+		PASS_SCREEN_DEPTH,	//like PASS_SCREEN, but depth tested
+	};
+
+	Renderer();
+
+	void Init(unsigned programID);
+	void DrawMesh(Mesh* mesh, const Mtx44& projection, const Mtx44& modelView, bool enableLight,
+		unsigned lod = 0, PASS pass = PASS_WORLD);
+	void DrawMeshInstanced(Mesh* mesh, const Mtx44& projection, const Mtx44& view, const std::vector<Mtx44>& models, bool enableLight);
+	void DrawText(Mesh* mesh, const std::string& text, Color color, const Mtx44& MVP, float spacing,
+		float originX = 0.f, float originY = 0.f, PASS pass = PASS_WORLD);
+	void DrawQuad(Color color, const Mtx44& MVP, PASS pass = PASS_SCREEN);
+	void Flush();
+
+private:
+	enum COMMAND_TYPE
+	{
+		COMMAND_MESH,
+		COMMAND_INSTANCED,
+		COMMAND_TEXT,
+		COMMAND_QUAD,
+	};
+	enum UNIFORM_TYPE
+	{
+		U_MVP = 0,
+		U_MODELVIEW,
+		U_MODELVIEW_INVERSE_TRANSPOSE,
+		U_MATERIAL_AMBIENT,
+		U_MATERIAL_DIFFUSE,
+		U_MATERIAL_SPECULAR,
+		U_MATERIAL_SHININESS,
+		U_LIGHTENABLED,
+		U_COLOR_TEXTURE_ENABLED,
+		U_COLOR_TEXTURE,
+		U_TEXT_ENABLED,
+		U_TEXT_COLOR,
+		U_TOTAL,
+	};
+
+	struct Command
+	{
+		COMMAND_TYPE type;
+		PASS pass;
+		Mesh* mesh;
+		unsigned lod;
+		bool enableLight;
+		unsigned textureID;
+		unsigned materialID;	//index into materials, shared by equal materials
+		Mtx44 MVP;
+		Mtx44 modelView;
+		Color color;			//text and quad color
+		unsigned first, count;	//instance matrices or text characters
+		float spacing, originX, originY;
+	};
+
+	unsigned long long MakeKey(const Command& command, unsigned sequence) const;
+	unsigned InternMaterial(const Material& material);
+	void Submit(const Command& command);
+
+	unsigned programID;
+	int parameters[U_TOTAL];
+	std::vector<Command> commands;
+	std::vector<Material> materials;
+	std::vector<Mtx44> instances;
+	std::string characters;
+	std::vector<std::pair<unsigned long long, unsigned> > order;
+};
+
+#endif
@@ -6,6 +6,7 @@
 #include "Mesh.h"
 #include "MatrixStack.h"
 #include "Light.h"
+#include "UniformTable.h"
 #include "Utility.h"
 #include "LoadTGA.h"
 #include "Entity.h"
@@ -75,30 +76,6 @@ private:
 		U_MATERIAL_DIFFUSE,
 		U_MATERIAL_SPECULAR,
 		U_MATERIAL_SHININESS,
-		//Light 1 (Bathroom)
-		U_LIGHT0_POSITION,
-		U_LIGHT0_COLOR,
-		U_LIGHT0_POWER,
-		U_LIGHT0_KC,
-		U_LIGHT0_KL,
-		U_LIGHT0_KQ,
-		U_LIGHT0_TYPE,
-		U_LIGHT0_SPOTDIRECTION,
-		U_LIGHT0_COSCUTOFF,
-		U_LIGHT0_COSINNER,
-		U_LIGHT0_EXPONENT,
-		//Light 2 (Bedroom)
-		U_LIGHT1_POSITION,
-		U_LIGHT1_COLOR,
-		U_LIGHT1_POWER,
-		U_LIGHT1_KC,
-		U_LIGHT1_KL,
-		U_LIGHT1_KQ,
-		U_LIGHT1_TYPE,
-		U_LIGHT1_SPOTDIRECTION,
-		U_LIGHT1_COSCUTOFF,
-		U_LIGHT1_COSINNER,
-		U_LIGHT1_EXPONENT,
 		U_LIGHTENABLED,
 		U_NUMLIGHTS,
 		U_COLOR_TEXTURE_ENABLED,
@@ -113,8 +90,8 @@ private:
 	MS modelStack, viewStack, projectionStack;
 
 	unsigned m_parameters[U_TOTAL];
-	unsigned m_vertexArrayID;
-	Mesh* meshList[NUM_GEOMETRY];
+	const UniformTable* m_uniforms;
+	Mesh* meshList[NUM_GEOMETRY] = {};
 	Entity entityList[NUM_ENTITY];
 
 	unsigned m_programID;
@@ -138,6 +115,7 @@ private:
 	void RenderMeshOnScreen(Mesh* mesh, float x, float y, float sizex, float sizey);
 	void RenderText(Mesh* mesh, std::string text, Color color);
 	void RenderTextOnScreen(Mesh* mesh, std::string text, Color color, float size, float x, float y);
+	void ReleaseMeshes();
 	void RenderEvidenceObject(Entity* entity, float rangeX, float rangeY);
 	void InspectEvidenceOnScreen(Mesh* mesh, float x, float y, float sizex, float sizey, float rotatez, float rotatex);
 	void RenderPressEToInteract();
@@ -153,6 +131,7 @@ private:
 	bool IsInDoorRInteraction();
 
 public:
+	virtual void Preload();
 	virtual void Init();
 	virtual void Update(double dt);
 	virtual void Render();
@@ -1,16 +1,23 @@
 #ifndef SCENE_H
 #define SCENE_H
 
+#include "Renderer.h"
+
 class Scene
 {
 public:
 	Scene() {}
 	virtual ~Scene() {}
 
+	//Queue the scene's heavy assets on the AssetStreamer before Init
+	virtual void Preload() {}
 	virtual void Init() = 0;
 	virtual void Update(double dt) = 0;
 	virtual void Render() = 0;
 	virtual void Exit() = 0;
+
+protected:
+	Renderer renderer; //draws are queued here and submitted at the end of Render
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -2,33 +2,16 @@
 #include "GL\glew.h"
 
 #include "shader.hpp"
+#include "UniformTable.h"
 #include "MeshBuilder.h"
+#include "TextureAtlas.h"
 
 void SceneMiniGame::RenderMesh(Mesh* mesh, bool enableLight)
 {
-	Mtx44 MVP, modelView, modelView_inverse_transpose;
-
-	MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, &MVP.a[0]);
-	modelView = viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MODELVIEW], 1, GL_FALSE, &modelView.a[0]);
-
-	if (mesh->textureID > 0)
-	{
-		glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 1);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, mesh->textureID);
-		glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
-	}
-	else
-	{
-		glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 0);
-	}
-	mesh->Render(); //this line should only be called once
-	if (mesh->textureID > 0)
-	{
-		glBindTexture(GL_TEXTURE_2D, 0);
-	}
+	Mtx44 modelView = viewStack.Top() * modelStack.Top();
+	//imported meshes with LODs, such as the dining hall tables, draw a coarser one from afar
+	renderer.DrawMesh(mesh, projectionStack.Top(), modelView, enableLight,
+		mesh != nullptr ? mesh->SelectLod(modelView, projectionStack.Top()) : 0);
 }
 
 void SceneMiniGame::RenderEntity(Entity* entity, bool enableLight)
@@ -36,77 +19,39 @@ void SceneMiniGame::RenderEntity(Entity* entity, bool enableLight)
 	modelStack.PushMatrix();
 	modelStack.Translate(entity->getTransform().x, entity->getTransform().y, entity->getTransform().z);
 	modelStack.Scale(entity->getScale().x, entity->getScale().x, entity->getScale().x);
-
-	Mtx44 MVP, modelView, modelView_inverse_transpose;
-
-	MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, &MVP.a[0]);
-	modelView = viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MODELVIEW], 1, GL_FALSE, &modelView.a[0]);
-
-	if (entity->getMesh()->textureID > 0)
-	{
-		glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 1);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, entity->getMesh()->textureID);
-		glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
-	}
-	else
-	{
-		glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 0);
-	}
-	entity->getMesh()->Render(); //this line should only be called once
-	if (entity->getMesh()->textureID > 0)
-	{
-		glBindTexture(GL_TEXTURE_2D, 0);
-	}
-
+	Mtx44 modelView = viewStack.Top() * modelStack.Top();
 	modelStack.PopMatrix();
+	//distant characters and props draw a coarser LOD
+	Mesh* mesh = entity->getMesh();
+	renderer.DrawMesh(mesh, projectionStack.Top(), modelView, enableLight, mesh->SelectLod(modelView, projectionStack.Top()));
 }
 
 void SceneMiniGame::RenderText(Mesh* mesh, std::string text, Color color)
 {
-	if (!mesh || mesh->textureID <= 0) //Proper error check
-	{
-		return;
-	}
-	glUniform1i(m_parameters[U_TEXT_ENABLED], 1);
-	glUniform3fv(m_parameters[U_TEXT_COLOR], 1, &color.r);
-	glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 1);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, mesh->textureID);
-	glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
-	for (unsigned i = 0; i < text.length(); ++i)
-	{
-		Mtx44 characterSpacing;
-		characterSpacing.SetToTranslation(i * 1.0f, 0, 0); //1.0f is the spacing of each character, you may change this value
-		Mtx44 MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top() * characterSpacing;
-		glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, &MVP.a[0]);
-		mesh->Render((unsigned)text[i] * 6, 6);
-	}
-
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glUniform1i(m_parameters[U_TEXT_ENABLED], 0);
+	renderer.DrawText(mesh, text, color, projectionStack.Top() * viewStack.Top() * modelStack.Top(), 1.0f);
 }
 
 void SceneMiniGame::RenderMeshOnScreen(Mesh* mesh, float x, float y, float sizex, float sizey)
 {
-	glDisable(GL_DEPTH_TEST);
 	Mtx44 ortho;
 	ortho.SetToOrtho(0, Application::screenUISizeX, 0, Application::screenUISizeY, -10, 10); //size of screen UI
-	projectionStack.PushMatrix();
-	projectionStack.LoadMatrix(ortho);
-	viewStack.PushMatrix();
-	viewStack.LoadIdentity(); //No need camera for ortho mode
 	modelStack.PushMatrix();
 	modelStack.LoadIdentity(); //Reset modelStack
 	modelStack.Translate(x, y, 0);
 	modelStack.Scale(sizex, sizey, 1);
-	RenderMesh(mesh, false);
-	projectionStack.PopMatrix();
-	viewStack.PopMatrix();
+	renderer.DrawMesh(mesh, ortho, modelStack.Top(), false, 0, Renderer::PASS_SCREEN);
 	modelStack.PopMatrix();
-	glEnable(GL_DEPTH_TEST);
+}
+
+//A plain colored panel, written into DynamicGeometry instead of a mesh per color
+void SceneMiniGame::RenderQuadOnScreen(Color color, float x, float y, float sizex, float sizey)
+{
+	Mtx44 ortho;
+	ortho.SetToOrtho(0, Application::screenUISizeX, 0, Application::screenUISizeY, -10, 10); //size of screen UI
+	Mtx44 translate, scale;
+	translate.SetToTranslation(x, y, 0);
+	scale.SetToScale(sizex, sizey, 1);
+	renderer.DrawQuad(color, ortho * translate * scale);
 }
 
 void SceneMiniGame::RenderTextOnScreen(Mesh* mesh, std::string text, Color color, float size, float x, float y)
@@ -117,38 +62,14 @@ void SceneMiniGame::RenderTextOnScreen(Mesh* mesh, std::string text, Color color
 	{
 		return;
 	}
-	glDisable(GL_DEPTH_TEST);
 	Mtx44 ortho;
 	ortho.SetToOrtho(0, Application::screenUISizeX, 0, Application::screenUISizeY, -10, 10); //size of screen UI
-	projectionStack.PushMatrix();
-	projectionStack.LoadMatrix(ortho);
-	viewStack.PushMatrix();
-	viewStack.LoadIdentity(); //No need camera for ortho mode
 	modelStack.PushMatrix();
 	modelStack.LoadIdentity(); //Reset modelStack
 	modelStack.Translate(x - text.size() * (0.5f * spacing), y, 0);
 	modelStack.Scale(size, size, size);
-	glUniform1i(m_parameters[U_TEXT_ENABLED], 1);
-	glUniform3fv(m_parameters[U_TEXT_COLOR], 1, &color.r);
-	glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 1);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, mesh->textureID);
-	glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
-	for (unsigned i = 0; i < text.length(); ++i)
-	{
-		Mtx44 characterSpacing;
-		characterSpacing.SetToTranslation(0.5f + i * spacing, 0.5f, 0); //1.0f is the spacing of each character, you may change this value
-		Mtx44 MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top() * characterSpacing;
-		glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, &MVP.a[0]);
-		mesh->Render((unsigned)text[i] * 6, 6);
-	}
-
-		glBindTexture(GL_TEXTURE_2D, 0);
-		glUniform1i(m_parameters[U_TEXT_ENABLED], 0);
-		projectionStack.PopMatrix();
-		viewStack.PopMatrix();
-		modelStack.PopMatrix();
-		glEnable(GL_DEPTH_TEST);
+	renderer.DrawText(mesh, text, color, ortho * modelStack.Top(), spacing, 0.5f, 0.5f, Renderer::PASS_SCREEN);
+	modelStack.PopMatrix();
 }
 
 bool SceneMiniGame::CreateButton(float buttonTop, float buttonBottom, float buttonRight, float buttonLeft)
@@ -218,6 +139,9 @@ void SceneMiniGame::ResetGameVariables()
 
 void SceneMiniGame::Init()
 {
+	//meshes of an earlier Init, when the scene is entered again
+	ReleaseMeshes();
+
 	// Init VBO here
 	Mtx44 projection;
 
@@ -250,28 +174,26 @@ void SceneMiniGame::Init()
 	//set background color
 	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 
-	//generate default VAO for now
-	glGenVertexArrays(1, &m_vertexArrayID);
-	glBindVertexArray(m_vertexArrayID);
-
 	//load vertex and fragment shaders
 	m_programID = LoadShaders("Shader//Texture.vertexshader", "Shader//Text.fragmentshader");
+	renderer.Init(m_programID);
+	const UniformTable& uniforms = UniformTable::Get(m_programID);
 
-	m_parameters[U_MVP] = glGetUniformLocation(m_programID, "MVP");
-	m_parameters[U_MODELVIEW] = glGetUniformLocation(m_programID, "MV");
-	m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE] = glGetUniformLocation(m_programID, "MV_inverse_transpose");
-	m_parameters[U_MATERIAL_AMBIENT] = glGetUniformLocation(m_programID, "material.kAmbient");
-	m_parameters[U_MATERIAL_DIFFUSE] = glGetUniformLocation(m_programID, "material.kDiffuse");
-	m_parameters[U_MATERIAL_SPECULAR] = glGetUniformLocation(m_programID, "material.kSpecular");
-	m_parameters[U_MATERIAL_SHININESS] = glGetUniformLocation(m_programID, "material.kShininess");
+	m_parameters[U_MVP] = uniforms.GetLocation("MVP");
+	m_parameters[U_MODELVIEW] = uniforms.GetLocation("MV");
+	m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE] = uniforms.GetLocation("MV_inverse_transpose");
+	m_parameters[U_MATERIAL_AMBIENT] = uniforms.GetLocation("material.kAmbient");
+	m_parameters[U_MATERIAL_DIFFUSE] = uniforms.GetLocation("material.kDiffuse");
+	m_parameters[U_MATERIAL_SPECULAR] = uniforms.GetLocation("material.kSpecular");
+	m_parameters[U_MATERIAL_SHININESS] = uniforms.GetLocation("material.kShininess");
 
 	// Get a handle for our "colorTexture" uniform
-	m_parameters[U_COLOR_TEXTURE_ENABLED] = glGetUniformLocation(m_programID, "colorTextureEnabled");
-	m_parameters[U_COLOR_TEXTURE] = glGetUniformLocation(m_programID, "colorTexture");
+	m_parameters[U_COLOR_TEXTURE_ENABLED] = uniforms.GetLocation("colorTextureEnabled");
+	m_parameters[U_COLOR_TEXTURE] = uniforms.GetLocation("colorTexture");
 
 	// Get a handle for our "textColor" uniform
-	m_parameters[U_TEXT_ENABLED] = glGetUniformLocation(m_programID, "textEnabled");
-	m_parameters[U_TEXT_COLOR] = glGetUniformLocation(m_programID, "textColor");
+	m_parameters[U_TEXT_ENABLED] = uniforms.GetLocation("textEnabled");
+	m_parameters[U_TEXT_COLOR] = uniforms.GetLocation("textColor");
 
 	//use our shader
 	glUseProgram(m_programID);
@@ -280,7 +202,7 @@ void SceneMiniGame::Init()
 	glEnable(GL_DEPTH_TEST);
 
 	//Get a handle for our "MVP" uniform
-	m_parameters[U_MVP] = glGetUniformLocation(m_programID, "MVP");
+	m_parameters[U_MVP] = uniforms.GetLocation("MVP");
 
 	Mesh::SetMaterialLoc(m_parameters[U_MATERIAL_AMBIENT],
 		m_parameters[U_MATERIAL_DIFFUSE],
@@ -289,20 +211,15 @@ void SceneMiniGame::Init()
 
 	meshList[GEO_QUAD] = MeshBuilder::GenerateQuad("quad", Color(0.5, 0.5, 0.5), 1.f);
 
-	meshList[GEO_GOLD] = MeshBuilder::GenerateQuad("gold", Color(0.5, 0.5, 0.5), 1.f);
-	meshList[GEO_GOLD]->textureID = LoadTGA("Image//gold.tga");
+	meshList[GEO_GOLD] = MeshBuilder::GenerateQuad("gold", Color(0.5, 0.5, 0.5), 1.f, TextureAtlas::GetUI().AcquireRegion("Image//gold.tga"));
 
-	meshList[GEO_DYNAMITE] = MeshBuilder::GenerateQuad("dynamite", Color(0.5, 0.5, 0.5), 1.f);
-	meshList[GEO_DYNAMITE]->textureID = LoadTGA("Image//dynamite.tga");
+	meshList[GEO_DYNAMITE] = MeshBuilder::GenerateQuad("dynamite", Color(0.5, 0.5, 0.5), 1.f, TextureAtlas::GetUI().AcquireRegion("Image//dynamite.tga"));
 
-	meshList[GEO_HEART] = MeshBuilder::GenerateQuad("heart", Color(0.5, 0.5, 0.5), 1.f);
-	meshList[GEO_HEART]->textureID = LoadTGA("Image//heart.tga");
+	meshList[GEO_HEART] = MeshBuilder::GenerateQuad("heart", Color(0.5, 0.5, 0.5), 1.f, TextureAtlas::GetUI().AcquireRegion("Image//heart.tga"));
 
-	meshList[GEO_OVER] = MeshBuilder::GenerateQuad("gameover", Color(0.5, 0.5, 0.5), 1.f);
-	meshList[GEO_OVER]->textureID = LoadTGA("Image//gameover.tga");
+	meshList[GEO_OVER] = MeshBuilder::GenerateQuad("gameover", Color(0.5, 0.5, 0.5), 1.f, TextureAtlas::GetUI().AcquireRegion("Image//gameover.tga"));
 
-	meshList[GEO_LOGO] = MeshBuilder::GenerateQuad("logo", Color(0.5, 0.5, 0.5), 1.f);
-	meshList[GEO_LOGO]->textureID = LoadTGA("Image//minigamelogo.tga");
+	meshList[GEO_LOGO] = MeshBuilder::GenerateQuad("logo", Color(0.5, 0.5, 0.5), 1.f, TextureAtlas::GetUI().AcquireRegion("Image//minigamelogo.tga"));
 
 	meshList[GEO_TEXT] = MeshBuilder::GenerateText("text", 16, 16);
 	meshList[GEO_TEXT]->textureID = LoadTGA("Image//arial.tga");
@@ -311,9 +228,8 @@ void SceneMiniGame::Init()
 	Application::SetCanPause(false);
 
 	//bgm
-	Application::soundManager.ReleaseSound(Application::soundList[Application::SOUND_MAINGAME]);
-	Application::soundManager.CreateSound(&Application::soundList[Application::SOUND_MINIGAME], "Sound/MiniGame.wav");
-	Application::soundManager.RunSound(Application::soundList[Application::SOUND_MINIGAME]);
+	Application::soundManager.StopAll(Application::SOUND_MAINGAME);
+	Application::soundManager.Play(Application::SOUND_MINIGAME);
 }
 
 void SceneMiniGame::Update(double dt)
@@ -610,18 +526,13 @@ void SceneMiniGame::Render()
 	modelStack.LoadIdentity();
 	if (miniGameState == EXITCONFIRMATION)
 	{
-		meshList[GEO_QUAD] = MeshBuilder::GenerateQuad("quad", Color(0, 0, 0), 1.f);
-
-		RenderMeshOnScreen(meshList[GEO_QUAD], 40, 30, 60, 50);
+		RenderQuadOnScreen(Color(0, 0, 0), 40, 30, 60, 50);
 		RenderTextOnScreen(meshList[GEO_TEXT], "Are you sure?" ,Color(1, 1, 1), 5, 16, 35);
 
-		meshList[GEO_QUAD] = MeshBuilder::GenerateQuad("quad", Color(1, 1, 1), 1.f);
-
-
-		RenderMeshOnScreen(meshList[GEO_QUAD], noX, noY, noSizeX, noSizeY);
+		RenderQuadOnScreen(Color(1, 1, 1), noX, noY, noSizeX, noSizeY);
 		RenderTextOnScreen(meshList[GEO_TEXT], "No", Color(0, 0, 0), 3, 22, 14);
 
-		RenderMeshOnScreen(meshList[GEO_QUAD], yesX, yesY, yesSizeX, yesSizeY);
+		RenderQuadOnScreen(Color(1, 1, 1), yesX, yesY, yesSizeX, yesSizeY);
 		RenderTextOnScreen(meshList[GEO_TEXT], "Yes", Color(0, 0, 0), 3, 51.5, 14);
 	}
 	else if (miniGameState == MAINMENU)
@@ -684,11 +595,10 @@ void SceneMiniGame::Render()
 		}
 
 		//header
-		meshList[GEO_QUAD] = MeshBuilder::GenerateQuad("quad", Color(1, 1, 1), 1.f);
-		RenderMeshOnScreen(meshList[GEO_QUAD], 40, 55, 80, 10);
+		RenderQuadOnScreen(Color(1, 1, 1), 40, 55, 80, 10);
 
 		//tray/player
-		RenderMeshOnScreen(meshList[GEO_QUAD], platformTransformX, platformTransformY, 10, 2);
+		RenderQuadOnScreen(Color(1, 1, 1), platformTransformX, platformTransformY, 10, 2);
 
 		//ui on top of screen
 		std::stringstream tempStream;
@@ -726,16 +636,25 @@ void SceneMiniGame::Render()
 	{
 		RenderTextOnScreen(meshList[GEO_TEXT], "Press 'B' to exit", Color(1, 1, 1), 2, 50, 1);
 	}
-	
+
+	renderer.Flush();
+}
+
+//Delete the scene's meshes, releasing the assets they share through the AssetRegistry
+void SceneMiniGame::ReleaseMeshes()
+{
+	for (int i = 0; i < NUM_GEOMETRY; ++i)
+	{
+		delete meshList[i];
+		meshList[i] = nullptr;
+	}
 }
 
 void SceneMiniGame::Exit()
 {
+	ReleaseMeshes();
 	Application::SetCanPause(true);
-	Application::soundManager.ReleaseSound(Application::soundList[Application::SOUND_MINIGAME]);
-	Application::soundManager.CreateSound(&Application::soundList[Application::SOUND_MAINGAME], "Sound/MainGame.wav");
-	Application::soundManager.RunSound(Application::soundList[Application::SOUND_MAINGAME]);
-	// Cleanup VBO here
-	glDeleteVertexArrays(1, &m_vertexArrayID);
-	glDeleteProgram(m_programID);
+	Application::soundManager.StopAll(Application::SOUND_MINIGAME);
+	Application::soundManager.Play(Application::SOUND_MAINGAME);
+	//the program is shared, ClearShaderCache frees it
 }
\ No newline at end of file
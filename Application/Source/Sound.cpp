@@ -1,10 +1,18 @@
 #include "Sound.h"
 
 Sound::Sound()
+    : m_pSystem(nullptr), m_startCount(0)
 {
+    for (unsigned i = 0; i < VOICE_COUNT; ++i)
+    {
+        Voice voice = { nullptr, 0, 1, 0 };
+        m_voices[i] = voice;
+    }
+
     if (FMOD::System_Create(&m_pSystem) != FMOD_OK)
     {
         // Report Error
+        m_pSystem = nullptr;
         return;
     }
 
@@ -17,35 +25,225 @@ Sound::Sound()
         return;
     }
 
-    // Initialize our Instance with 36 Channels
+    // Initialize our Instance with 36 Channels. The pool only hands out VOICE_COUNT
+    // of them, so FMOD never has to steal a voice behind a live handle.
     m_pSystem->init(36, FMOD_INIT_NORMAL, nullptr);
 }
 
 Sound::~Sound()
 {
+    if (m_pSystem == nullptr)
+        return;
+    ReleaseSamples();
     m_pSystem->close();
     m_pSystem->release();
 }
 
-void Sound::CreateSound(FMOD::Sound** pSound, const char* pFile)
+/******************************************************************************/
+/*!
+\brief
+Load a sample into the bank. Call once at startup, never per play.
+
+\param sample - id the sample is played with
+\param pFile - path of the sound file
+\param bStream - stream from disk instead of decoding into memory, for long
+	music tracks. A streamed sample plays on at most one voice.
+\param maxInstances - voices the sample may use at once. Playing it again
+	past the limit restarts its oldest voice.
+
+\return false if the file could not be loaded
+*/
+/******************************************************************************/
+bool Sound::LoadSample(unsigned sample, const char* pFile, bool bStream, unsigned maxInstances)
 {
-    m_pSystem->createSound(pFile, FMOD_DEFAULT, 0, pSound);
+    if (m_pSystem == nullptr)
+        return false;
+    if (sample >= m_samples.size())
+    {
+        Sample empty = { nullptr, 0 };
+        m_samples.resize(sample + 1, empty);
+    }
+
+    Sample& entry = m_samples[sample];
+    if (entry.pSound != nullptr)
+    {
+        StopAll(sample);
+        entry.pSound->release();
+        entry.pSound = nullptr;
+    }
+
+    FMOD_MODE mode = FMOD_DEFAULT | (bStream ? FMOD_CREATESTREAM : FMOD_CREATESAMPLE);
+    if (m_pSystem->createSound(pFile, mode, nullptr, &entry.pSound) != FMOD_OK)
+    {
+        entry.pSound = nullptr;
+        return false;
+    }
+    entry.maxInstances = bStream ? 1 : (maxInstances > 0 ? maxInstances : 1);
+    return true;
 }
 
-void Sound::RunSound(FMOD::Sound* pSound, bool bLoop)
+//Stop every voice and free the bank. Called when the system shuts down.
+void Sound::ReleaseSamples()
 {
-    if (!bLoop)
-        pSound->setMode(FMOD_LOOP_OFF);
+    for (unsigned i = 0; i < VOICE_COUNT; ++i)
+    {
+        if (IsActive(m_voices[i]))
+            m_voices[i].pChannel->stop();
+        m_voices[i].pChannel = nullptr;
+    }
+    for (unsigned i = 0; i < m_samples.size(); ++i)
+    {
+        if (m_samples[i].pSound != nullptr)
+            m_samples[i].pSound->release();
+    }
+    m_samples.clear();
+}
+
+/******************************************************************************/
+/*!
+\brief
+Start a sample on a pooled voice
+
+\return handle of the voice, or 0 if the sample was not loaded
+*/
+/******************************************************************************/
+Sound::Handle Sound::Play(unsigned sample, bool bLoop)
+{
+    if (sample >= m_samples.size() || m_samples[sample].pSound == nullptr)
+        return 0;
+
+    unsigned slot = (unsigned)(&AllocateVoice(sample) - m_voices);
+    Voice& voice = m_voices[slot];
+
+    //start paused so the loop mode is set before anything is heard
+    FMOD::Channel* pChannel = nullptr;
+    if (m_pSystem->playSound(m_samples[sample].pSound, nullptr, true, &pChannel) != FMOD_OK)
+        return 0;
+    if (bLoop)
+    {
+        pChannel->setMode(FMOD_LOOP_NORMAL);
+        pChannel->setLoopCount(-1);
+    }
     else
     {
-        pSound->setMode(FMOD_LOOP_NORMAL);
-        pSound->setLoopCount(-1);
+        pChannel->setMode(FMOD_LOOP_OFF);
+    }
+    pChannel->setPaused(false);
+
+    voice.pChannel = pChannel;
+    voice.sample = sample;
+    voice.startOrder = ++m_startCount;
+    return voice.generation * VOICE_COUNT + slot;
+}
+
+//Pause or resume a voice. Ignored if the handle has expired.
+void Sound::Pause(Handle handle, bool bPaused)
+{
+    Voice* voice = GetVoice(handle);
+    if (voice != nullptr)
+        voice->pChannel->setPaused(bPaused);
+}
+
+void Sound::Stop(Handle handle)
+{
+    Voice* voice = GetVoice(handle);
+    if (voice == nullptr)
+        return;
+    voice->pChannel->stop();
+    voice->pChannel = nullptr;
+    ++voice->generation;
+}
+
+//Stop every voice playing a sample, e.g. the music of the previous scene
+void Sound::StopAll(unsigned sample)
+{
+    for (unsigned i = 0; i < VOICE_COUNT; ++i)
+    {
+        if (m_voices[i].sample == sample && IsActive(m_voices[i]))
+            Stop(m_voices[i].generation * VOICE_COUNT + i);
     }
-        
-    m_pSystem->playSound(pSound, nullptr, false, 0);
 }
 
-void Sound::ReleaseSound(FMOD::Sound* pSound)
+//True while the voice is playing or paused
+bool Sound::IsPlaying(Handle handle)
 {
-    pSound->release();
+    return GetVoice(handle) != nullptr;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Let FMOD finish voices that have ended and free their slots. Call once a frame.
+*/
+/******************************************************************************/
+void Sound::Update()
+{
+    if (m_pSystem == nullptr)
+        return;
+    m_pSystem->update();
+    for (unsigned i = 0; i < VOICE_COUNT; ++i)
+    {
+        if (m_voices[i].pChannel != nullptr && !IsActive(m_voices[i]))
+        {
+            m_voices[i].pChannel = nullptr;
+            ++m_voices[i].generation;
+        }
+    }
+}
+
+//The voice a handle refers to, or null if it has ended or been reused
+Sound::Voice* Sound::GetVoice(Handle handle)
+{
+    if (handle == 0)
+        return nullptr;
+    Voice& voice = m_voices[handle % VOICE_COUNT];
+    if (voice.generation != handle / VOICE_COUNT || !IsActive(voice))
+        return nullptr;
+    return &voice;
+}
+
+bool Sound::IsActive(const Voice& voice) const
+{
+    bool playing = false;
+    //FMOD reports an invalid handle once a channel has ended
+    return voice.pChannel != nullptr && voice.pChannel->isPlaying(&playing) == FMOD_OK && playing;
+}
+
+//A free voice, else the sample's oldest voice if it is at its limit, else the oldest voice
+Sound::Voice& Sound::AllocateVoice(unsigned sample)
+{
+    unsigned instances = 0;
+    Voice* free = nullptr;
+    Voice* oldest = nullptr;
+    Voice* oldestOfSample = nullptr;
+    for (unsigned i = 0; i < VOICE_COUNT; ++i)
+    {
+        Voice& voice = m_voices[i];
+        if (!IsActive(voice))
+        {
+            if (free == nullptr)
+                free = &voice;
+            continue;
+        }
+        if (oldest == nullptr || voice.startOrder < oldest->startOrder)
+            oldest = &voice;
+        if (voice.sample == sample)
+        {
+            ++instances;
+            if (oldestOfSample == nullptr || voice.startOrder < oldestOfSample->startOrder)
+                oldestOfSample = &voice;
+        }
+    }
+
+    Voice* voice = free;
+    if (instances >= m_samples[sample].maxInstances)
+        voice = oldestOfSample;
+    else if (voice == nullptr)
+        voice = oldest;
+
+    if (voice->pChannel != nullptr)
+        voice->pChannel->stop();
+    voice->pChannel = nullptr;
+    ++voice->generation;
+    return *voice;
 }
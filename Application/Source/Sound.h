@@ -1,19 +1,66 @@
 #pragma once
 
+#include <vector>
+
 //include fmod
 #include <fmod/fmod.hpp>
 
+/******************************************************************************/
+/*!
+		Class Sound:
+\brief	Sound bank and channel pool. Every sample is loaded once with
+		LoadSample, then played through a fixed pool of voices. Play returns
+		a handle that stays valid until the voice is stopped or reused, so
+		callers can pause, resume and stop what they started without keeping
+		FMOD objects around.
+*/
+/******************************************************************************/
 class Sound
 {
+public:
+    //0 is never a valid handle
+    typedef unsigned Handle;
+
+    enum
+    {
+        VOICE_COUNT = 32,
+    };
+
+    Sound();
+    ~Sound();
+
+    bool LoadSample(unsigned sample, const char* pFile, bool bStream = false, unsigned maxInstances = 1);
+    void ReleaseSamples();
+
+    Handle Play(unsigned sample, bool bLoop = false);
+    void Pause(Handle handle, bool bPaused);
+    void Stop(Handle handle);
+    void StopAll(unsigned sample);
+    bool IsPlaying(Handle handle);
+
+    void Update();
+
 private:
-	FMOD::System* m_pSystem;
+    struct Sample
+    {
+        FMOD::Sound* pSound;
+        unsigned maxInstances;
+    };
 
-public:
-	Sound();
-	~Sound();
+    struct Voice
+    {
+        FMOD::Channel* pChannel;
+        unsigned sample;
+        unsigned generation;
+        unsigned startOrder; //which voice to steal first
+    };
 
-	void CreateSound(FMOD::Sound** pSound, const char* pFile);
-	void RunSound(FMOD::Sound* pSound, bool bLoop = false);
-	void ReleaseSound(FMOD::Sound* pSound); //release means delete
-};
+    Voice* GetVoice(Handle handle);
+    bool IsActive(const Voice& voice) const;
+    Voice& AllocateVoice(unsigned sample);
 
+    FMOD::System* m_pSystem;
+    std::vector<Sample> m_samples;
+    Voice m_voices[VOICE_COUNT];
+    unsigned m_startCount;
+};
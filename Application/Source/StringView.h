@@ -0,0 +1,38 @@
+#ifndef STRING_VIEW_H
+#define STRING_VIEW_H
+
+#include <cstring>
+#include <string>
+#include <ostream>
+
+/******************************************************************************/
+/*!
+		Struct StringView:
+\brief	Non-owning, unterminated run of characters, e.g. a line of a mapped
+		file. Valid only as long as the memory it points into.
+*/
+/******************************************************************************/
+struct StringView
+{
+	const char* data;
+	size_t length;
+
+	StringView() : data(""), length(0) {}
+	StringView(const char* data, size_t length) : data(data), length(length) {}
+
+	bool empty() const { return length == 0; }
+	std::string str() const { return std::string(data, length); }
+
+	bool operator==(const char* text) const
+	{
+		return strncmp(data, text, length) == 0 && text[length] == '\0';
+	}
+	bool operator!=(const char* text) const { return !(*this == text); }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const StringView& view)
+{
+	return os.write(view.data, view.length);
+}
+
+#endif
@@ -0,0 +1,107 @@
+#include <fstream>
+#include <sstream>
+
+#include "TextureAtlas.h"
+#include "AssetRegistry.h"
+#include "AssetStreamer.h"
+
+/******************************************************************************/
+/*!
+\brief
+The atlas holding the HUD, journal, dialogue and minigame images. Loaded on
+first use.
+*/
+/******************************************************************************/
+TextureAtlas& TextureAtlas::GetUI()
+{
+	static TextureAtlas atlas;
+	static bool loaded = atlas.Load("Image//ui_atlas.atlas");
+	(void)loaded;
+	return atlas;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Read a .atlas table. Page and region paths in it are relative to the table.
+
+\return false if the table could not be opened
+*/
+/******************************************************************************/
+bool TextureAtlas::Load(const std::string& table_path)
+{
+	pages.clear();
+	regions.clear();
+
+	std::ifstream file(table_path.c_str());
+	if (!file.is_open())
+		return false;
+
+	size_t slash = table_path.find_last_of("/\\");
+	std::string directory = slash == std::string::npos ? "" : table_path.substr(0, slash + 1);
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::istringstream stream(line);
+		std::string type, name;
+		stream >> type >> name;
+		if (type == "page")
+		{
+			pages.push_back(directory + name);
+		}
+		else if (type == "region")
+		{
+			Region region;
+			stream >> region.page >> region.u0 >> region.v0 >> region.u1 >> region.v1;
+			if (!stream.fail() && region.page < pages.size())
+				regions[AssetRegistry::MakeKey(directory + name)] = region;
+		}
+	}
+	return true;
+}
+
+//Path of the texture holding image_path: its atlas page, or the image itself
+std::string TextureAtlas::GetTexturePath(const std::string& image_path, const Region** out_region) const
+{
+	std::map<std::string, Region>::const_iterator it = regions.find(AssetRegistry::MakeKey(image_path));
+	if (it == regions.end())
+	{
+		*out_region = nullptr;
+		return image_path;
+	}
+	*out_region = &it->second;
+	return pages[it->second.page];
+}
+
+/******************************************************************************/
+/*!
+\brief
+Look up an image. Like LoadTGA, the returned texture holds a reference that
+the mesh it is assigned to releases.
+
+\param image_path - path the image would be passed to LoadTGA with
+*/
+/******************************************************************************/
+AtlasRegion TextureAtlas::AcquireRegion(const std::string& image_path) const
+{
+	const Region* region;
+	std::string texture_path = GetTexturePath(image_path, &region);
+
+	AtlasRegion result = { AssetRegistry::AcquireTexture(texture_path), 0.f, 0.f, 1.f, 1.f };
+	if (region != nullptr)
+	{
+		result.u0 = region->u0;
+		result.v0 = region->v0;
+		result.u1 = region->u1;
+		result.v1 = region->v1;
+	}
+	return result;
+}
+
+//Stream the texture an image lives in, for a scene's Preload
+void TextureAtlas::Request(const std::string& image_path) const
+{
+	const Region* region;
+	AssetStreamer::RequestTexture(GetTexturePath(image_path, &region));
+}
@@ -0,0 +1,53 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include <string>
+#include <vector>
+#include <map>
+
+/******************************************************************************/
+/*!
+		Struct AtlasRegion:
+\brief	A texture and the UV rectangle of one image inside it
+*/
+/******************************************************************************/
+struct AtlasRegion
+{
+	unsigned textureID;
+	float u0, v0;	//bottom left
+	float u1, v1;	//top right
+};
+
+/******************************************************************************/
+/*!
+		Class TextureAtlas:
+\brief	UV table written by "AssetCooker atlas". Images are looked up by the
+		path they would be loaded from with LoadTGA. Images missing from the
+		table (or a missing table) fall back to their own texture, so scenes
+		work before the atlas has been cooked.
+*/
+/******************************************************************************/
+class TextureAtlas
+{
+public:
+	static TextureAtlas& GetUI();
+
+	bool Load(const std::string& table_path);
+
+	AtlasRegion AcquireRegion(const std::string& image_path) const;
+	void Request(const std::string& image_path) const;
+
+private:
+	struct Region
+	{
+		unsigned page;
+		float u0, v0, u1, v1;
+	};
+
+	std::string GetTexturePath(const std::string& image_path, const Region** out_region) const;
+
+	std::vector<std::string> pages;
+	std::map<std::string, Region> regions;
+};
+
+#endif
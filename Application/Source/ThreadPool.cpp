@@ -0,0 +1,111 @@
+#include <atomic>
+#include <memory>
+
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned threadCount) : stopping(false)
+{
+	for (unsigned i = 0; i < threadCount; ++i)
+	{
+		workers.push_back(std::thread(&ThreadPool::WorkerLoop, this));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wakeUp.notify_all();
+	for (unsigned i = 0; i < workers.size(); ++i)
+	{
+		workers[i].join();
+	}
+}
+
+ThreadPool& ThreadPool::GetInstance()
+{
+	unsigned hardwareThreads = std::thread::hardware_concurrency();
+	static ThreadPool instance(hardwareThreads > 1 ? hardwareThreads - 1 : 1);
+	return instance;
+}
+
+void ThreadPool::Enqueue(const std::function<void()>& task)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		tasks.push_back(task);
+	}
+	wakeUp.notify_one();
+}
+
+/******************************************************************************/
+/*!
+\brief
+Run body(0) .. body(count - 1) across the workers and the calling thread and
+return once every call has finished. The caller claims items as well, so this
+completes even when called from a worker or when every worker is busy.
+*/
+/******************************************************************************/
+void ThreadPool::ParallelFor(unsigned count, const std::function<void(unsigned)>& body)
+{
+	struct Job
+	{
+		std::atomic<unsigned> next;
+		std::atomic<unsigned> done;
+		std::mutex mutex;
+		std::condition_variable finished;
+	};
+	std::shared_ptr<Job> job = std::make_shared<Job>();
+	job->next = 0;
+	job->done = 0;
+
+	std::function<void()> work = [job, count, &body]()
+	{
+		for (unsigned i = job->next++; i < count; i = job->next++)
+		{
+			body(i);
+			if (++job->done == count)
+			{
+				std::lock_guard<std::mutex> lock(job->mutex);
+				job->finished.notify_all();
+			}
+		}
+	};
+
+	unsigned helpers = count > 0 ? count - 1 : 0;
+	if (helpers > workers.size())
+		helpers = (unsigned)workers.size();
+	for (unsigned i = 0; i < helpers; ++i)
+	{
+		Enqueue(work);
+	}
+	work();
+
+	//helpers that start after every item was claimed never touch body
+	std::unique_lock<std::mutex> lock(job->mutex);
+	job->finished.wait(lock, [job, count]() { return job->done == count; });
+}
+
+unsigned ThreadPool::GetThreadCount() const
+{
+	return (unsigned)workers.size();
+}
+
+void ThreadPool::WorkerLoop()
+{
+	for (;;)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeUp.wait(lock, [this]() { return stopping || !tasks.empty(); });
+			if (stopping && tasks.empty())
+				return;
+			task = tasks.front();
+			tasks.pop_front();
+		}
+		task();
+	}
+}
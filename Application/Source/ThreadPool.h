@@ -0,0 +1,45 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+/******************************************************************************/
+/*!
+		Class ThreadPool:
+\brief	Fixed set of worker threads that run queued tasks. GetInstance() is
+		the pool shared by the loaders, sized to the machine's hardware
+		threads minus the main thread.
+*/
+/******************************************************************************/
+class ThreadPool
+{
+public:
+	explicit ThreadPool(unsigned threadCount);
+	~ThreadPool();
+
+	static ThreadPool& GetInstance();
+
+	void Enqueue(const std::function<void()>& task);
+	void ParallelFor(unsigned count, const std::function<void(unsigned)>& body);
+
+	unsigned GetThreadCount() const;
+
+private:
+	ThreadPool(const ThreadPool&);
+	ThreadPool& operator=(const ThreadPool&);
+
+	void WorkerLoop();
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	bool stopping;
+};
+
+#endif
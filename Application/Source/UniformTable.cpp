@@ -0,0 +1,155 @@
+#include <cstdlib>
+#include <GL\glew.h>
+
+#include "UniformTable.h"
+
+std::map<unsigned, UniformTable> UniformTable::tables;
+
+//GLSL member names of Light, in LIGHT_FIELD order
+static const char* LIGHT_FIELD_NAMES[UniformTable::LIGHT_FIELD_TOTAL] =
+{
+	"position_cameraspace",
+	"color",
+	"power",
+	"kC",
+	"kL",
+	"kQ",
+	"type",
+	"spotDirection",
+	"cosCutoff",
+	"cosInner",
+	"exponent",
+};
+
+/******************************************************************************/
+/*!
+\brief
+Return the table of a linked program, reflecting it on first use
+*/
+/******************************************************************************/
+const UniformTable& UniformTable::Get(unsigned programID)
+{
+	std::map<unsigned, UniformTable>::iterator it = tables.find(programID);
+	if (it != tables.end())
+		return it->second;
+
+	UniformTable& table = tables[programID];
+	table.Build(programID);
+	return table;
+}
+
+//Forget every table. Called when the programs they describe are deleted.
+void UniformTable::Clear()
+{
+	tables.clear();
+}
+
+void UniformTable::Build(unsigned programID)
+{
+	GLint count = 0, maxLength = 0;
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	std::vector<char> buffer(maxLength + 1);
+
+	for (GLint i = 0; i < count; ++i)
+	{
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(programID, i, maxLength + 1, &length, &size, &type, &buffer[0]);
+		std::string name(&buffer[0], length);
+
+		Uniform uniform = { glGetUniformLocation(programID, name.c_str()), type, size };
+		uniforms[name] = uniform;
+
+		//arrays are reported as "name[0]"; also file them under "name" and each element
+		if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+		{
+			std::string base = name.substr(0, name.size() - 3);
+			uniforms[base] = uniform;
+			for (GLint element = 1; element < size; ++element)
+			{
+				std::string elementName = base + "[" + std::to_string(element) + "]";
+				Uniform elementUniform = { glGetUniformLocation(programID, elementName.c_str()), type, 1 };
+				uniforms[elementName] = elementUniform;
+			}
+		}
+
+		//"lights[<index>].<field>"
+		if (name.compare(0, 7, "lights[") != 0)
+			continue;
+		char* end = nullptr;
+		unsigned index = strtoul(name.c_str() + 7, &end, 10);
+		if (end[0] != ']' || end[1] != '.')
+			continue;
+		std::string field = end + 2;
+		for (unsigned f = 0; f < LIGHT_FIELD_TOTAL; ++f)
+		{
+			if (field != LIGHT_FIELD_NAMES[f])
+				continue;
+			if (lightLocations.size() < (index + 1) * LIGHT_FIELD_TOTAL)
+				lightLocations.resize((index + 1) * LIGHT_FIELD_TOTAL, -1);
+			lightLocations[index * LIGHT_FIELD_TOTAL + f] = uniform.location;
+		}
+	}
+}
+
+//Null if the program has no active uniform of that name
+const UniformTable::Uniform* UniformTable::Find(const std::string& name) const
+{
+	std::map<std::string, Uniform>::const_iterator it = uniforms.find(name);
+	return it == uniforms.end() ? nullptr : &it->second;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Location of a uniform, or -1 (which glUniform* ignores) if it is not active
+*/
+/******************************************************************************/
+int UniformTable::GetLocation(const std::string& name) const
+{
+	const Uniform* uniform = Find(name);
+	return uniform ? uniform->location : -1;
+}
+
+//Number of lights with at least one active field
+unsigned UniformTable::GetLightCount() const
+{
+	return (unsigned)lightLocations.size() / LIGHT_FIELD_TOTAL;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Location of lights[index].field, or -1 if the shader does not use it
+*/
+/******************************************************************************/
+int UniformTable::GetLight(unsigned index, LIGHT_FIELD field) const
+{
+	if (index >= GetLightCount())
+		return -1;
+	return lightLocations[index * LIGHT_FIELD_TOTAL + field];
+}
+
+/******************************************************************************/
+/*!
+\brief
+Upload the parts of a light that do not depend on the camera. Position and
+spot direction are set each frame in camera space. The program must be in use.
+*/
+/******************************************************************************/
+void UniformTable::SetLight(unsigned index, const Light& light) const
+{
+	glUniform1i(GetLight(index, LIGHT_TYPE), light.type);
+	glUniform3fv(GetLight(index, LIGHT_COLOR), 1, &light.color.r);
+	glUniform1f(GetLight(index, LIGHT_POWER), light.power);
+
+	glUniform1f(GetLight(index, LIGHT_KC), light.kC);
+	glUniform1f(GetLight(index, LIGHT_KL), light.kL);
+	glUniform1f(GetLight(index, LIGHT_KQ), light.kQ);
+
+	glUniform1f(GetLight(index, LIGHT_COSCUTOFF), light.cosCutoff);
+	glUniform1f(GetLight(index, LIGHT_COSINNER), light.cosInner);
+	glUniform1f(GetLight(index, LIGHT_EXPONENT), light.exponent);
+}
@@ -0,0 +1,64 @@
+#ifndef UNIFORM_TABLE_H
+#define UNIFORM_TABLE_H
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "Light.h"
+
+/******************************************************************************/
+/*!
+		Class UniformTable:
+\brief	Locations and types of every active uniform of a program, read once
+		with glGetActiveUniform. Tables are cached per program, so scenes
+		sharing a program (see LoadShaders) share its table. Members of the
+		"lights" struct array are also indexed by light and field.
+*/
+/******************************************************************************/
+class UniformTable
+{
+public:
+	enum LIGHT_FIELD
+	{
+		LIGHT_POSITION = 0,
+		LIGHT_COLOR,
+		LIGHT_POWER,
+		LIGHT_KC,
+		LIGHT_KL,
+		LIGHT_KQ,
+		LIGHT_TYPE,
+		LIGHT_SPOTDIRECTION,
+		LIGHT_COSCUTOFF,
+		LIGHT_COSINNER,
+		LIGHT_EXPONENT,
+		LIGHT_FIELD_TOTAL,
+	};
+
+	struct Uniform
+	{
+		int location;
+		unsigned type;	//GL_FLOAT_VEC3, GL_SAMPLER_2D, ...
+		int size;		//array length, 1 for plain uniforms
+	};
+
+	static const UniformTable& Get(unsigned programID);
+	static void Clear();
+
+	const Uniform* Find(const std::string& name) const;
+	int GetLocation(const std::string& name) const;
+
+	unsigned GetLightCount() const;
+	int GetLight(unsigned index, LIGHT_FIELD field) const;
+	void SetLight(unsigned index, const Light& light) const;
+
+private:
+	void Build(unsigned programID);
+
+	std::map<std::string, Uniform> uniforms;
+	std::vector<int> lightLocations; //LIGHT_FIELD_TOTAL per light
+
+	static std::map<unsigned, UniformTable> tables;
+};
+
+#endif
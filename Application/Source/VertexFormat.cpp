@@ -0,0 +1,177 @@
+#include <cstring>
+#include <cmath>
+#include <GL\glew.h>
+
+#include "VertexFormat.h"
+
+//Half floats keep 11 significant bits, about a texel of a 1024 texture up to here
+static const float HALF_TEXCOORD_LIMIT = 2.f;
+
+static const VertexFormat formats[VertexFormat::FORMAT_TOTAL] =
+{
+	//FORMAT_FLOAT
+	{
+		sizeof(Vertex),
+		{
+			{ 3, GL_FLOAT, false, 0 },
+			{ 3, GL_FLOAT, false, sizeof(Position) },
+			{ 3, GL_FLOAT, false, sizeof(Position) + sizeof(Color) },
+			{ 2, GL_FLOAT, false, sizeof(Position) + sizeof(Color) + sizeof(Vector3) },
+		}
+	},
+	//FORMAT_PACKED
+	{
+		20,
+		{
+			{ 3, GL_FLOAT, false, 0 },
+			{ 0, GL_FLOAT, false, 0 },
+			{ 4, GL_INT_2_10_10_10_REV, true, 12 },
+			{ 2, GL_HALF_FLOAT, false, 16 },
+		}
+	},
+	//FORMAT_PACKED_COLOR
+	{
+		24,
+		{
+			{ 3, GL_FLOAT, false, 0 },
+			{ 4, GL_UNSIGNED_BYTE, true, 20 },
+			{ 4, GL_INT_2_10_10_10_REV, true, 12 },
+			{ 2, GL_HALF_FLOAT, false, 16 },
+		}
+	},
+};
+
+static unsigned short FloatToHalf(float value)
+{
+	unsigned bits;
+	memcpy(&bits, &value, sizeof(bits));
+	unsigned short sign = (unsigned short)((bits >> 16) & 0x8000);
+	int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+	unsigned mantissa = bits & 0x7FFFFF;
+
+	if (exponent <= 0)
+	{
+		//too small for a normal half, keep what fits of a subnormal
+		if (exponent < -10)
+			return sign;
+		mantissa |= 0x800000;
+		unsigned shift = 14 - exponent;
+		unsigned half = mantissa >> shift;
+		if ((mantissa >> (shift - 1)) & 1)
+			++half;
+		return (unsigned short)(sign | half);
+	}
+	if (exponent >= 31)
+		return (unsigned short)(sign | 0x7C00);
+
+	//rounding may carry into the exponent, which is still the right result
+	unsigned half = sign | (exponent << 10) | (mantissa >> 13);
+	if (mantissa & 0x1000)
+		++half;
+	return (unsigned short)half;
+}
+
+static unsigned PackSnorm10(float value)
+{
+	value = value < -1.f ? -1.f : (value > 1.f ? 1.f : value);
+	return (unsigned)(int)floorf(value * 511.f + 0.5f) & 0x3FF;
+}
+
+static unsigned char PackUnorm8(float value)
+{
+	value = value < 0.f ? 0.f : (value > 1.f ? 1.f : value);
+	return (unsigned char)(value * 255.f + 0.5f);
+}
+
+const VertexFormat& VertexFormat::Get(TYPE type)
+{
+	return formats[type];
+}
+
+/******************************************************************************/
+/*!
+\brief
+Smallest format that keeps a mesh looking the same: FORMAT_PACKED if every
+vertex is white, FORMAT_PACKED_COLOR otherwise, and FORMAT_FLOAT if the UVs
+tile too far for half floats.
+*/
+/******************************************************************************/
+VertexFormat::TYPE VertexFormat::ChooseCompact(const std::vector<Vertex>& vertices)
+{
+	bool white = true;
+	for (size_t i = 0; i < vertices.size(); ++i)
+	{
+		const Vertex& vertex = vertices[i];
+		if (fabsf(vertex.texCoord.u) > HALF_TEXCOORD_LIMIT || fabsf(vertex.texCoord.v) > HALF_TEXCOORD_LIMIT)
+			return FORMAT_FLOAT;
+		white = white && vertex.color.r == 1.f && vertex.color.g == 1.f && vertex.color.b == 1.f;
+	}
+	return white ? FORMAT_PACKED : FORMAT_PACKED_COLOR;
+}
+
+bool VertexFormat::Has(ATTRIBUTE attribute) const
+{
+	return attributes[attribute].size > 0;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Point the shader inputs at the bound GL_ARRAY_BUFFER. Called once per mesh
+with its VAO bound.
+*/
+/******************************************************************************/
+void VertexFormat::Apply() const
+{
+	for (unsigned i = 0; i < ATTRIBUTE_TOTAL; ++i)
+	{
+		const VertexAttribute& attribute = attributes[i];
+		if (attribute.size == 0)
+		{
+			glDisableVertexAttribArray(i);
+			continue;
+		}
+		glEnableVertexAttribArray(i);
+		glVertexAttribPointer(i, attribute.size, attribute.type, attribute.normalized, stride, (void*)(size_t)attribute.offset);
+	}
+}
+
+/******************************************************************************/
+/*!
+\brief
+Convert vertices into this format
+
+\param out_data - receives count * stride bytes
+*/
+/******************************************************************************/
+void VertexFormat::Encode(const Vertex* vertices, size_t count, void* out_data) const
+{
+	if (stride == sizeof(Vertex))
+	{
+		memcpy(out_data, vertices, count * sizeof(Vertex));
+		return;
+	}
+
+	unsigned char* out = (unsigned char*)out_data;
+	memset(out, 0, count * stride);
+	for (size_t i = 0; i < count; ++i, out += stride)
+	{
+		const Vertex& vertex = vertices[i];
+		memcpy(out + attributes[ATTRIBUTE_POSITION].offset, &vertex.pos, sizeof(Position));
+
+		if (Has(ATTRIBUTE_COLOR))
+		{
+			unsigned char* color = out + attributes[ATTRIBUTE_COLOR].offset;
+			color[0] = PackUnorm8(vertex.color.r);
+			color[1] = PackUnorm8(vertex.color.g);
+			color[2] = PackUnorm8(vertex.color.b);
+			color[3] = 255;
+		}
+
+		unsigned normal = PackSnorm10(vertex.normal.x) | (PackSnorm10(vertex.normal.y) << 10) | (PackSnorm10(vertex.normal.z) << 20);
+		memcpy(out + attributes[ATTRIBUTE_NORMAL].offset, &normal, sizeof(normal));
+
+		unsigned short texCoord[2] = { FloatToHalf(vertex.texCoord.u), FloatToHalf(vertex.texCoord.v) };
+		memcpy(out + attributes[ATTRIBUTE_TEXCOORD].offset, texCoord, sizeof(texCoord));
+	}
+}
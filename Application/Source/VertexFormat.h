@@ -0,0 +1,66 @@
+#ifndef VERTEX_FORMAT_H
+#define VERTEX_FORMAT_H
+
+#include <vector>
+#include "Vertex.h"
+
+/******************************************************************************/
+/*!
+		Struct VertexAttribute:
+\brief	Where and how one shader input is stored in a vertex buffer
+*/
+/******************************************************************************/
+struct VertexAttribute
+{
+	int size;			//components, 0 if the attribute is not stored
+	unsigned type;		//GL_FLOAT, GL_HALF_FLOAT, GL_INT_2_10_10_10_REV or GL_UNSIGNED_BYTE
+	bool normalized;
+	unsigned offset;
+};
+
+/******************************************************************************/
+/*!
+		Class VertexFormat:
+\brief	Vertex buffer layouts a mesh can be uploaded in. Vertices are always
+		built as Vertex and encoded into the mesh's format on upload (or when
+		cooked). Attributes missing from a format read a constant instead:
+		white for the color.
+
+		FORMAT_FLOAT			44 bytes, Vertex as is
+		FORMAT_PACKED			20 bytes, float position, 10:10:10:2 normal, half UV
+		FORMAT_PACKED_COLOR		24 bytes, FORMAT_PACKED plus an RGBA8 color
+*/
+/******************************************************************************/
+class VertexFormat
+{
+public:
+	enum TYPE
+	{
+		FORMAT_FLOAT = 0,
+		FORMAT_PACKED,
+		FORMAT_PACKED_COLOR,
+		FORMAT_TOTAL,
+	};
+
+	//shader input locations, see Texture.vertexshader
+	enum ATTRIBUTE
+	{
+		ATTRIBUTE_POSITION = 0,
+		ATTRIBUTE_COLOR,
+		ATTRIBUTE_NORMAL,
+		ATTRIBUTE_TEXCOORD,
+		ATTRIBUTE_TOTAL,
+	};
+
+	static const VertexFormat& Get(TYPE type);
+	static TYPE ChooseCompact(const std::vector<Vertex>& vertices);
+
+	bool Has(ATTRIBUTE attribute) const;
+	void Apply() const;
+	void Encode(const Vertex* vertices, size_t count, void* out_data) const;
+
+	unsigned stride;
+	VertexAttribute attributes[ATTRIBUTE_TOTAL];
+};
+
+#endif
@@ -1,11 +1,19 @@
 
 
 #include "Application.h"
+#ifdef SP2_BENCHMARK
+#include "Benchmark.h"
+#endif
 
 int main( void )
 {
+#ifdef SP2_BENCHMARK
+	RunMeshLoadBenchmark();
+	RunDrawCallBenchmark();
+	return 0;
+#endif
 	Application app;
 	app.Init();
 	app.Run();
 	app.Exit();
-}
\ No newline at end of file
+}
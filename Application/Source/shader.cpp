@@ -1,8 +1,11 @@
 #include <stdio.h>
 #include <string>
 #include <vector>
+#include <map>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <iomanip>
 #include <algorithm>
 using namespace std;
 
@@ -12,38 +15,162 @@ using namespace std;
 #include <GL/glew.h>
 
 #include "shader.hpp"
+#include "UniformTable.h"
+#include "Mesh.h"
 
-GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path){
+static const unsigned PROGRAM_BINARY_MAGIC = 0x50325053; //"SP2P"
+static const unsigned PROGRAM_BINARY_VERSION = 1;
 
-	// Create the shaders
-	GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
-	GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
+/******************************************************************************/
+/*!
+		Struct ProgramBinaryHeader:
+\brief	Start of a Shader//<hash>.program file. driverHash identifies the GL
+		implementation that wrote the binary; binaries from any other driver
+		are ignored and recompiled.
+*/
+/******************************************************************************/
+struct ProgramBinaryHeader
+{
+	unsigned magic;
+	unsigned version;
+	unsigned long long driverHash;
+	unsigned format;
+	unsigned length;
+};
 
-	// Read the Vertex Shader code from the file
-	std::string VertexShaderCode;
-	std::ifstream VertexShaderStream(vertex_file_path, std::ios::in);
-	if(VertexShaderStream.is_open()){
-		std::string Line = "";
-		while(getline(VertexShaderStream, Line))
-			VertexShaderCode += "\n" + Line;
-		VertexShaderStream.close();
-	}else{
-		printf("Impossible to open %s. Are you in the right directory ? Don't forget to read the FAQ !\n", vertex_file_path);
-		getchar();
-		return 0;
+//linked programs by hash of their sources, shared by every scene
+static std::map<unsigned long long, GLuint> programs;
+
+static unsigned long long HashBytes(const char* data, size_t size, unsigned long long hash = 14695981039346656037ULL)
+{
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= (unsigned char)data[i];
+		hash *= 1099511628211ULL;
 	}
+	return hash;
+}
 
-	// Read the Fragment Shader code from the file
-	std::string FragmentShaderCode;
-	std::ifstream FragmentShaderStream(fragment_file_path, std::ios::in);
-	if(FragmentShaderStream.is_open()){
-		std::string Line = "";
-		while(getline(FragmentShaderStream, Line))
-			FragmentShaderCode += "\n" + Line;
-		FragmentShaderStream.close();
+static unsigned long long HashString(const char* text, unsigned long long hash = 14695981039346656037ULL)
+{
+	return HashBytes(text, text ? strlen(text) : 0, hash);
+}
+
+//Read the whole file in one go
+static bool ReadShaderFile(const char* file_path, std::string& out_code)
+{
+	std::ifstream fileStream(file_path, std::ios::in | std::ios::binary);
+	if (!fileStream.is_open())
+		return false;
+	std::ostringstream code;
+	code << fileStream.rdbuf();
+	out_code = code.str();
+	return true;
+}
+
+static std::string GetProgramBinaryPath(unsigned long long sourceHash)
+{
+	std::ostringstream path;
+	path << "Shader//" << std::hex << std::setw(16) << std::setfill('0') << sourceHash << ".program";
+	return path.str();
+}
+
+static bool IsProgramBinarySupported()
+{
+	if (!GLEW_ARB_get_program_binary)
+		return false;
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	return formatCount > 0;
+}
+
+static unsigned long long GetDriverHash()
+{
+	unsigned long long hash = HashString((const char*)glGetString(GL_VENDOR));
+	hash = HashString((const char*)glGetString(GL_RENDERER), hash);
+	return HashString((const char*)glGetString(GL_VERSION), hash);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Create a program from a binary saved by an earlier run
+
+\return the linked program, or 0 if there is no usable binary
+*/
+/******************************************************************************/
+static GLuint LoadProgramBinary(unsigned long long sourceHash)
+{
+	std::ifstream fileStream(GetProgramBinaryPath(sourceHash).c_str(), std::ios::binary);
+	if (!fileStream.is_open())
+		return 0;
+
+	ProgramBinaryHeader header;
+	fileStream.read((char*)&header, sizeof(header));
+	if (!fileStream || header.magic != PROGRAM_BINARY_MAGIC || header.version != PROGRAM_BINARY_VERSION ||
+		header.driverHash != GetDriverHash() || header.length == 0)
+		return 0;
+
+	std::vector<char> binary(header.length);
+	fileStream.read(&binary[0], header.length);
+	if (!fileStream)
+		return 0;
+
+	GLuint ProgramID = glCreateProgram();
+	glProgramBinary(ProgramID, header.format, &binary[0], header.length);
+
+	//the driver may still refuse it, e.g. after an update that kept the version string
+	GLint Result = GL_FALSE;
+	glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
+	if (Result != GL_TRUE)
+	{
+		glDeleteProgram(ProgramID);
+		return 0;
 	}
+	return ProgramID;
+}
 
+static void SaveProgramBinary(GLuint ProgramID, unsigned long long sourceHash)
+{
+	GLint length = 0;
+	glGetProgramiv(ProgramID, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
 
+	ProgramBinaryHeader header;
+	header.magic = PROGRAM_BINARY_MAGIC;
+	header.version = PROGRAM_BINARY_VERSION;
+	header.driverHash = GetDriverHash();
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(ProgramID, length, &length, &format, &binary[0]);
+	header.format = format;
+	header.length = (unsigned)length;
+
+	std::string binary_path = GetProgramBinaryPath(sourceHash);
+	std::string temp_path = binary_path + ".tmp";
+	std::ofstream fileStream(temp_path.c_str(), std::ios::binary | std::ios::trunc);
+	if (!fileStream.is_open())
+		return;
+	fileStream.write((const char*)&header, sizeof(header));
+	fileStream.write(&binary[0], length);
+	bool success = fileStream.good();
+	fileStream.close();
+	if (!success)
+	{
+		remove(temp_path.c_str());
+		return;
+	}
+	remove(binary_path.c_str()); //rename does not overwrite on Windows
+	rename(temp_path.c_str(), binary_path.c_str());
+}
+
+static GLuint CompileProgram(const char * vertex_file_path, const std::string& VertexShaderCode,
+	const char * fragment_file_path, const std::string& FragmentShaderCode, bool retrievable)
+{
+	// Create the shaders
+	GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
+	GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
 
 	GLint Result = GL_FALSE;
 	int InfoLogLength;
@@ -89,6 +216,8 @@ GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path
 	GLuint ProgramID = glCreateProgram();
 	glAttachShader(ProgramID, VertexShaderID);
 	glAttachShader(ProgramID, FragmentShaderID);
+	if (retrievable)
+		glProgramParameteri(ProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glLinkProgram(ProgramID);
 
 	// Check the program
@@ -100,10 +229,77 @@ GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path
 		printf("%s\n", &ProgramErrorMessage[0]);
 	}
 
+	glDetachShader(ProgramID, VertexShaderID);
+	glDetachShader(ProgramID, FragmentShaderID);
 	glDeleteShader(VertexShaderID);
 	glDeleteShader(FragmentShaderID);
 
 	return ProgramID;
 }
 
+/******************************************************************************/
+/*!
+\brief
+Return the program built from a vertex and fragment shader. Programs are
+cached by a hash of their source, so every scene using the same shaders
+shares one program, and scenes must not delete it. When the driver supports
+program binaries the linked program is also saved to Shader//<hash>.program
+and reloaded on later runs without compiling any GLSL.
+*/
+/******************************************************************************/
+GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path){
+
+	// Read the shader code from the files
+	std::string VertexShaderCode;
+	if (!ReadShaderFile(vertex_file_path, VertexShaderCode)) {
+		printf("Impossible to open %s. Are you in the right directory ? Don't forget to read the FAQ !\n", vertex_file_path);
+		getchar();
+		return 0;
+	}
+	std::string FragmentShaderCode;
+	ReadShaderFile(fragment_file_path, FragmentShaderCode);
+
+	//the separator keeps "ab"+"c" and "a"+"bc" apart
+	unsigned long long sourceHash = HashBytes(VertexShaderCode.c_str(), VertexShaderCode.size() + 1);
+	sourceHash = HashBytes(FragmentShaderCode.c_str(), FragmentShaderCode.size(), sourceHash);
+
+	std::map<unsigned long long, GLuint>::iterator it = programs.find(sourceHash);
+	if (it != programs.end())
+		return it->second;
 
+	bool binarySupported = IsProgramBinarySupported();
+	GLuint ProgramID = binarySupported ? LoadProgramBinary(sourceHash) : 0;
+	if (ProgramID == 0)
+	{
+		ProgramID = CompileProgram(vertex_file_path, VertexShaderCode, fragment_file_path, FragmentShaderCode, binarySupported);
+
+		GLint Result = GL_FALSE;
+		glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
+		if (Result == GL_TRUE && binarySupported)
+			SaveProgramBinary(ProgramID, sourceHash);
+	}
+
+	//Mesh binds materials to a fixed point rather than per program
+	GLuint materialBlock = glGetUniformBlockIndex(ProgramID, "MeshMaterials");
+	if (materialBlock != GL_INVALID_INDEX)
+		glUniformBlockBinding(ProgramID, materialBlock, Mesh::MATERIAL_BLOCK_BINDING);
+
+	programs[sourceHash] = ProgramID;
+	return ProgramID;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Delete every cached program. Call before the GL context is destroyed.
+*/
+/******************************************************************************/
+void ClearShaderCache()
+{
+	for (std::map<unsigned long long, GLuint>::iterator it = programs.begin(); it != programs.end(); ++it)
+	{
+		glDeleteProgram(it->second);
+	}
+	programs.clear();
+	UniformTable::Clear();
+}
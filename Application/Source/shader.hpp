@@ -2,5 +2,6 @@
 #define SHADER_HPP
 
 GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path);
+void ClearShaderCache();
 
 #endif
@@ -0,0 +1,220 @@
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+
+#include "AtlasCooker.h"
+#include "TextureCooker.h"
+#include "CookerUtility.h"
+
+static const unsigned PAGE_SIZE = 2048;
+//border of repeated edge pixels around each image, so filtering never reads a neighbour
+static const unsigned PADDING = 4;
+//cells start on 4 pixel boundaries so DXT blocks never straddle two images
+static const unsigned CELL_ALIGN = 4;
+
+struct AtlasCell
+{
+	std::string name;
+	CookImage image;
+	unsigned width, height; //padded size
+	unsigned page, x, y;
+};
+
+struct AtlasShelf
+{
+	unsigned page, y, height, used;
+};
+
+static unsigned RoundUp(unsigned value, unsigned multiple)
+{
+	return (value + multiple - 1) / multiple * multiple;
+}
+
+static unsigned NextPowerOfTwo(unsigned value)
+{
+	unsigned result = 1;
+	while (result < value)
+		result *= 2;
+	return result;
+}
+
+static bool ReadList(const std::string& list_path, std::vector<std::string>& out_names)
+{
+	std::vector<unsigned char> file;
+	if (!ReadWholeFile(list_path, file))
+	{
+		std::cout << "Impossible to open " << list_path << "\n";
+		return false;
+	}
+
+	std::istringstream stream(std::string(file.begin(), file.end()));
+	std::string line;
+	while (std::getline(stream, line))
+	{
+		size_t first = line.find_first_not_of(" \t\r");
+		if (first == std::string::npos || line[first] == '#')
+			continue;
+		size_t last = line.find_last_not_of(" \t\r");
+		out_names.push_back(line.substr(first, last - first + 1));
+	}
+	return true;
+}
+
+//Shelf packing: tallest cells first, each into the first shelf with room
+static bool PackCells(std::vector<AtlasCell*>& cells, unsigned& out_pageCount)
+{
+	std::stable_sort(cells.begin(), cells.end(), [](const AtlasCell* a, const AtlasCell* b)
+	{
+		return a->height > b->height;
+	});
+
+	std::vector<AtlasShelf> shelves;
+	std::vector<unsigned> pageHeights;
+	for (size_t i = 0; i < cells.size(); ++i)
+	{
+		AtlasCell& cell = *cells[i];
+		if (cell.width > PAGE_SIZE || cell.height > PAGE_SIZE)
+		{
+			std::cout << cell.name << " is too large for a " << PAGE_SIZE << " atlas page\n";
+			return false;
+		}
+
+		AtlasShelf* shelf = nullptr;
+		for (size_t s = 0; s < shelves.size() && shelf == nullptr; ++s)
+		{
+			if (shelves[s].height >= cell.height && shelves[s].used + cell.width <= PAGE_SIZE)
+				shelf = &shelves[s];
+		}
+		if (shelf == nullptr)
+		{
+			if (pageHeights.empty() || pageHeights.back() + cell.height > PAGE_SIZE)
+				pageHeights.push_back(0);
+			AtlasShelf newShelf = { (unsigned)pageHeights.size() - 1, pageHeights.back(), cell.height, 0 };
+			pageHeights.back() += cell.height;
+			shelves.push_back(newShelf);
+			shelf = &shelves.back();
+		}
+
+		cell.page = shelf->page;
+		cell.x = shelf->used;
+		cell.y = shelf->y;
+		shelf->used += cell.width;
+	}
+	out_pageCount = (unsigned)pageHeights.size();
+	return true;
+}
+
+//Copy a cell's image into its page, repeating the edge pixels into the padding
+static void BlitCell(const AtlasCell& cell, CookImage& page)
+{
+	const CookImage& image = cell.image;
+	for (unsigned y = 0; y < image.height + 2 * PADDING; ++y)
+	{
+		int sourceY = std::min(std::max((int)y - (int)PADDING, 0), (int)image.height - 1);
+		for (unsigned x = 0; x < image.width + 2 * PADDING; ++x)
+		{
+			int sourceX = std::min(std::max((int)x - (int)PADDING, 0), (int)image.width - 1);
+			const unsigned char* source = &image.rgba[(sourceY * image.width + sourceX) * 4];
+			unsigned char* destination = &page.rgba[((cell.y + y) * page.width + cell.x + x) * 4];
+			std::copy(source, source + 4, destination);
+		}
+	}
+}
+
+int CookAtlas(const std::string& list_path, bool force)
+{
+	std::vector<std::string> names;
+	if (!ReadList(list_path, names))
+		return 1;
+
+	size_t slash = list_path.find_last_of("/\\");
+	std::string directory = slash == std::string::npos ? "" : list_path.substr(0, slash + 1);
+	std::string base = ReplaceExtension(list_path, "");
+	std::string table_path = base + ".atlas";
+
+	bool outOfDate = force || IsOutOfDate(table_path, list_path);
+	for (size_t i = 0; i < names.size() && !outOfDate; ++i)
+	{
+		outOfDate = IsOutOfDate(table_path, directory + names[i]);
+	}
+	if (!outOfDate)
+		return 0;
+
+	int failed = 0;
+	std::vector<AtlasCell> cells(names.size());
+	std::vector<AtlasCell*> packed;
+	for (size_t i = 0; i < names.size(); ++i)
+	{
+		AtlasCell& cell = cells[i];
+		cell.name = names[i];
+		if (!ReadTGA(directory + names[i], cell.image))
+		{
+			++failed;
+			continue;
+		}
+		cell.width = RoundUp(cell.image.width + 2 * PADDING, CELL_ALIGN);
+		cell.height = RoundUp(cell.image.height + 2 * PADDING, CELL_ALIGN);
+		packed.push_back(&cell);
+	}
+
+	unsigned pageCount = 0;
+	if (!PackCells(packed, pageCount))
+		return failed + 1;
+
+	std::vector<CookImage> pages(pageCount);
+	for (unsigned p = 0; p < pageCount; ++p)
+	{
+		unsigned width = 1, height = 1;
+		for (size_t i = 0; i < packed.size(); ++i)
+		{
+			if (packed[i]->page != p)
+				continue;
+			width = std::max(width, packed[i]->x + packed[i]->width);
+			height = std::max(height, packed[i]->y + packed[i]->height);
+		}
+		pages[p].width = NextPowerOfTwo(width);
+		pages[p].height = NextPowerOfTwo(height);
+		pages[p].rgba.assign(pages[p].width * pages[p].height * 4, 0);
+	}
+
+	std::ostringstream table;
+	table.precision(8);
+	table << "# generated by AssetCooker from " << list_path.substr(slash + 1) << "\n";
+	for (unsigned p = 0; p < pageCount; ++p)
+	{
+		std::ostringstream page_path;
+		page_path << base << "_" << p << ".tga";
+		table << "page " << page_path.str().substr(slash + 1) << "\n";
+	}
+	for (size_t i = 0; i < cells.size(); ++i)
+	{
+		const AtlasCell& cell = cells[i];
+		if (cell.image.rgba.empty())
+			continue;
+		CookImage& page = pages[cell.page];
+		BlitCell(cell, page);
+		table << "region " << cell.name << " " << cell.page << " "
+			<< (float)(cell.x + PADDING) / page.width << " "
+			<< (float)(cell.y + PADDING) / page.height << " "
+			<< (float)(cell.x + PADDING + cell.image.width) / page.width << " "
+			<< (float)(cell.y + PADDING + cell.image.height) / page.height << "\n";
+	}
+
+	for (unsigned p = 0; p < pageCount; ++p)
+	{
+		std::ostringstream page_path;
+		page_path << base << "_" << p << ".tga";
+		if (!WriteTGA(page_path.str(), pages[p]))
+			return failed + 1;
+		std::cout << list_path << " -> " << page_path.str() << " (" << pages[p].width << "x" << pages[p].height << ")\n";
+	}
+
+	std::string text = table.str();
+	if (!WriteWholeFile(table_path, text.c_str(), text.size()))
+	{
+		std::cout << "Could not write " << table_path << "\n";
+		return failed + 1;
+	}
+	std::cout << list_path << " -> " << table_path << " (" << packed.size() << " images, " << pageCount << " pages)\n";
+	return failed;
+}
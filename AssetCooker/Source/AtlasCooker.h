@@ -0,0 +1,19 @@
+#ifndef ATLAS_COOKER_H
+#define ATLAS_COOKER_H
+
+#include <string>
+
+/******************************************************************************/
+/*!
+\brief
+Pack the TGAs named in a list file (one path per line, relative to the list)
+into atlas pages. For list "Image/ui_atlas.txt" this writes
+Image/ui_atlas_0.tga, Image/ui_atlas_1.tga, ... and the UV table
+Image/ui_atlas.atlas read by TextureAtlas at runtime.
+
+\return number of images that failed to pack
+*/
+/******************************************************************************/
+int CookAtlas(const std::string& list_path, bool force);
+
+#endif
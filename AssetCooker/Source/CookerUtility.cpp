@@ -0,0 +1,121 @@
+#include <cstdio>
+#include <cctype>
+#include <algorithm>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+#include "CookerUtility.h"
+
+static bool EndsWith(const std::string& name, const std::string& extension)
+{
+	if (name.size() < extension.size())
+		return false;
+	for (size_t i = 0; i < extension.size(); ++i)
+	{
+		if (tolower(name[name.size() - extension.size() + i]) != tolower(extension[i]))
+			return false;
+	}
+	return true;
+}
+
+void ListFiles(const std::string& directory, const std::string& extension, std::vector<std::string>& out_files)
+{
+	std::vector<std::string> subdirectories;
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+	HANDLE find = FindFirstFileA((directory + "\\*").c_str(), &data);
+	if (find == INVALID_HANDLE_VALUE)
+		return;
+	do
+	{
+		std::string name = data.cFileName;
+		if (name == "." || name == "..")
+			continue;
+		if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			subdirectories.push_back(directory + "/" + name);
+		else if (EndsWith(name, extension))
+			out_files.push_back(directory + "/" + name);
+	} while (FindNextFileA(find, &data));
+	FindClose(find);
+#else
+	DIR* dir = opendir(directory.c_str());
+	if (dir == nullptr)
+		return;
+	while (dirent* entry = readdir(dir))
+	{
+		std::string name = entry->d_name;
+		if (name == "." || name == "..")
+			continue;
+		std::string path = directory + "/" + name;
+		struct stat info;
+		if (stat(path.c_str(), &info) != 0)
+			continue;
+		if (S_ISDIR(info.st_mode))
+			subdirectories.push_back(path);
+		else if (EndsWith(name, extension))
+			out_files.push_back(path);
+	}
+	closedir(dir);
+#endif
+	std::sort(out_files.begin(), out_files.end());
+	for (size_t i = 0; i < subdirectories.size(); ++i)
+	{
+		ListFiles(subdirectories[i], extension, out_files);
+	}
+}
+
+std::string ReplaceExtension(const std::string& file_path, const std::string& extension)
+{
+	size_t dot = file_path.find_last_of('.');
+	size_t slash = file_path.find_last_of("/\\");
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+		return file_path + extension;
+	return file_path.substr(0, dot) + extension;
+}
+
+bool IsOutOfDate(const std::string& output_path, const std::string& input_path)
+{
+	struct stat outputInfo, inputInfo;
+	if (stat(output_path.c_str(), &outputInfo) != 0)
+		return true;
+	if (stat(input_path.c_str(), &inputInfo) != 0)
+		return false;
+	return outputInfo.st_mtime < inputInfo.st_mtime;
+}
+
+bool ReadWholeFile(const std::string& file_path, std::vector<unsigned char>& out_data)
+{
+	FILE* file = fopen(file_path.c_str(), "rb");
+	if (file == nullptr)
+		return false;
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	out_data.resize(size > 0 ? size : 0);
+	bool success = size >= 0 && (size == 0 || fread(&out_data[0], 1, size, file) == (size_t)size);
+	fclose(file);
+	return success;
+}
+
+bool WriteWholeFile(const std::string& file_path, const void* data, size_t size)
+{
+	std::string temp_path = file_path + ".tmp";
+	FILE* file = fopen(temp_path.c_str(), "wb");
+	if (file == nullptr)
+		return false;
+	bool success = size == 0 || fwrite(data, 1, size, file) == size;
+	success = fclose(file) == 0 && success;
+	if (!success)
+	{
+		remove(temp_path.c_str());
+		return false;
+	}
+	remove(file_path.c_str());
+	return rename(temp_path.c_str(), file_path.c_str()) == 0;
+}
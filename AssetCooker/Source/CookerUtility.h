@@ -0,0 +1,28 @@
+#ifndef COOKER_UTILITY_H
+#define COOKER_UTILITY_H
+
+#include <string>
+#include <vector>
+
+/******************************************************************************/
+/*!
+\brief
+File helpers shared by the cooker modes
+*/
+/******************************************************************************/
+
+//Every file under directory (recursively) whose name ends in extension, e.g. ".tga"
+void ListFiles(const std::string& directory, const std::string& extension, std::vector<std::string>& out_files);
+
+//Replace the extension of a path, e.g. ("a/b.tga", ".dds") -> "a/b.dds"
+std::string ReplaceExtension(const std::string& file_path, const std::string& extension);
+
+//True if output is missing or older than input
+bool IsOutOfDate(const std::string& output_path, const std::string& input_path);
+
+bool ReadWholeFile(const std::string& file_path, std::vector<unsigned char>& out_data);
+
+//Write to a temporary file and rename it over the target, so readers never see a partial file
+bool WriteWholeFile(const std::string& file_path, const void* data, size_t size);
+
+#endif
@@ -0,0 +1,110 @@
+#include <iostream>
+#include <sstream>
+
+#include "DialogueCooker.h"
+#include "CookerUtility.h"
+#include "DialogueFormat.h"
+
+static const char* TABLE_NAME = "Dialogue.dlg";
+
+static std::string GetFileStem(const std::string& file_path)
+{
+	size_t slash = file_path.find_last_of("/\\");
+	std::string name = slash == std::string::npos ? file_path : file_path.substr(slash + 1);
+	return ReplaceExtension(name, "");
+}
+
+//Append one "S:text" file as a conversation
+static bool CompileConversation(const std::string& file_path, std::vector<DialogueConversation>& conversations,
+	std::vector<DialogueLine>& lines, std::string& text)
+{
+	std::vector<unsigned char> file;
+	if (!ReadWholeFile(file_path, file))
+	{
+		std::cout << "Impossible to open " << file_path << "\n";
+		return false;
+	}
+
+	std::string name = GetFileStem(file_path);
+	DialogueConversation conversation = { (unsigned)text.size(), (unsigned)name.size(), (unsigned)lines.size(), 0 };
+	text += name;
+
+	std::istringstream stream(std::string(file.begin(), file.end()));
+	std::string line;
+	unsigned lineNumber = 0;
+	while (std::getline(stream, line))
+	{
+		++lineNumber;
+		if (!line.empty() && line[line.size() - 1] == '\r')
+			line.erase(line.size() - 1);
+		if (line.empty())
+			continue;
+		if (line.size() < 2 || line[1] != ':')
+		{
+			std::cout << file_path << "(" << lineNumber << "): expected a speaker tag, e.g. \"D:text\"\n";
+			return false;
+		}
+		if (line.size() - 2 > 0xFFFF)
+		{
+			std::cout << file_path << "(" << lineNumber << "): line is too long\n";
+			return false;
+		}
+
+		DialogueLine entry = { (unsigned)text.size(), (unsigned short)(line.size() - 2), line[0], 0 };
+		text.append(line, 2, std::string::npos);
+		lines.push_back(entry);
+		++conversation.lineCount;
+	}
+
+	conversations.push_back(conversation);
+	return true;
+}
+
+int CookDialogue(const std::string& directory, bool force)
+{
+	std::vector<std::string> files;
+	ListFiles(directory, ".txt", files);
+	std::string table_path = directory + "/" + TABLE_NAME;
+
+	bool outOfDate = force || files.empty();
+	for (size_t i = 0; i < files.size() && !outOfDate; ++i)
+	{
+		outOfDate = IsOutOfDate(table_path, files[i]);
+	}
+	if (!outOfDate)
+		return 0;
+
+	int failed = 0;
+	std::vector<DialogueConversation> conversations;
+	std::vector<DialogueLine> lines;
+	std::string text;
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		//a file that fails partway leaves nothing behind in the table
+		size_t lineCount = lines.size();
+		size_t textSize = text.size();
+		if (!CompileConversation(files[i], conversations, lines, text))
+		{
+			lines.resize(lineCount);
+			text.resize(textSize);
+			++failed;
+		}
+	}
+
+	DialogueHeader header = { DIALOGUE_MAGIC, DIALOGUE_VERSION, (unsigned)conversations.size(), (unsigned)lines.size(), (unsigned)text.size() };
+	std::string blob((const char*)&header, sizeof(header));
+	if (!conversations.empty())
+		blob.append((const char*)&conversations[0], conversations.size() * sizeof(DialogueConversation));
+	if (!lines.empty())
+		blob.append((const char*)&lines[0], lines.size() * sizeof(DialogueLine));
+	blob += text;
+
+	if (!WriteWholeFile(table_path, blob.data(), blob.size()))
+	{
+		std::cout << "Could not write " << table_path << "\n";
+		return failed + 1;
+	}
+	std::cout << directory << " -> " << table_path << " (" << conversations.size() << " conversations, "
+		<< lines.size() << " lines)\n";
+	return failed;
+}
@@ -0,0 +1,17 @@
+#ifndef DIALOGUE_COOKER_H
+#define DIALOGUE_COOKER_H
+
+#include <string>
+
+/******************************************************************************/
+/*!
+\brief
+Compile every .txt under a directory into one dialogue table. For "Text" this
+writes Text/Dialogue.dlg, read by DialogueTable at runtime.
+
+\return number of dialogue files that failed to compile
+*/
+/******************************************************************************/
+int CookDialogue(const std::string& directory, bool force);
+
+#endif
@@ -0,0 +1,427 @@
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+
+#include "TextureCooker.h"
+#include "CookerUtility.h"
+#include "DDSFormat.h"
+
+/******************************************************************************/
+/*!
+\brief
+Read a 24/32 bit TGA, uncompressed (type 2) or RLE (type 10), into RGBA8.
+Rows come out bottom-up like LoadTGA uploads them; images stored top-down
+are flipped.
+*/
+/******************************************************************************/
+bool ReadTGA(const std::string& file_path, CookImage& image)
+{
+	std::vector<unsigned char> file;
+	if (!ReadWholeFile(file_path, file) || file.size() < 18)
+	{
+		std::cout << "Impossible to open " << file_path << "\n";
+		return false;
+	}
+
+	const unsigned char* header = &file[0];
+	unsigned idLength = header[0];
+	unsigned imageType = header[2];
+	unsigned bytesPerPixel = header[16] / 8;
+	bool topOrigin = (header[17] & 0x20) != 0;
+	image.width = header[12] + header[13] * 256;
+	image.height = header[14] + header[15] * 256;
+	if (header[1] != 0 || (imageType != 2 && imageType != 10) ||
+		(bytesPerPixel != 3 && bytesPerPixel != 4) || image.width == 0 || image.height == 0)
+	{
+		std::cout << file_path << ": only 24/32 bit true color TGA files are supported\n";
+		return false;
+	}
+
+	unsigned pixelCount = image.width * image.height;
+	image.rgba.resize(pixelCount * 4);
+	const unsigned char* src = &file[0] + 18 + idLength;
+	const unsigned char* end = &file[0] + file.size();
+	unsigned char* dst = &image.rgba[0];
+
+	for (unsigned written = 0; written < pixelCount; )
+	{
+		unsigned runLength = 1;
+		bool repeat = false;
+		if (imageType == 10)
+		{
+			if (src >= end)
+				break;
+			repeat = (*src & 0x80) != 0;
+			runLength = (*src & 0x7F) + 1;
+			++src;
+		}
+		else
+		{
+			runLength = pixelCount;
+		}
+		if (runLength > pixelCount - written)
+			runLength = pixelCount - written;
+
+		for (unsigned i = 0; i < runLength; ++i)
+		{
+			if (src + bytesPerPixel > end)
+			{
+				std::cout << file_path << " is truncated\n";
+				return false;
+			}
+			dst[0] = src[2];
+			dst[1] = src[1];
+			dst[2] = src[0];
+			dst[3] = bytesPerPixel == 4 ? src[3] : 255;
+			dst += 4;
+			if (!repeat || i + 1 == runLength)
+				src += bytesPerPixel;
+		}
+		written += runLength;
+	}
+
+	if (topOrigin)
+	{
+		unsigned rowBytes = image.width * 4;
+		std::vector<unsigned char> row(rowBytes);
+		for (unsigned y = 0; y < image.height / 2; ++y)
+		{
+			unsigned char* a = &image.rgba[y * rowBytes];
+			unsigned char* b = &image.rgba[(image.height - 1 - y) * rowBytes];
+			memcpy(&row[0], a, rowBytes);
+			memcpy(a, b, rowBytes);
+			memcpy(b, &row[0], rowBytes);
+		}
+	}
+	return true;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Write RGBA8 pixels as an uncompressed 32 bit TGA with bottom-left origin
+*/
+/******************************************************************************/
+bool WriteTGA(const std::string& file_path, const CookImage& image)
+{
+	std::vector<unsigned char> file(18 + image.rgba.size());
+	file[2] = 2;
+	file[12] = image.width & 0xff;
+	file[13] = (image.width >> 8) & 0xff;
+	file[14] = image.height & 0xff;
+	file[15] = (image.height >> 8) & 0xff;
+	file[16] = 32;
+	file[17] = 8; //alpha bits
+
+	for (size_t i = 0; i < image.rgba.size(); i += 4)
+	{
+		file[18 + i + 0] = image.rgba[i + 2];
+		file[18 + i + 1] = image.rgba[i + 1];
+		file[18 + i + 2] = image.rgba[i + 0];
+		file[18 + i + 3] = image.rgba[i + 3];
+	}
+
+	if (!WriteWholeFile(file_path, &file[0], file.size()))
+	{
+		std::cout << "Could not write " << file_path << "\n";
+		return false;
+	}
+	return true;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Build the full mip chain down to 1x1 with a 2x2 box filter. Level 0 is a copy
+of the source image.
+*/
+/******************************************************************************/
+void BuildMipChain(const CookImage& image, std::vector<CookImage>& out_levels)
+{
+	out_levels.clear();
+	out_levels.push_back(image);
+	while (out_levels.back().width > 1 || out_levels.back().height > 1)
+	{
+		const CookImage& src = out_levels.back();
+		CookImage dst;
+		dst.width = src.width > 1 ? src.width / 2 : 1;
+		dst.height = src.height > 1 ? src.height / 2 : 1;
+		dst.rgba.resize(dst.width * dst.height * 4);
+
+		for (unsigned y = 0; y < dst.height; ++y)
+		{
+			unsigned y0 = y * 2;
+			unsigned y1 = y0 + 1 < src.height ? y0 + 1 : y0;
+			for (unsigned x = 0; x < dst.width; ++x)
+			{
+				unsigned x0 = x * 2;
+				unsigned x1 = x0 + 1 < src.width ? x0 + 1 : x0;
+				for (unsigned c = 0; c < 4; ++c)
+				{
+					unsigned sum = src.rgba[(y0 * src.width + x0) * 4 + c] + src.rgba[(y0 * src.width + x1) * 4 + c] +
+						src.rgba[(y1 * src.width + x0) * 4 + c] + src.rgba[(y1 * src.width + x1) * 4 + c];
+					dst.rgba[(y * dst.width + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+		out_levels.push_back(dst);
+	}
+}
+
+static unsigned short PackRGB565(const unsigned char* rgb)
+{
+	return (unsigned short)(((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3));
+}
+
+static void UnpackRGB565(unsigned short color, int* rgb)
+{
+	int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Encode the colour of a 4x4 block as a BC1 block in 4-colour mode: the two
+endpoints are the block's colour bounding box inset by 1/16, and every texel
+picks the nearest of the four palette entries.
+
+\param block - 16 RGBA texels, row by row
+\param out - 8 bytes
+*/
+/******************************************************************************/
+static void CompressColorBlock(const unsigned char* block, unsigned char* out)
+{
+	unsigned char minColor[3] = { 255, 255, 255 }, maxColor[3] = { 0, 0, 0 };
+	for (int i = 0; i < 16; ++i)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			if (block[i * 4 + c] < minColor[c]) minColor[c] = block[i * 4 + c];
+			if (block[i * 4 + c] > maxColor[c]) maxColor[c] = block[i * 4 + c];
+		}
+	}
+	for (int c = 0; c < 3; ++c)
+	{
+		int inset = (maxColor[c] - minColor[c]) >> 4;
+		minColor[c] = (unsigned char)(minColor[c] + inset);
+		maxColor[c] = (unsigned char)(maxColor[c] - inset);
+	}
+
+	unsigned short color0 = PackRGB565(maxColor);
+	unsigned short color1 = PackRGB565(minColor);
+	if (color0 < color1)
+	{
+		unsigned short swap = color0;
+		color0 = color1;
+		color1 = swap;
+	}
+
+	unsigned indices = 0;
+	if (color0 != color1)
+	{
+		int palette[4][3];
+		UnpackRGB565(color0, palette[0]);
+		UnpackRGB565(color1, palette[1]);
+		for (int c = 0; c < 3; ++c)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		for (int i = 0; i < 16; ++i)
+		{
+			int best = 0, bestDistance = 0x7FFFFFFF;
+			for (int p = 0; p < 4; ++p)
+			{
+				int dr = block[i * 4] - palette[p][0];
+				int dg = block[i * 4 + 1] - palette[p][1];
+				int db = block[i * 4 + 2] - palette[p][2];
+				int distance = dr * dr + dg * dg + db * db;
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					best = p;
+				}
+			}
+			indices |= (unsigned)best << (i * 2);
+		}
+	}
+
+	out[0] = (unsigned char)(color0 & 0xFF);
+	out[1] = (unsigned char)(color0 >> 8);
+	out[2] = (unsigned char)(color1 & 0xFF);
+	out[3] = (unsigned char)(color1 >> 8);
+	memcpy(out + 4, &indices, 4);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Encode the alpha of a 4x4 block as a BC3 alpha block in 8-value mode between
+the block's minimum and maximum alpha
+
+\param block - 16 RGBA texels, row by row
+\param out - 8 bytes
+*/
+/******************************************************************************/
+static void CompressAlphaBlock(const unsigned char* block, unsigned char* out)
+{
+	int minAlpha = 255, maxAlpha = 0;
+	for (int i = 0; i < 16; ++i)
+	{
+		if (block[i * 4 + 3] < minAlpha) minAlpha = block[i * 4 + 3];
+		if (block[i * 4 + 3] > maxAlpha) maxAlpha = block[i * 4 + 3];
+	}
+
+	unsigned long long indices = 0;
+	if (maxAlpha != minAlpha)
+	{
+		int palette[8];
+		palette[0] = maxAlpha;
+		palette[1] = minAlpha;
+		for (int p = 2; p < 8; ++p)
+		{
+			palette[p] = ((8 - p) * maxAlpha + (p - 1) * minAlpha) / 7;
+		}
+		for (int i = 0; i < 16; ++i)
+		{
+			int best = 0, bestDistance = 256;
+			for (int p = 0; p < 8; ++p)
+			{
+				int distance = abs(block[i * 4 + 3] - palette[p]);
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					best = p;
+				}
+			}
+			indices |= (unsigned long long)best << (i * 3);
+		}
+	}
+
+	out[0] = (unsigned char)maxAlpha;
+	out[1] = (unsigned char)minAlpha;
+	for (int i = 0; i < 6; ++i)
+	{
+		out[2 + i] = (unsigned char)(indices >> (i * 8));
+	}
+}
+
+//Append one mip level as BC1 (8 byte) or BC3 (16 byte) blocks
+static void CompressLevel(const CookImage& level, bool hasAlpha, std::vector<unsigned char>& out)
+{
+	unsigned char block[16 * 4];
+	unsigned char encoded[16];
+	for (unsigned by = 0; by < level.height; by += 4)
+	{
+		for (unsigned bx = 0; bx < level.width; bx += 4)
+		{
+			//edge blocks repeat the last row/column
+			for (unsigned y = 0; y < 4; ++y)
+			{
+				unsigned sy = by + y < level.height ? by + y : level.height - 1;
+				for (unsigned x = 0; x < 4; ++x)
+				{
+					unsigned sx = bx + x < level.width ? bx + x : level.width - 1;
+					memcpy(&block[(y * 4 + x) * 4], &level.rgba[(sy * level.width + sx) * 4], 4);
+				}
+			}
+
+			if (hasAlpha)
+			{
+				CompressAlphaBlock(block, encoded);
+				CompressColorBlock(block, encoded + 8);
+				out.insert(out.end(), encoded, encoded + 16);
+			}
+			else
+			{
+				CompressColorBlock(block, encoded);
+				out.insert(out.end(), encoded, encoded + 8);
+			}
+		}
+	}
+}
+
+/******************************************************************************/
+/*!
+\brief
+Convert a TGA to a DDS with a full mip chain. Images whose alpha is fully
+opaque become DXT1 (BC1), the rest DXT5 (BC3).
+
+\return false if the TGA could not be read or the DDS could not be written
+*/
+/******************************************************************************/
+bool CookTexture(const std::string& tga_path, const std::string& dds_path)
+{
+	CookImage image;
+	if (!ReadTGA(tga_path, image))
+		return false;
+
+	bool hasAlpha = false;
+	for (size_t i = 3; i < image.rgba.size() && !hasAlpha; i += 4)
+	{
+		hasAlpha = image.rgba[i] != 255;
+	}
+	unsigned blockBytes = hasAlpha ? 16 : 8;
+
+	std::vector<CookImage> levels;
+	BuildMipChain(image, levels);
+
+	DDSHeader header;
+	memset(&header, 0, sizeof(header));
+	header.size = sizeof(DDSHeader);
+	header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+	header.height = image.height;
+	header.width = image.width;
+	header.pitchOrLinearSize = DDSLevelSize(image.width, image.height, blockBytes);
+	header.mipMapCount = (unsigned)levels.size();
+	header.pixelFormat.size = sizeof(DDSPixelFormat);
+	header.pixelFormat.flags = DDPF_FOURCC;
+	header.pixelFormat.fourCC = hasAlpha ? DDS_FOURCC_DXT5 : DDS_FOURCC_DXT1;
+	header.caps = DDSCAPS_COMPLEX | DDSCAPS_TEXTURE | DDSCAPS_MIPMAP;
+
+	std::vector<unsigned char> file(sizeof(DDS_MAGIC) + sizeof(header));
+	memcpy(&file[0], &DDS_MAGIC, sizeof(DDS_MAGIC));
+	memcpy(&file[sizeof(DDS_MAGIC)], &header, sizeof(header));
+	for (size_t i = 0; i < levels.size(); ++i)
+	{
+		CompressLevel(levels[i], hasAlpha, file);
+	}
+
+	if (!WriteWholeFile(dds_path, &file[0], file.size()))
+	{
+		std::cout << "Could not write " << dds_path << "\n";
+		return false;
+	}
+	std::cout << tga_path << " -> " << dds_path << " (" << (hasAlpha ? "DXT5" : "DXT1") << ", "
+		<< levels.size() << " levels, " << file.size() / 1024 << " KB)\n";
+	return true;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Cook every TGA under directory into a DDS next to it. Textures whose DDS is
+newer than the TGA are skipped unless force is set.
+
+\return number of textures that failed to cook
+*/
+/******************************************************************************/
+int CookTextures(const std::string& directory, bool force)
+{
+	std::vector<std::string> files;
+	ListFiles(directory, ".tga", files);
+
+	int failed = 0;
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		std::string dds_path = ReplaceExtension(files[i], ".dds");
+		if (!force && !IsOutOfDate(dds_path, files[i]))
+			continue;
+		if (!CookTexture(files[i], dds_path))
+			++failed;
+	}
+	return failed;
+}
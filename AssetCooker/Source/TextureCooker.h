@@ -0,0 +1,26 @@
+#ifndef TEXTURE_COOKER_H
+#define TEXTURE_COOKER_H
+
+#include <string>
+#include <vector>
+
+/******************************************************************************/
+/*!
+		Struct CookImage:
+\brief	RGBA8 pixels, rows bottom-up (OpenGL order)
+*/
+/******************************************************************************/
+struct CookImage
+{
+	unsigned width, height;
+	std::vector<unsigned char> rgba;
+};
+
+bool ReadTGA(const std::string& file_path, CookImage& image);
+bool WriteTGA(const std::string& file_path, const CookImage& image);
+void BuildMipChain(const CookImage& image, std::vector<CookImage>& out_levels);
+
+bool CookTexture(const std::string& tga_path, const std::string& dds_path);
+int CookTextures(const std::string& directory, bool force);
+
+#endif
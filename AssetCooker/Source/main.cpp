@@ -0,0 +1,60 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+
+#include "TextureCooker.h"
+#include "AtlasCooker.h"
+#include "DialogueCooker.h"
+
+static void PrintUsage()
+{
+	std::cout << "Usage: AssetCooker <mode> <path> [-f]\n"
+		<< "  textures <dir>   convert every .tga under dir to a DXT1/DXT5 .dds with mipmaps\n"
+		<< "  atlas <list>     pack the .tga files named in list into atlas pages and a .atlas UV table\n"
+		<< "  dialogue <dir>   compile every .txt under dir into the string table dir/Dialogue.dlg\n"
+		<< "  -f               cook everything, even files that are up to date\n";
+}
+
+/******************************************************************************/
+/*!
+\brief
+Offline asset cook step, run as a post-build event of the AssetCooker project
+
+\return 0 if everything cooked, 1 otherwise
+*/
+/******************************************************************************/
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	std::string mode = argv[1];
+	std::string path = argv[2];
+	bool force = argc > 3 && strcmp(argv[3], "-f") == 0;
+
+	int failed = 0;
+	if (mode == "textures")
+	{
+		failed = CookTextures(path, force);
+	}
+	else if (mode == "atlas")
+	{
+		failed = CookAtlas(path, force);
+	}
+	else if (mode == "dialogue")
+	{
+		failed = CookDialogue(path, force);
+	}
+	else
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (failed > 0)
+		std::cout << failed << " asset(s) failed to cook\n";
+	return failed > 0 ? 1 : 0;
+}